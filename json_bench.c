@@ -0,0 +1,130 @@
+// # 업링크 배치 JSON 직렬화 벤치마크: json-c 경로와 batch_json_encode 비교
+// # 두 경로의 출력이 바이트 단위로 같은지도 확인 (다르면 종료 코드 1)
+
+// # 컴파일
+// make json_bench
+
+// # 실행 (인자: 반복 횟수, 배치당 레코드 수)
+// ./json_bench 20000 32
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <json-c/json.h>
+#include "batch_json.h"
+
+#define MAX_RECORDS 64
+
+// 데몬이 직렬화기를 바꾸기 전에 쓰던 json-c 인코딩 (비교 기준)
+static struct json_object* encode_with_json_c(const WireRecord* records, int count) {
+    int64_t base_ts = records[0].timestamp_us;
+    for (int i = 1; i < count; i++) {
+        if (records[i].timestamp_us < base_ts) {
+            base_ts = records[i].timestamp_us;
+        }
+    }
+
+    struct json_object* frame = json_object_new_object();
+    struct json_object* items = json_object_new_array();
+
+    json_object_object_add(frame, "type", json_object_new_string("batch"));
+    json_object_object_add(frame, "base_ts", json_object_new_int64(base_ts));
+
+    for (int i = 0; i < count; i++) {
+        struct json_object* item = json_object_new_object();
+        json_object_object_add(item, "table", json_object_new_string(protocol_kind_table(records[i].kind)));
+        json_object_object_add(item, "dt", json_object_new_int64(records[i].timestamp_us - base_ts));
+        json_object_object_add(item, "sensor_id", json_object_new_int(records[i].sensor_id));
+        json_object_object_add(item, protocol_kind_field(records[i].kind), json_object_new_double(records[i].value));
+        json_object_object_add(item, "voltage", json_object_new_double(records[i].voltage));
+        json_object_object_add(item, "quality", json_object_new_int(records[i].quality));
+        json_object_array_add(items, item);
+    }
+
+    json_object_object_add(frame, "readings", items);
+    return frame;
+}
+
+static void fill_records(WireRecord* records, int count, unsigned int* seed) {
+    int64_t now = (int64_t)time(NULL) * 1000000;
+    for (int i = 0; i < count; i++) {
+        records[i].channel = i % 13;
+        records[i].kind = rand_r(seed) % SENSOR_KIND_COUNT;
+        records[i].sensor_id = rand_r(seed) % 8;
+        records[i].quality = rand_r(seed) % 8;
+        records[i].timestamp_us = now + (rand_r(seed) % 2000000) - 1000000;
+
+        // 정수값, 음수, 아주 작은/큰 값, 0 등 출력 형식이 갈리는 경우를 섞음
+        switch (rand_r(seed) % 6) {
+        case 0: records[i].value = (float)(rand_r(seed) % 100); break;
+        case 1: records[i].value = -(float)rand_r(seed) / RAND_MAX; break;
+        case 2: records[i].value = (float)rand_r(seed) / RAND_MAX * 1e-6f; break;
+        case 3: records[i].value = (float)rand_r(seed) * 1e10f; break;
+        case 4: records[i].value = 0.0f; break;
+        default: records[i].value = (float)rand_r(seed) / RAND_MAX * 14.0f; break;
+        }
+        records[i].voltage = (float)rand_r(seed) / RAND_MAX * 3.3f;
+    }
+}
+
+static double elapsed_ns(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) * 1e9 + (b->tv_nsec - a->tv_nsec);
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    int count = argc > 2 ? atoi(argv[2]) : 32;
+    static WireRecord records[MAX_RECORDS];
+    static char buf[BATCH_JSON_MAX_OVERHEAD + MAX_RECORDS * BATCH_JSON_MAX_RECORD];
+    unsigned int seed = 1;
+
+    if (count < 1 || count > MAX_RECORDS || iterations < 1) {
+        fprintf(stderr, "usage: %s [iterations] [records per batch, 1-%d]\n", argv[0], MAX_RECORDS);
+        return 2;
+    }
+
+    // 호환성: 무작위 배치로 두 출력 비교
+    for (int i = 0; i < 1000; i++) {
+        fill_records(records, count, &seed);
+        struct json_object* frame = encode_with_json_c(records, count);
+        const char* expected = json_object_to_json_string(frame);
+        size_t len = batch_json_encode(buf, sizeof(buf), records, count);
+
+        if (len != strlen(expected) || memcmp(buf, expected, len) != 0) {
+            printf("출력 불일치:\n json-c: %s\n batch_json: %s\n", expected, buf);
+            json_object_put(frame);
+            return 1;
+        }
+        json_object_put(frame);
+    }
+    printf("호환성: 1000개 배치 모두 json-c 출력과 동일\n");
+
+    // 속도
+    struct timespec t0, t1;
+    size_t total = 0;
+
+    fill_records(records, count, &seed);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < iterations; i++) {
+        struct json_object* frame = encode_with_json_c(records, count);
+        total += strlen(json_object_to_json_string(frame));
+        json_object_put(frame);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double json_c_ns = elapsed_ns(&t0, &t1) / iterations;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < iterations; i++) {
+        total += batch_json_encode(buf, sizeof(buf), records, count);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double direct_ns = elapsed_ns(&t0, &t1) / iterations;
+
+    printf("배치 %d건, %d회 반복 (출력 합계 %zu bytes)\n", count, iterations, total);
+    printf("  json-c:     %10.0f ns/배치 (%6.0f ns/레코드)\n", json_c_ns, json_c_ns / count);
+    printf("  batch_json: %10.0f ns/배치 (%6.0f ns/레코드)\n", direct_ns, direct_ns / count);
+    printf("  %.1f배 빠름\n", json_c_ns / direct_ns);
+    return 0;
+}
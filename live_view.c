@@ -0,0 +1,130 @@
+// # UDP 최신값 채널 수신기: 데몬의 "live" 스냅샷을 받아 채널별 최신값과 손실/지연을 출력
+// # 대시보드나 펌프 제어가 최신값 채널을 받는 방법의 예시이기도 함
+
+// # 컴파일
+// make live_view
+
+// # 실행 (인자: 주소, 포트 — 데몬 설정의 live.address / live.port와 같게)
+// ./live_view 239.255.87.77 8081
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+
+#define MAX_NODES 16
+
+// 노드별 수신 상태 (seq로 손실/순서 뒤바뀜 판단)
+typedef struct {
+    uint32_t node_id;
+    uint32_t last_seq;
+    unsigned long received;
+    unsigned long lost;
+    unsigned long stale;
+} NodeState;
+
+static NodeState nodes[MAX_NODES];
+static int node_count = 0;
+
+static NodeState* find_node(uint32_t node_id) {
+    for (int i = 0; i < node_count; i++) {
+        if (nodes[i].node_id == node_id) {
+            return &nodes[i];
+        }
+    }
+    if (node_count == MAX_NODES) {
+        return NULL;
+    }
+    nodes[node_count].node_id = node_id;
+    return &nodes[node_count++];
+}
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char* argv[]) {
+    const char* address = argc > 1 ? argv[1] : "239.255.87.77";
+    int port = argc > 2 ? atoi(argv[2]) : 8081;
+    struct in_addr group;
+
+    if (inet_pton(AF_INET, address, &group) <= 0) {
+        fprintf(stderr, "usage: %s [address] [port]\n", argv[0]);
+        return 2;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    if (IN_MULTICAST(ntohl(group.s_addr))) {
+        struct ip_mreq mreq = { .imr_multiaddr = group, .imr_interface.s_addr = htonl(INADDR_ANY) };
+        if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            perror("IP_ADD_MEMBERSHIP");
+            return 1;
+        }
+    }
+    printf("Listening for live values on %s:%d\n", address, port);
+
+    uint8_t packet[PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_PAYLOAD];
+    WireRecord records[PROTOCOL_MAX_RECORDS];
+    for (;;) {
+        ssize_t n = recv(sock, packet, sizeof(packet), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("recv");
+            return 1;
+        }
+
+        FrameHeader header;
+        uint32_t node_id, seq;
+        if (n < PROTOCOL_HEADER_SIZE || !protocol_parse_header(packet, &header) ||
+            header.type != FRAME_LIVE || header.length != (uint32_t)(n - PROTOCOL_HEADER_SIZE)) {
+            continue;
+        }
+        int count = protocol_decode_live(packet + PROTOCOL_HEADER_SIZE, header.length, &node_id, &seq,
+                                         records, PROTOCOL_MAX_RECORDS);
+        NodeState* node = find_node(node_id);
+        if (count <= 0 || !node) {
+            continue;
+        }
+
+        // 이전보다 오래된 스냅샷은 버림 (seq가 크게 작아졌으면 노드 재시작으로 보고 새로 시작)
+        int32_t diff = (int32_t)(seq - node->last_seq);
+        if (node->received > 0 && diff <= 0 && diff > -1000) {
+            node->stale++;
+            continue;
+        }
+        if (node->received > 0 && diff > 1) {
+            node->lost += diff - 1;
+        }
+        node->last_seq = seq;
+        node->received++;
+
+        printf("node %u seq %u (lost %lu, stale %lu), age %.1f ms\n", node_id, seq, node->lost, node->stale,
+               (now_us() - records[0].timestamp_us) / 1000.0);
+        for (int i = 0; i < count; i++) {
+            printf("  ch %2d %-12s #%d  %10.3f  (%.3f V, quality 0x%x)\n", records[i].channel,
+                   protocol_kind_table(records[i].kind) ? protocol_kind_table(records[i].kind) : "?",
+                   records[i].sensor_id, records[i].value, records[i].voltage, records[i].quality);
+        }
+        fflush(stdout);
+    }
+}
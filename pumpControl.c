@@ -1,8 +1,8 @@
 // # 필요한 라이브러리 설치
 // sudo apt-get install libcurl4-openssl-dev libjson-c-dev wiringpi
 
-// # 컴파일
-// gcc -o pumpControl pumpControl.c -lwiringPi -lsqlite3
+// # 컴파일 (pH 값은 water_monitor 데몬의 공유 메모리에서 읽음, make로 libwm_reader.a 먼저 빌드)
+// gcc -o pumpControl pumpControl.c -I./src -L. -lwm_reader -lwiringPi -lrt
 
 // # 실행
 // sudo ./pumpControl
@@ -17,7 +17,7 @@
 #include <string.h>
 #include <curl/curl.h>
 #include <json-c/json.h>
-#include <sqlite3.h>
+#include "wm_reader.h"
 
 #define SPI_CHANNEL 0
 #define SPI_SPEED 1350000
@@ -34,7 +34,8 @@
 #define TARGET_PH 7.0        // 목표 pH 값
 #define PH_MIN 6.5          // 최소 허용 pH
 #define PH_MAX 7.5          // 최대 허용 pH
-#define DB_PATH "/path/to/your/database.db"  // SQLite DB 경로
+#define PH_WAIT_TIMEOUT_MS 1000  // 새 pH 샘플 대기 최대 시간
+#define PH_MAX_AGE_MS 10000      // 이보다 오래된 pH 샘플로는 펌프를 켜지 않음 (데몬 측정 주기 3초의 몇 배)
 
 static int running = 1;
 
@@ -67,28 +68,56 @@ static size_t WriteMemoryCallback(void *contents, size_t size, size_t nmemb, voi
     return realsize;
 }
 
-// pH 측정값 가져오기
-double fetch_current_ph() {
-    sqlite3 *db;
-    sqlite3_stmt *stmt;
-    double current_ph = 7.0;  // 기본값
-    
-    if (sqlite3_open(DB_PATH, &db) != SQLITE_OK) {
-        printf("데이터베이스 열기 실패: %s\n", sqlite3_errmsg(db));
-        return current_ph;
+// water_monitor 공유 메모리 리더
+static WmReader* reader = NULL;
+static int ph_channel = -1;
+
+static bool open_reader() {
+    if (reader) return true;
+
+    reader = wm_reader_open(NULL);
+    if (!reader) {
+        printf("공유 메모리 열기 실패: water_monitor 데몬 실행 여부 확인\n");
+        return false;
     }
-    
-    const char *sql = "SELECT ph_value FROM ph_measurements ORDER BY timestamp DESC LIMIT 1;";
-    
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            current_ph = sqlite3_column_double(stmt, 0);
-        }
-        sqlite3_finalize(stmt);
+    ph_channel = wm_reader_find_channel(reader, "ph");
+    return true;
+}
+
+// pH 측정값 가져오기 (DB 조회 대신 데몬의 최신값을 공유 메모리에서 바로 읽음)
+// 유효하고 최근에 측정된 값이 없으면 false
+bool fetch_current_ph(double* current_ph) {
+    WmSample sample;
+
+    if (!open_reader()) {
+        return false;
     }
-    
-    sqlite3_close(db);
-    return current_ph;
+
+    if (!wm_reader_get(reader, ph_channel, &sample) || !(sample.quality & WM_QUALITY_VALID)) {
+        return false;
+    }
+    int64_t age_ms = wm_reader_sample_age_ms(&sample);
+    if (age_ms > PH_MAX_AGE_MS) {
+        printf("pH 샘플이 %lld ms 전 값: 데몬 또는 센서 확인\n", (long long)age_ms);
+        return false;
+    }
+    *current_ph = sample.value;
+    return true;
+}
+
+// 새 pH 샘플이 올 때까지 대기 (데몬이 재시작되면 다시 연결)
+void wait_for_new_sample(uint32_t* last_seq) {
+    if (!open_reader()) {
+        sleep(1);
+        return;
+    }
+
+    if (wm_reader_wait(reader, *last_seq, PH_WAIT_TIMEOUT_MS) == WM_WAIT_CLOSED) {
+        wm_reader_close(reader);
+        reader = NULL;
+        return;
+    }
+    *last_seq = wm_reader_update_seq(reader);
 }
 
 // 이동 평균 필터 초기화
@@ -153,9 +182,17 @@ int main() {
 
     printf("pH 모니터링 및 펌프 제어 시작... Ctrl+C로 종료\n");
 
+    uint32_t last_seq = 0;
     while (running) {
-        // pH 측정값 가져오기
-        double phValue = fetch_current_ph();
+        // pH 측정값 가져오기 (오래된 값으로 펌프를 돌리지 않도록 최신값이 없으면 끄고 평균도 다시 시작)
+        double phValue;
+        if (!fetch_current_ph(&phValue)) {
+            digitalWrite(PUMPS_RELAY_PIN, LOW);
+            initMovingAverage(&phFilter);
+            printf("최신 pH 값 없음 - 펌프 정지\n");
+            wait_for_new_sample(&last_seq);
+            continue;
+        }
         double smoothedPH = addToMovingAverage(&phFilter, phValue);
 
         // 상태 결정 및 펌프 제어
@@ -175,11 +212,12 @@ int main() {
         // 상태 출력
         printf("pH: %.2f, 상태: %s\n", smoothedPH, water_status);
         
-        sleep(1);
+        wait_for_new_sample(&last_seq);
     }
 
     // 종료 시 펌프 끄기
     digitalWrite(PUMPS_RELAY_PIN, LOW);
+    wm_reader_close(reader);
     printf("\n종료...\n");
     return 0;
 }
\ No newline at end of file
@@ -1,146 +1,1286 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <sqlite3.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
-#include <json-c/json.h>
-
-#define PORT 8080
-#define BUFFER_SIZE 1024
-
-void initialize_database();
-void save_to_database(const char *json_data);
-void start_server();
-
-int main() {
-    initialize_database();
-    start_server();
-    return 0;
-}
-
-// SQLite 데이터베이스 초기화
-void initialize_database() {
-    sqlite3 *db;
-    char *err_msg = NULL;
-
-    int rc = sqlite3_open("sensor_data.db", &db);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        exit(1);
-    }
-
-    const char *sql = 
-        "CREATE TABLE IF NOT EXISTS tb_ph ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-        "timestamp TEXT, "
-        "sensor_id TEXT, "
-        "location TEXT, "
-        "pH_value REAL, "
-        "voltage REAL);";
-
-    rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to create table: %s\n", err_msg);
-        sqlite3_free(err_msg);
-        sqlite3_close(db);
-        exit(1);
-    }
-
-    sqlite3_close(db);
-}
-
-// 서버 소켓 설정 및 실행
-void start_server() {
-    int server_fd, new_socket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
-    char buffer[BUFFER_SIZE] = {0};
-
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
-        perror("Socket failed");
-        exit(1);
-    }
-
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
-
-    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
-        perror("Bind failed");
-        close(server_fd);
-        exit(1);
-    }
-
-    if (listen(server_fd, 3) < 0) {
-        perror("Listen failed");
-        close(server_fd);
-        exit(1);
-    }
-
-    printf("Server is listening on port %d\n", PORT);
-
-    while (1) {
-        if ((new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t *)&addrlen)) < 0) {
-            perror("Accept failed");
-            continue;
-        }
-
-        int bytes_read = read(new_socket, buffer, BUFFER_SIZE);
-        if (bytes_read > 0) {
-            printf("Received data: %s\n", buffer);
-            save_to_database(buffer);
-        }
-
-        close(new_socket);
-        memset(buffer, 0, BUFFER_SIZE);
-    }
-}
-
-// 데이터베이스에 JSON 데이터 저장
-void save_to_database(const char *json_data) {
-    sqlite3 *db;
-    char *err_msg = NULL;
-
-    int rc = sqlite3_open("sensor_data.db", &db);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
-        sqlite3_close(db);
-        return;
-    }
-
-    // JSON 데이터 파싱
-    struct json_object *parsed_json;
-    struct json_object *timestamp, *sensor_id, *location, *pH_value, *voltage;
-
-    parsed_json = json_tokener_parse(json_data);
-    json_object_object_get_ex(parsed_json, "timestamp", &timestamp);
-    json_object_object_get_ex(parsed_json, "sensor_id", &sensor_id);
-    json_object_object_get_ex(parsed_json, "location", &location);
-    json_object_object_get_ex(parsed_json, "pH_value", &pH_value);
-    json_object_object_get_ex(parsed_json, "voltage", &voltage);
-
-    // SQL INSERT 명령 실행
-    const char *sql_template = 
-        "INSERT INTO tb_ph (timestamp, sensor_id, location, pH_value, voltage) "
-        "VALUES ('%s', '%s', '%s', %.1f, %.2f);";
-    char sql[512];
-    snprintf(sql, sizeof(sql), sql_template, 
-             json_object_get_string(timestamp), 
-             json_object_get_string(sensor_id), 
-             json_object_get_string(location), 
-             json_object_get_double(pH_value), 
-             json_object_get_double(voltage));
-
-    rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "Failed to insert data: %s\n", err_msg);
-        sqlite3_free(err_msg);
-    } else {
-        printf("Data inserted successfully: %s\n", json_data);
-    }
-
-    sqlite3_close(db);
-}
\ No newline at end of file
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sqlite3.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <errno.h>
+#include <json-c/json.h>
+#include <time.h>
+#include <sys/time.h>
+#include "protocol.h"
+
+#define PORT 8080
+// 이 시간 동안 아무것도 오지 않은 연결은 닫음 (데몬은 연결을 유지하고 끊기면 다시 연결)
+#define CONNECTION_IDLE_SECONDS 300
+// 동시 연결 수 상한: 넘으면 받자마자 닫음 (노드는 백오프 후 다시 연결)
+#define MAX_CONNECTIONS 4096
+#define LISTEN_BACKLOG 512
+// 이벤트 한 번에 읽는 양 (그 안에 들어온 프레임/줄은 모두 처리하고, 남은 바이트는 다음 이벤트에)
+#define CONNECTION_READ_SIZE 16384
+// 처리할 바이트가 남지 않았을 때 이보다 큰 읽기 버퍼는 놓음 (조용한 연결이 메모리를 잡고 있지 않도록)
+#define CONNECTION_BUFFER_KEEP 4096
+// 기존 JSON 클라이언트의 문서 한 건 최대 크기 (넘도록 개행이 없으면 연결을 닫음)
+#define MAX_JSON_DOCUMENT 16384
+// 묶음 커밋: 첫 행 뒤 이 시간이 지나거나 이만큼 행이 쌓이면 커밋 (확인 응답은 커밋 뒤라 그만큼 늦어짐)
+#define GROUP_COMMIT_MS 5
+#define GROUP_COMMIT_ROWS 2000
+// 노드의 시계 오프셋이 이만큼 바뀌면 출력
+#define CLOCK_REPORT_THRESHOLD_US 1000
+// 같은 DB를 쓰는 다른 서버가 쓰기 잠금을 잡고 있으면 이만큼 기다림 (묶음 커밋 하나는 그보다 훨씬 짧음)
+#define DB_BUSY_TIMEOUT_MS 5000
+
+// 배치 프레임의 테이블별 값 필드와 DB 컬럼 (허용된 테이블만 INSERT)
+static const struct {
+    const char *table;
+    const char *field;
+    const char *column;
+} reading_tables[] = {
+    { "tb_water_level", "water_level", "water_level" },
+    { "tb_ph", "ph_value", "pH_value" },
+    { "tb_water_temperature", "temperature", "temperature" },
+    { "tb_conductivity", "conductivity", "conductivity" },
+    { "tb_illuminance", "illuminance", "illuminance" },
+};
+#define NUM_READING_TABLES (sizeof(reading_tables) / sizeof(reading_tables[0]))
+
+// 데몬의 READING_QUALITY_DEADBAND: 예외 보고 모드로 보낸 행 (다음 행까지 값이 유지됨)
+// 이런 행은 step_held = 1로 저장. 계단형 시계열 복원은 시각 T의 값 = T 이전의 마지막 행:
+//   SELECT water_level FROM tb_water_level WHERE sensor_id = '0' AND timestamp <= :t
+//   ORDER BY timestamp DESC LIMIT 1;
+// step_held = 0인 행은 기존처럼 그 시각의 표본이므로 보간해도 됨
+#define QUALITY_DEADBAND (1u << 3)
+
+// 데몬의 READING_QUALITY_ALARM_*: 경보 상태가 바뀐 측정값은 tb_alert에도 기록
+#define QUALITY_ALARM_LOW (1u << 5)
+#define QUALITY_ALARM_HIGH (1u << 6)
+#define QUALITY_ALARM_CHANGE (1u << 7)
+
+// 확인 응답을 협상한 세션의 데이터 프레임: 데이터와 같은 트랜잭션으로 노드의 high-water mark를 올림
+typedef struct {
+    uint32_t node_id;
+    uint64_t seq;
+} FrameSeq;
+
+// 프레임 세션 상태 (확인 응답을 쓰면 노드의 high-water mark 이하 seq는 재전송이므로 저장하지 않음)
+typedef struct {
+    uint32_t node_id;
+    int greeted;                // HELLO를 마침
+    int acks;
+    uint64_t high_water;        // 이 노드에서 커밋한 마지막 seq
+    unsigned long duplicates;
+    int clock;                  // 데이터 프레임에 노드의 시계 오프셋이 붙음
+    int64_t clock_offset_us;    // 마지막으로 알린 오프셋 (서버 시각 - 노드 시각)
+} Session;
+
+// 첫 바이트들로 정함: 프로토콜 매직이면 프레임 세션, 아니면 기존 JSON
+enum { CONNECTION_UNKNOWN, CONNECTION_FRAMED, CONNECTION_JSON };
+
+// 연결마다 읽은 바이트를 모아 둠 (이벤트가 올 때 와 있는 만큼만 읽고 블록하지 않음)
+// buf[start, len)이 아직 처리하지 않은 부분: 완성된 프레임/줄은 버퍼 안을 가리킨 채 처리하고 (복사 없음)
+// 읽다 만 나머지만 이벤트 끝에 앞으로 당김
+typedef struct {
+    int sock;                   // -1이면 빈 칸
+    int mode;
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    size_t start;
+    size_t scan;                // JSON: 여기까지는 개행이 없음 (다시 찾지 않음)
+    size_t want;                // 프레임: 읽다 만 프레임 전체 크기 (버퍼를 미리 그만큼 늘림)
+    uint64_t pending_ack;       // 묶음이 커밋되면 확인할 seq
+    int ack_waiting;            // ack_waiters에 들어 있음
+    time_t last_active;         // CLOCK_MONOTONIC 초
+    Session session;
+} Connection;
+
+void initialize_database();
+void save_to_database(const char *json_data, size_t len);
+void start_server(int port);
+static int service_connection(Connection *c);
+static void end_session(Connection *c);
+static int send_ack(int sock, uint64_t seq);
+static void prepare_statements(void);
+static void commit_group(void);
+static int group_wait_ms(void);
+static void commit_group_if_due(void);
+
+// 서버가 도는 동안 열어 두는 쓰기 연결
+static sqlite3 *db;
+// 수신 포트: 같은 DB를 쓰는 서버들을 구분 (노드는 서버마다 따로 seq를 매김)
+static int server_port = PORT;
+
+// 포트를 인자로 받아 한 호스트에서 여러 수집 서버를 띄울 수 있음 (데몬의 network.servers 목록)
+// 모두 같은 sensor_data.db에 쓰고, 노드의 high-water mark는 서버(포트)별로 따로 둠
+int main(int argc, char *argv[]) {
+    server_port = argc > 1 ? atoi(argv[1]) : PORT;
+    initialize_database();
+    start_server(server_port);
+    return 0;
+}
+
+// SQLite 데이터베이스 초기화 (연결은 닫지 않고 저장에 계속 씀)
+void initialize_database() {
+    char *err_msg = NULL;
+
+    int rc = sqlite3_open("sensor_data.db", &db);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Cannot open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        exit(1);
+    }
+    sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT_MS);
+
+    const char *sql = 
+        "CREATE TABLE IF NOT EXISTS tb_ph ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "pH_value REAL, "
+        "voltage REAL);"
+        "CREATE TABLE IF NOT EXISTS tb_water_level ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "water_level REAL, "
+        "voltage REAL);"
+        "CREATE TABLE IF NOT EXISTS tb_water_temperature ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "temperature REAL, "
+        "voltage REAL);"
+        "CREATE TABLE IF NOT EXISTS tb_conductivity ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "conductivity REAL, "
+        "voltage REAL);"
+        "CREATE TABLE IF NOT EXISTS tb_illuminance ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "illuminance REAL, "
+        "voltage REAL);"
+        // 대시보드(api.js)의 tb_alert와 같은 형태
+        "CREATE TABLE IF NOT EXISTS tb_alert ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "timestamp TEXT, "
+        "sensor_id TEXT, "
+        "location TEXT, "
+        "alert_type TEXT, "
+        "message TEXT);"
+        // 데몬의 구간 집계 요약 (reading_table: 원본 측정값 테이블, window_start: 구간 시작 시각)
+        "CREATE TABLE IF NOT EXISTS tb_summary ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "window_start TEXT, "
+        "window_seconds INTEGER, "
+        "reading_table TEXT, "
+        "sensor_id TEXT, "
+        "sample_count INTEGER, "
+        "min_value REAL, "
+        "max_value REAL, "
+        "mean_value REAL, "
+        "last_value REAL, "
+        "quality INTEGER, "
+        "node_id INTEGER);"
+        // 노드와 서버(수신 포트)별 확인 응답 high-water mark (이 seq까지의 데이터 프레임이 커밋됨)
+        // 노드는 서버마다 따로 seq를 매기므로 같은 DB를 쓰는 서버끼리 섞이면 안 됨
+        "CREATE TABLE IF NOT EXISTS tb_stream_seq ("
+        "node_id INTEGER NOT NULL, "
+        "port INTEGER NOT NULL, "
+        "high_water INTEGER NOT NULL, "
+        "PRIMARY KEY (node_id, port));";
+
+    rc = sqlite3_exec(db, sql, 0, 0, &err_msg);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Failed to create table: %s\n", err_msg);
+        sqlite3_free(err_msg);
+        sqlite3_close(db);
+        exit(1);
+    }
+
+    // 기존 DB에 step_held, ts_us(서버 시계 기준 µs 시각), node_id(측정한 노드) 컬럼 추가
+    // (이미 있으면 duplicate column 오류라 무시)
+    for (size_t t = 0; t < NUM_READING_TABLES; t++) {
+        char alter[128];
+        snprintf(alter, sizeof(alter), "ALTER TABLE %s ADD COLUMN step_held INTEGER NOT NULL DEFAULT 0;",
+                 reading_tables[t].table);
+        sqlite3_exec(db, alter, 0, 0, NULL);
+        snprintf(alter, sizeof(alter), "ALTER TABLE %s ADD COLUMN ts_us INTEGER;", reading_tables[t].table);
+        sqlite3_exec(db, alter, 0, 0, NULL);
+        snprintf(alter, sizeof(alter), "ALTER TABLE %s ADD COLUMN node_id INTEGER;", reading_tables[t].table);
+        sqlite3_exec(db, alter, 0, 0, NULL);
+    }
+    // 요약에도 요약한 노드 (게이트웨이가 중계한 요약을 구분)
+    sqlite3_exec(db, "ALTER TABLE tb_summary ADD COLUMN node_id INTEGER;", 0, 0, NULL);
+
+    // 포트 인자가 생기기 전의 노드별 mark(tb_node_seq)는 기본 포트 서버의 것 (없으면 오류라 무시)
+    char migrate[192];
+    snprintf(migrate, sizeof(migrate),
+             "INSERT OR IGNORE INTO tb_stream_seq (node_id, port, high_water) "
+             "SELECT node_id, %d, high_water FROM tb_node_seq; DROP TABLE tb_node_seq;", PORT);
+    sqlite3_exec(db, migrate, 0, 0, NULL);
+
+    // WAL: 커밋마다 fsync가 한 번이고, 대시보드가 읽는 동안에도 쓸 수 있음
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL;", 0, 0, NULL);
+    prepare_statements();
+}
+
+static Connection connections[MAX_CONNECTIONS];
+static int free_slots[MAX_CONNECTIONS];
+static int free_count;
+static int open_connections;
+static unsigned long refused_connections;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+// 연결 수만큼 파일 디스크립터가 필요하므로 소프트 한도를 올림 (하드 한도까지)
+static void raise_fd_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < MAX_CONNECTIONS + 16) {
+        limit.rlim_cur = limit.rlim_max < MAX_CONNECTIONS + 16 ? limit.rlim_max : MAX_CONNECTIONS + 16;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static void close_connection(Connection *c) {
+    end_session(c);
+    c->pending_ack = 0;     // ack_waiters에 남아 있어도 커밋 때 건너뜀
+    close(c->sock);     // epoll 집합에서도 빠짐
+    free(c->buf);
+    int ack_waiting = c->ack_waiting;
+    memset(c, 0, sizeof(*c));
+    c->sock = -1;
+    c->ack_waiting = ack_waiting;
+    free_slots[free_count++] = (int)(c - connections);
+    open_connections--;
+}
+
+static void accept_connections(int server_fd, int epoll_fd) {
+    for (;;) {
+        int sock = accept4(server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                perror("Accept failed");
+            }
+            return;
+        }
+        if (free_count == 0) {
+            if (refused_connections++ % 100 == 0) {
+                fprintf(stderr, "Connection limit (%d) reached, refusing connections (%lu so far)\n",
+                        MAX_CONNECTIONS, refused_connections);
+            }
+            close(sock);
+            continue;
+        }
+
+        Connection *c = &connections[free_slots[--free_count]];
+        c->sock = sock;
+        c->mode = CONNECTION_UNKNOWN;
+        c->last_active = monotonic_seconds();
+
+        struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event) < 0) {
+            perror("epoll_ctl failed");
+            close(sock);
+            c->sock = -1;
+            free_slots[free_count++] = (int)(c - connections);
+            continue;
+        }
+        open_connections++;
+    }
+}
+
+// 조용한 연결 정리 (끊긴 줄 모르는 연결이 자리를 차지하지 않도록)
+static void close_idle_connections(time_t now) {
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        if (connections[i].sock >= 0 && now - connections[i].last_active >= CONNECTION_IDLE_SECONDS) {
+            close_connection(&connections[i]);
+        }
+    }
+}
+
+// 서버 소켓 설정 및 실행: epoll 하나로 모든 연결을 처리 (연결은 노드가 닫거나 조용해질 때까지 유지)
+void start_server(int port) {
+    int server_fd;
+    struct sockaddr_in address;
+
+    if ((server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        perror("Socket failed");
+        exit(1);
+    }
+
+    // 재시작 직후 TIME_WAIT 연결이 남아 있어도 바로 다시 받음
+    int reuse = 1;
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        perror("Bind failed");
+        close(server_fd);
+        exit(1);
+    }
+
+    if (listen(server_fd, LISTEN_BACKLOG) < 0) {
+        perror("Listen failed");
+        close(server_fd);
+        exit(1);
+    }
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listen_event = { .events = EPOLLIN, .data.ptr = NULL };
+    if (epoll_fd < 0 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_fd, &listen_event) < 0) {
+        perror("epoll setup failed");
+        close(server_fd);
+        exit(1);
+    }
+
+    raise_fd_limit();
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        connections[i].sock = -1;
+        free_slots[i] = MAX_CONNECTIONS - 1 - i;
+    }
+    free_count = MAX_CONNECTIONS;
+
+    printf("Server is listening on port %d\n", port);
+
+    struct epoll_event events[256];
+    time_t last_sweep = monotonic_seconds();
+    while (1) {
+        // 열린 묶음이 있으면 커밋할 때에 맞춰 깨어남
+        int wait_ms = group_wait_ms();
+        int n = epoll_wait(epoll_fd, events, sizeof(events) / sizeof(events[0]), wait_ms >= 0 ? wait_ms : 1000);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait failed");
+            break;
+        }
+
+        time_t now = monotonic_seconds();
+        for (int i = 0; i < n; i++) {
+            Connection *c = events[i].data.ptr;
+            if (!c) {
+                accept_connections(server_fd, epoll_fd);
+                continue;
+            }
+            // 같은 배치에서 앞 이벤트가 이 연결을 이미 닫았을 수 있음 (같은 노드의 새 연결)
+            if (c->sock < 0) {
+                continue;
+            }
+            c->last_active = now;
+            if (!service_connection(c)) {
+                close_connection(c);
+            }
+            commit_group_if_due();
+        }
+        commit_group_if_due();
+
+        if (now != last_sweep) {
+            close_idle_connections(now);
+            last_sweep = now;
+        }
+    }
+
+    commit_group();
+    close(epoll_fd);
+    close(server_fd);
+}
+
+static int find_table(const char *table_name) {
+    for (size_t t = 0; t < NUM_READING_TABLES; t++) {
+        if (strcmp(reading_tables[t].table, table_name) == 0) return (int)t;
+    }
+    return -1;
+}
+
+// µs 시각을 DB 문자열로: 한 배치의 측정값은 대부분 같은 초라 마지막 변환 결과를 재사용
+static const char *format_timestamp(int64_t ts_us) {
+    static time_t cached_second = -1;
+    static char cached[32];
+
+    time_t seconds = ts_us / 1000000;
+    if (seconds != cached_second) {
+        struct tm tm_local;
+        strftime(cached, sizeof(cached), "%Y-%m-%dT%H:%M:%S", localtime_r(&seconds, &tm_local));
+        cached_second = seconds;
+    }
+    return cached;
+}
+
+// ---- 저장: 쓰기 연결 하나와 미리 준비한 문장, 묶음 커밋 ----
+// 프레임마다 트랜잭션을 커밋하면 커밋마다 fsync가 일어나 그게 수집 속도를 정함.
+// 여러 연결의 프레임을 한 트랜잭션에 모아 GROUP_COMMIT_ROWS 행이 쌓이거나 첫 행 뒤 GROUP_COMMIT_MS가 지나면 커밋.
+// 프레임마다 SAVEPOINT를 두어 잘못된 프레임은 그 프레임만 되돌리고, 확인 응답은 묶음이 커밋된 뒤에 보냄
+
+static sqlite3_stmt *reading_stmts[NUM_READING_TABLES];
+static sqlite3_stmt *alert_stmt;
+static sqlite3_stmt *summary_stmt;
+static sqlite3_stmt *legacy_ph_stmt;
+static sqlite3_stmt *seq_save_stmt;
+static sqlite3_stmt *seq_load_stmt;
+static sqlite3_stmt *begin_stmt, *commit_stmt, *rollback_stmt;
+static sqlite3_stmt *savepoint_stmt, *release_stmt, *rollback_to_stmt;
+
+static int group_open;              // BEGIN 이후 아직 커밋하지 않음
+static int group_rows;
+static int64_t group_deadline_ms;
+// 이번 묶음이 커밋되면 확인 응답을 보낼 연결 (Connection.pending_ack)
+static Connection *ack_waiters[MAX_CONNECTIONS];
+static int ack_waiter_count;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static sqlite3_stmt *prepare(const char *sql) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare statement (%s): %s\n", sql, sqlite3_errmsg(db));
+        exit(1);
+    }
+    return stmt;
+}
+
+// 바인딩한 문장 실행 후 다음 실행을 위해 초기화 (실패하면 0)
+static int run(sqlite3_stmt *stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return rc == SQLITE_DONE || rc == SQLITE_ROW;
+}
+
+static void prepare_statements(void) {
+    for (size_t t = 0; t < NUM_READING_TABLES; t++) {
+        char sql[256];
+        snprintf(sql, sizeof(sql),
+                 "INSERT INTO %s (timestamp, ts_us, node_id, sensor_id, %s, voltage, step_held) "
+                 "VALUES (?, ?, ?, ?, ?, ?, ?);",
+                 reading_tables[t].table, reading_tables[t].column);
+        reading_stmts[t] = prepare(sql);
+    }
+    alert_stmt = prepare("INSERT INTO tb_alert (timestamp, sensor_id, alert_type, message) VALUES (?, ?, ?, ?);");
+    summary_stmt = prepare("INSERT INTO tb_summary (window_start, window_seconds, reading_table, sensor_id, "
+                           "sample_count, min_value, max_value, mean_value, last_value, quality, node_id) "
+                           "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+    legacy_ph_stmt = prepare("INSERT INTO tb_ph (timestamp, sensor_id, location, pH_value, voltage) "
+                             "VALUES (?, ?, ?, ?, ?);");
+    seq_save_stmt = prepare("INSERT OR REPLACE INTO tb_stream_seq (node_id, port, high_water) VALUES (?, ?, ?);");
+    seq_load_stmt = prepare("SELECT high_water FROM tb_stream_seq WHERE node_id = ? AND port = ?;");
+    // 처음부터 쓰기 잠금을 잡음: 다른 서버와 겹치면 여기서 busy timeout만큼 기다림
+    begin_stmt = prepare("BEGIN IMMEDIATE;");
+    commit_stmt = prepare("COMMIT;");
+    rollback_stmt = prepare("ROLLBACK;");
+    savepoint_stmt = prepare("SAVEPOINT frame;");
+    release_stmt = prepare("RELEASE frame;");
+    rollback_to_stmt = prepare("ROLLBACK TO frame;");
+}
+
+// 묶음 커밋: 성공하면 기다리던 연결에 확인 응답, 실패하면 롤백하고 그 연결들을 끊어 다시 보내게 함
+// (프레임 처리 중에도 불리므로 바로 닫지 않고 shutdown: 다음 이벤트에서 평소처럼 닫힘)
+// 열린 묶음이 없어도 기다리는 연결이 있으면 확인 응답은 보냄
+static void commit_group(void) {
+    int committed = 1;
+    if (group_open) {
+        committed = run(commit_stmt);
+        if (!committed) {
+            fprintf(stderr, "Commit failed (%d rows): %s\n", group_rows, sqlite3_errmsg(db));
+            run(rollback_stmt);
+        }
+    }
+    group_open = 0;
+    group_rows = 0;
+
+    for (int i = 0; i < ack_waiter_count; i++) {
+        Connection *c = ack_waiters[i];
+        uint64_t seq = c->pending_ack;
+        c->pending_ack = 0;
+        c->ack_waiting = 0;
+        // 기다리는 동안 닫혔거나 이미 처리한 연결 (닫힌 칸을 새 연결이 쓰면 두 번 들어 있을 수 있음)
+        if (c->sock < 0 || seq == 0) {
+            continue;
+        }
+        if (!committed || !send_ack(c->sock, seq)) {
+            shutdown(c->sock, SHUT_RDWR);
+        }
+    }
+    ack_waiter_count = 0;
+}
+
+// 기다릴 시간이 남았으면 그 ms (열린 묶음이 없으면 -1)
+static int group_wait_ms(void) {
+    if (!group_open) {
+        return -1;
+    }
+    int64_t remaining = group_deadline_ms - monotonic_ms();
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+static void commit_group_if_due(void) {
+    if ((!group_open && ack_waiter_count > 0) ||
+        (group_open && (group_rows >= GROUP_COMMIT_ROWS || monotonic_ms() >= group_deadline_ms))) {
+        commit_group();
+    }
+}
+
+// 프레임 하나의 INSERT 시작: 묶음이 없으면 열고 프레임 SAVEPOINT (실패하면 0)
+static int begin_frame(void) {
+    if (!group_open) {
+        if (!run(begin_stmt)) {
+            fprintf(stderr, "Cannot begin transaction: %s\n", sqlite3_errmsg(db));
+            return 0;
+        }
+        group_open = 1;
+        group_deadline_ms = monotonic_ms() + GROUP_COMMIT_MS;
+    }
+    if (!run(savepoint_stmt)) {
+        fprintf(stderr, "Cannot start frame: %s\n", sqlite3_errmsg(db));
+        return 0;
+    }
+    return 1;
+}
+
+// 프레임 끝: keep이 아니면 프레임의 INSERT를 되돌림 (잘못된 프레임)
+// seq가 있으면 버린 프레임이라도 high-water mark를 같은 묶음에서 올림 (다시 보내도 같은 내용이므로)
+// 묶음이 커밋되기 전에 죽으면 데이터와 high-water mark가 함께 롤백되므로 클라이언트가 다시 보낸 프레임이 저장됨
+static int end_frame(const FrameSeq *seq, int keep) {
+    int stored = 1;
+
+    if (!keep) {
+        run(rollback_to_stmt);
+    }
+    if (seq) {
+        sqlite3_bind_int64(seq_save_stmt, 1, seq->node_id);
+        sqlite3_bind_int(seq_save_stmt, 2, server_port);
+        sqlite3_bind_int64(seq_save_stmt, 3, (sqlite3_int64)seq->seq);
+        if (!run(seq_save_stmt)) {
+            fprintf(stderr, "Failed to record sequence: %s\n", sqlite3_errmsg(db));
+            run(rollback_to_stmt);
+            stored = 0;
+        }
+    }
+    run(release_stmt);
+    return stored;
+}
+
+// 내용을 저장하지 않고 버리는 프레임: seq가 있으면 high-water mark만 올림
+static int discard_frame(const FrameSeq *seq) {
+    if (!seq) {
+        return 1;
+    }
+    return begin_frame() && end_frame(seq, 0);
+}
+
+// 경보 상태 변화 기록 (alert_type 예: water_level_low, ph_value_high, water_level_clear)
+static void insert_alert(int t, const char *timestamp, int sensor, double value, unsigned int quality) {
+    const char *state = (quality & QUALITY_ALARM_LOW) ? "low" : (quality & QUALITY_ALARM_HIGH) ? "high" : "clear";
+    char alert_type[64], message[128];
+
+    snprintf(alert_type, sizeof(alert_type), "%s_%s", reading_tables[t].field, state);
+    snprintf(message, sizeof(message), "%s %s: %f", reading_tables[t].field, state, value);
+    sqlite3_bind_text(alert_stmt, 1, timestamp, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(alert_stmt, 2, sensor);
+    sqlite3_bind_text(alert_stmt, 3, alert_type, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(alert_stmt, 4, message, -1, SQLITE_TRANSIENT);
+
+    if (!run(alert_stmt)) {
+        fprintf(stderr, "Failed to insert alert: %s\n", sqlite3_errmsg(db));
+    } else {
+        group_rows++;
+        printf("Alert: sensor %d %s %s (%f)\n", sensor, reading_tables[t].field, state, value);
+    }
+}
+
+// 측정값 한 건 INSERT (ts_us: 서버 시계 기준 µs 단위 UNIX 시각, quality: 데몬의 품질 플래그)
+// node_id: 측정한 노드 (게이트웨이가 중계한 레코드는 원래 노드, 모르면 0 → NULL)
+static void insert_reading(int t, uint32_t node_id, int64_t ts_us, int sensor, double value, double volts,
+                           unsigned int quality) {
+    sqlite3_stmt *stmt = reading_stmts[t];
+    const char *timestamp = format_timestamp(ts_us);
+
+    sqlite3_bind_text(stmt, 1, timestamp, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, ts_us);
+    if (node_id != 0) {
+        sqlite3_bind_int64(stmt, 3, node_id);
+    }
+    sqlite3_bind_int(stmt, 4, sensor);
+    sqlite3_bind_double(stmt, 5, value);
+    sqlite3_bind_double(stmt, 6, volts);
+    sqlite3_bind_int(stmt, 7, (quality & QUALITY_DEADBAND) ? 1 : 0);
+
+    if (!run(stmt)) {
+        fprintf(stderr, "Failed to insert data: %s\n", sqlite3_errmsg(db));
+    } else {
+        group_rows++;
+    }
+
+    if (quality & QUALITY_ALARM_CHANGE) {
+        insert_alert(t, timestamp, sensor, value, quality);
+    }
+}
+
+// 배치 프레임의 측정값 한 건 저장 (timestamp = base_ts + dt)
+static void save_batch_reading(uint32_t node_id, int64_t base_ts, struct json_object *item) {
+    struct json_object *table, *dt, *sensor_id, *value, *voltage, *quality;
+
+    if (!json_object_object_get_ex(item, "table", &table)) {
+        return;
+    }
+
+    const char *table_name = json_object_get_string(table);
+    int t = find_table(table_name);
+    if (t < 0 || !json_object_object_get_ex(item, reading_tables[t].field, &value)) {
+        fprintf(stderr, "Unknown reading in batch: %s\n", table_name);
+        return;
+    }
+
+    int64_t ts_us = base_ts;
+    if (json_object_object_get_ex(item, "dt", &dt)) {
+        ts_us += json_object_get_int64(dt);
+    }
+
+    int sensor = json_object_object_get_ex(item, "sensor_id", &sensor_id) ? json_object_get_int(sensor_id) : 0;
+    double volts = json_object_object_get_ex(item, "voltage", &voltage) ? json_object_get_double(voltage) : 0.0;
+    unsigned int flags = json_object_object_get_ex(item, "quality", &quality) ? json_object_get_int(quality) : 0;
+
+    insert_reading(t, node_id, ts_us, sensor, json_object_get_double(value), volts, flags);
+}
+
+// 배치 프레임 저장: 모든 측정값을 한 프레임으로 INSERT (DB를 쓸 수 없으면 0, 잘못된 프레임은 버리고 1)
+// offset_us: 노드 시각을 서버 시계로 옮기는 보정값 (시계 오프셋을 쓰지 않는 연결이면 0)
+static int save_batch(struct json_object *frame, const FrameSeq *seq, uint32_t node_id, int64_t offset_us) {
+    struct json_object *base_ts, *readings;
+
+    if (!json_object_object_get_ex(frame, "base_ts", &base_ts) ||
+        !json_object_object_get_ex(frame, "readings", &readings)) {
+        fprintf(stderr, "Malformed batch frame\n");
+        return discard_frame(seq);
+    }
+
+    int64_t base = json_object_get_int64(base_ts) + offset_us;
+    size_t count = json_object_array_length(readings);
+
+    if (!begin_frame()) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        save_batch_reading(node_id, base, json_object_array_get_idx(readings, i));
+    }
+    if (!end_frame(seq, 1)) {
+        return 0;
+    }
+
+    printf("Batch inserted: %zu readings\n", count);
+    return 1;
+}
+
+// 길이가 정해진 JSON 문서 하나를 파싱 (NUL 종료가 필요 없음, 값 뒤에는 공백만 허용). 완전하지 않으면 NULL
+static struct json_object *parse_json_document(const char *data, size_t len) {
+    struct json_tokener *tok = json_tokener_new();
+    if (!tok) {
+        return NULL;
+    }
+
+    struct json_object *obj = json_tokener_parse_ex(tok, data, (int)len);
+    if (obj) {
+        for (size_t i = json_tokener_get_parse_end(tok); i < len; i++) {
+            if (!isspace((unsigned char)data[i])) {
+                json_object_put(obj);
+                obj = NULL;
+                break;
+            }
+        }
+    }
+    json_tokener_free(tok);
+    return obj;
+}
+
+// 데이터베이스에 JSON 데이터 저장 (seq와 node_id는 배치 문서에만 적용)
+static int save_json(const char *json_data, size_t len, const FrameSeq *seq, uint32_t node_id,
+                     int64_t offset_us) {
+    // JSON 데이터 파싱
+    struct json_object *parsed_json;
+    struct json_object *timestamp, *sensor_id, *location, *pH_value, *voltage;
+    struct json_object *type;
+
+    parsed_json = parse_json_document(json_data, len);
+    if (!parsed_json) {
+        fprintf(stderr, "Invalid JSON: %.*s\n", (int)len, json_data);
+        return discard_frame(seq);
+    }
+
+    // 업링크 배치 프레임
+    if (json_object_object_get_ex(parsed_json, "type", &type) &&
+        strcmp(json_object_get_string(type), "batch") == 0) {
+        int stored = save_batch(parsed_json, seq, node_id, offset_us);
+        json_object_put(parsed_json);
+        return stored;
+    }
+
+    timestamp = sensor_id = location = pH_value = voltage = NULL;
+    json_object_object_get_ex(parsed_json, "timestamp", &timestamp);
+    json_object_object_get_ex(parsed_json, "sensor_id", &sensor_id);
+    json_object_object_get_ex(parsed_json, "location", &location);
+    json_object_object_get_ex(parsed_json, "pH_value", &pH_value);
+    json_object_object_get_ex(parsed_json, "voltage", &voltage);
+
+    // 값은 바인딩하므로 따옴표 등이 든 문자열도 그대로 저장
+    sqlite3_bind_text(legacy_ph_stmt, 1, json_object_get_string(timestamp), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(legacy_ph_stmt, 2, json_object_get_string(sensor_id), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(legacy_ph_stmt, 3, json_object_get_string(location), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(legacy_ph_stmt, 4, json_object_get_double(pH_value));
+    sqlite3_bind_double(legacy_ph_stmt, 5, json_object_get_double(voltage));
+
+    int stored = begin_frame();
+    if (stored) {
+        if (!run(legacy_ph_stmt)) {
+            fprintf(stderr, "Failed to insert data: %s\n", sqlite3_errmsg(db));
+        } else {
+            group_rows++;
+            printf("Data inserted successfully: %.*s\n", (int)len, json_data);
+        }
+        end_frame(NULL, 1);
+    } else {
+        sqlite3_clear_bindings(legacy_ph_stmt);
+    }
+
+    json_object_put(parsed_json);
+    return stored;
+}
+
+void save_to_database(const char *json_data, size_t len) {
+    save_json(json_data, len, NULL, 0, 0);
+}
+
+// 바이너리 배치 페이로드의 레코드를 열린 트랜잭션에 INSERT (저장한 수, 잘못된 페이로드면 -1)
+static int insert_binary_records(const uint8_t *payload, size_t len, uint32_t node_id, int64_t offset_us) {
+    static WireRecord records[PROTOCOL_MAX_RECORDS];
+
+    int count = protocol_decode_batch(payload, len, records, PROTOCOL_MAX_RECORDS);
+    if (count < 0) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        const char *table_name = protocol_kind_table(records[i].kind);
+        int t = table_name ? find_table(table_name) : -1;
+        if (t < 0) {
+            fprintf(stderr, "Unknown sensor kind in batch: %d\n", records[i].kind);
+            continue;
+        }
+        insert_reading(t, node_id, records[i].timestamp_us + offset_us, records[i].sensor_id, records[i].value,
+                       records[i].voltage, records[i].quality);
+    }
+    return count;
+}
+
+// 압축 배치는 레코드를 하나씩 풀면서 바로 INSERT (전체를 풀어 둘 버퍼가 필요 없음)
+// 손상된 페이로드면 -1: 앞부분도 버리도록 호출한 쪽이 프레임을 되돌림 (클라이언트 재전송과 중복되지 않도록)
+static int insert_compressed_records(const uint8_t *payload, size_t len, uint32_t node_id, int64_t offset_us) {
+    CompressDecoder decoder;
+    WireRecord record;
+    int count = 0, status;
+
+    if (!protocol_decompress_begin(&decoder, payload, len)) {
+        return -1;
+    }
+    while ((status = protocol_decompress_next(&decoder, &record)) == 1) {
+        const char *table_name = protocol_kind_table(record.kind);
+        int t = table_name ? find_table(table_name) : -1;
+        if (t < 0) {
+            fprintf(stderr, "Unknown sensor kind in batch: %d\n", record.kind);
+            continue;
+        }
+        insert_reading(t, node_id, record.timestamp_us + offset_us, record.sensor_id, record.value, record.voltage,
+                       record.quality);
+        count++;
+    }
+    return status < 0 ? -1 : count;
+}
+
+static int insert_records(uint8_t type, const uint8_t *payload, size_t len, uint32_t node_id, int64_t offset_us) {
+    if (type == FRAME_BATCH) {
+        return insert_binary_records(payload, len, node_id, offset_us);
+    }
+    if (type == FRAME_BATCH_COMPRESSED) {
+        return insert_compressed_records(payload, len, node_id, offset_us);
+    }
+    return -1;
+}
+
+// 요약 페이로드를 tb_summary에 INSERT (손상된 페이로드면 -1)
+static int insert_summaries(const uint8_t *payload, size_t len, uint32_t node_id, int64_t offset_us) {
+    static SummaryRecord records[PROTOCOL_MAX_SUMMARIES];
+
+    int count = protocol_decode_summary(payload, len, records, PROTOCOL_MAX_SUMMARIES);
+    if (count < 0) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        const char *table_name = protocol_kind_table(records[i].kind);
+        if (!table_name || find_table(table_name) < 0) {
+            fprintf(stderr, "Unknown sensor kind in summary: %d\n", records[i].kind);
+            continue;
+        }
+
+        sqlite3_bind_text(summary_stmt, 1, format_timestamp(records[i].window_start_us + offset_us), -1,
+                          SQLITE_TRANSIENT);
+        sqlite3_bind_int(summary_stmt, 2, records[i].window_ms / 1000);
+        sqlite3_bind_text(summary_stmt, 3, table_name, -1, SQLITE_STATIC);
+        sqlite3_bind_int(summary_stmt, 4, records[i].sensor_id);
+        sqlite3_bind_int64(summary_stmt, 5, records[i].count);
+        sqlite3_bind_double(summary_stmt, 6, records[i].min);
+        sqlite3_bind_double(summary_stmt, 7, records[i].max);
+        sqlite3_bind_double(summary_stmt, 8, records[i].mean);
+        sqlite3_bind_double(summary_stmt, 9, records[i].last);
+        sqlite3_bind_int(summary_stmt, 10, records[i].quality);
+        if (node_id != 0) {
+            sqlite3_bind_int64(summary_stmt, 11, node_id);
+        }
+        if (!run(summary_stmt)) {
+            fprintf(stderr, "Failed to insert summary: %s\n", sqlite3_errmsg(db));
+        } else {
+            group_rows++;
+        }
+    }
+    return count;
+}
+
+// 바이너리/압축 배치 프레임 저장: 모든 레코드를 한 프레임으로 INSERT
+static int save_records(uint8_t type, const uint8_t *payload, size_t len, const FrameSeq *seq, uint32_t node_id,
+                        int64_t offset_us) {
+    if (!begin_frame()) {
+        return 0;
+    }
+    int count = insert_records(type, payload, len, node_id, offset_us);
+    if (count < 0) {
+        fprintf(stderr, "Malformed %s batch (%zu bytes), discarded\n",
+                type == FRAME_BATCH ? "binary" : "compressed", len);
+        return end_frame(seq, 0);
+    }
+    int stored = end_frame(seq, 1);
+
+    if (stored) {
+        printf("%s batch inserted: %d readings (%zu bytes)\n", type == FRAME_BATCH ? "Binary" : "Compressed", count,
+               len);
+    }
+    return stored;
+}
+
+// 구간 요약 프레임 저장: 모든 구간을 한 프레임으로 tb_summary에 INSERT
+static int save_summary(const uint8_t *payload, size_t len, const FrameSeq *seq, uint32_t node_id,
+                        int64_t offset_us) {
+    if (!begin_frame()) {
+        return 0;
+    }
+    int count = insert_summaries(payload, len, node_id, offset_us);
+    if (count < 0) {
+        fprintf(stderr, "Malformed summary frame (%zu bytes)\n", len);
+        return end_frame(seq, 0);
+    }
+    int stored = end_frame(seq, 1);
+
+    if (stored) {
+        printf("Summaries inserted: %d windows\n", count);
+    }
+    return stored;
+}
+
+// 게이트웨이의 중계 프레임 저장: 노드별 구간을 한 프레임으로 INSERT (node_id 0 구간은 게이트웨이 자신)
+// 요약 구간은 tb_summary로. 구간 하나라도 잘못됐으면 프레임 전체를 버림
+static int save_relay(const uint8_t *payload, size_t len, const FrameSeq *seq, uint32_t gateway_id,
+                      int64_t offset_us) {
+    RelaySection section;
+    size_t offset = 0;
+    int count = 0, summaries = 0, sections = 0, status;
+
+    if (!begin_frame()) {
+        return 0;
+    }
+    while ((status = protocol_next_relay_section(payload, len, &offset, &section)) == 1) {
+        uint32_t node_id = section.node_id != 0 ? section.node_id : gateway_id;
+        int n = section.type == FRAME_SUMMARY
+                    ? insert_summaries(section.payload, section.length, node_id, offset_us)
+                    : insert_records(section.type, section.payload, section.length, node_id, offset_us);
+        if (n < 0) {
+            status = -1;
+            break;
+        }
+        if (section.type == FRAME_SUMMARY) {
+            summaries += n;
+        } else {
+            count += n;
+        }
+        sections++;
+    }
+    if (status < 0) {
+        fprintf(stderr, "Malformed relay frame from node %u (%zu bytes), discarded\n", gateway_id, len);
+        return end_frame(seq, 0);
+    }
+    int stored = end_frame(seq, 1);
+
+    if (stored) {
+        printf("Relay batch inserted: %d readings and %d summaries in %d sections via node %u\n", count, summaries,
+               sections, gateway_id);
+    }
+    return stored;
+}
+
+// 노드가 이 서버(포트)에 저장한 마지막 seq (처음 보는 노드면 0)
+// 커밋하지 않은 묶음이 있으면 먼저 커밋: 아직 커밋하지 않은 seq를 확인해 주지 않도록
+static uint64_t load_high_water(uint32_t node_id) {
+    uint64_t high_water = 0;
+
+    commit_group();
+    sqlite3_bind_int64(seq_load_stmt, 1, node_id);
+    sqlite3_bind_int(seq_load_stmt, 2, server_port);
+    if (sqlite3_step(seq_load_stmt) == SQLITE_ROW) {
+        high_water = (uint64_t)sqlite3_column_int64(seq_load_stmt, 0);
+    }
+    sqlite3_reset(seq_load_stmt);
+    sqlite3_clear_bindings(seq_load_stmt);
+    return high_water;
+}
+
+static int send_ack(int sock, uint64_t seq) {
+    uint8_t frame[PROTOCOL_HEADER_SIZE + PROTOCOL_SEQ_SIZE];
+    protocol_write_header(frame, FRAME_ACK, PROTOCOL_SEQ_SIZE);
+    protocol_encode_seq(frame + PROTOCOL_HEADER_SIZE, seq);
+    return send(sock, frame, sizeof(frame), MSG_NOSIGNAL) == (ssize_t)sizeof(frame);
+}
+
+// HELLO에 응답: 스키마가 같으면 압축 > 바이너리 순으로, 다르면 프레임 JSON으로 받음
+// 확인 응답을 쓰면 HELLO_ACK 뒤에 노드의 high-water mark를 FRAME_ACK로 알려 줌
+static int answer_hello(int sock, const uint8_t *payload, size_t len, Session *session) {
+    HelloInfo hello, ack;
+    if (!protocol_decode_hello(payload, len, &hello)) {
+        return 0;
+    }
+
+    ack.version = hello.version < PROTOCOL_VERSION ? hello.version : PROTOCOL_VERSION;
+    ack.schema_id = PROTOCOL_SCHEMA_ID;
+    ack.node_id = hello.node_id;
+    ack.encodings = PROTOCOL_ENCODING_JSON;
+    if (hello.schema_id == PROTOCOL_SCHEMA_ID) {
+        if (hello.encodings & PROTOCOL_ENCODING_COMPRESSED) {
+            ack.encodings = PROTOCOL_ENCODING_COMPRESSED;
+        } else if (hello.encodings & PROTOCOL_ENCODING_BINARY) {
+            ack.encodings = PROTOCOL_ENCODING_BINARY;
+        }
+        ack.encodings |= hello.encodings & PROTOCOL_FEATURE_SUMMARY;
+    }
+    ack.encodings |= hello.encodings & (PROTOCOL_FEATURE_ACK | PROTOCOL_FEATURE_CLOCK | PROTOCOL_FEATURE_RELAY);
+    uint8_t records = ack.encodings & PROTOCOL_ENCODING_RECORDS;
+
+    session->node_id = hello.node_id;
+    session->greeted = 1;
+    session->acks = (ack.encodings & PROTOCOL_FEATURE_ACK) != 0;
+    session->high_water = session->acks ? load_high_water(hello.node_id) : 0;
+    session->clock = (ack.encodings & PROTOCOL_FEATURE_CLOCK) != 0;
+
+    uint8_t reply[PROTOCOL_HEADER_SIZE + PROTOCOL_HELLO_SIZE];
+    protocol_write_header(reply, FRAME_HELLO_ACK, PROTOCOL_HELLO_SIZE);
+    protocol_encode_hello(reply + PROTOCOL_HEADER_SIZE, &ack);
+
+    printf("Node %u connected: protocol v%d, schema %d, %s records%s%s\n", hello.node_id, ack.version,
+           hello.schema_id,
+           records == PROTOCOL_ENCODING_COMPRESSED ? "compressed" :
+           records == PROTOCOL_ENCODING_BINARY ? "binary" : "JSON",
+           session->acks ? ", acknowledged" : "", session->clock ? ", clock offset" : "");
+    if (send(sock, reply, sizeof(reply), MSG_NOSIGNAL) != (ssize_t)sizeof(reply)) {
+        return 0;
+    }
+    return !session->acks || send_ack(sock, session->high_water);
+}
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 시각 요청에 응답: 받은 시각 t2와 보내는 시각 t3를 붙여 돌려줌
+// (앞선 프레임을 저장하느라 늦게 읽은 요청은 RTT가 커져 클라이언트의 최소 RTT 필터에서 걸러짐)
+static int answer_time_request(int sock, const uint8_t *payload, size_t len, int64_t received_us) {
+    uint8_t reply[PROTOCOL_HEADER_SIZE + PROTOCOL_TIME_REPLY_SIZE];
+    int64_t stamps[3];
+
+    if (len != PROTOCOL_TIME_REQUEST_SIZE) {
+        return 0;
+    }
+    protocol_decode_time(payload, stamps, 1);
+    stamps[1] = received_us;
+    stamps[2] = now_us();
+    protocol_write_header(reply, FRAME_TIME_REPLY, PROTOCOL_TIME_REPLY_SIZE);
+    protocol_encode_time(reply + PROTOCOL_HEADER_SIZE, stamps, 3);
+    return send(sock, reply, sizeof(reply), MSG_NOSIGNAL) == (ssize_t)sizeof(reply);
+}
+
+static int is_data_frame(uint8_t type) {
+    return type == FRAME_BATCH || type == FRAME_BATCH_JSON || type == FRAME_BATCH_COMPRESSED ||
+           type == FRAME_SUMMARY || type == FRAME_RELAY;
+}
+
+// 같은 노드가 다시 연결했으면 남아 있는 이전 연결을 닫음 (끊긴 줄 모르는 연결이 자리를 차지하지 않도록)
+// node_id 0은 설정하지 않은 노드라 여럿일 수 있으므로 건드리지 않음
+static void close_stale_sessions(const Connection *current) {
+    if (current->session.node_id == 0) {
+        return;
+    }
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        Connection *c = &connections[i];
+        if (c != current && c->sock >= 0 && c->mode == CONNECTION_FRAMED && c->session.greeted &&
+            c->session.node_id == current->session.node_id) {
+            close_connection(c);
+        }
+    }
+}
+
+// 완성된 프레임 하나 처리 (0이면 연결을 닫음)
+static int handle_frame(Connection *c, const FrameHeader *header, const uint8_t *payload) {
+    Session *session = &c->session;
+
+    if (header->type == FRAME_TIME_REQUEST) {
+        return answer_time_request(c->sock, payload, header->length, now_us());
+    }
+    if (header->type == FRAME_HELLO) {
+        if (!answer_hello(c->sock, payload, header->length, session)) {
+            return 0;
+        }
+        close_stale_sessions(c);
+        return 1;
+    }
+
+    // 데이터 프레임 앞의 seq: high-water mark 이하면 이미 저장한 재전송이므로 확인만 다시 보냄
+    const uint8_t *body = payload;
+    size_t body_len = header->length;
+    FrameSeq seq = { session->node_id, 0 };
+    if (session->acks && is_data_frame(header->type)) {
+        if (body_len < PROTOCOL_SEQ_SIZE) {
+            fprintf(stderr, "Data frame without sequence number, closing connection\n");
+            return 0;
+        }
+        seq.seq = protocol_decode_seq(payload);
+        body += PROTOCOL_SEQ_SIZE;
+        body_len -= PROTOCOL_SEQ_SIZE;
+        if (seq.seq <= session->high_water) {
+            session->duplicates++;
+            printf("Duplicate frame %llu from node %u skipped\n", (unsigned long long)seq.seq, session->node_id);
+            // 아직 커밋하지 않은 프레임이면 커밋 때 확인
+            return c->pending_ack != 0 || send_ack(c->sock, session->high_water);
+        }
+    }
+    const FrameSeq *sequenced = seq.seq != 0 ? &seq : NULL;
+
+    // seq 뒤의 시계 오프셋: 노드 시각에 더해 서버 시계 기준으로 저장
+    int64_t offset_us = 0;
+    if (session->clock && is_data_frame(header->type)) {
+        if (body_len < PROTOCOL_OFFSET_SIZE) {
+            fprintf(stderr, "Data frame without clock offset, closing connection\n");
+            return 0;
+        }
+        protocol_decode_time(body, &offset_us, 1);
+        body += PROTOCOL_OFFSET_SIZE;
+        body_len -= PROTOCOL_OFFSET_SIZE;
+        if (llabs(offset_us - session->clock_offset_us) >= CLOCK_REPORT_THRESHOLD_US) {
+            printf("Node %u clock offset %+.3f ms\n", session->node_id, offset_us / 1000.0);
+            session->clock_offset_us = offset_us;
+        }
+    }
+
+    int stored;
+    switch (header->type) {
+    case FRAME_BATCH:
+    case FRAME_BATCH_COMPRESSED:
+        stored = save_records(header->type, body, body_len, sequenced, session->node_id, offset_us);
+        break;
+    case FRAME_RELAY:
+        stored = save_relay(body, body_len, sequenced, session->node_id, offset_us);
+        break;
+    case FRAME_SUMMARY:
+        stored = save_summary(body, body_len, sequenced, session->node_id, offset_us);
+        break;
+    case FRAME_BATCH_JSON:
+        stored = save_json((const char *)body, body_len, sequenced, session->node_id, offset_us);
+        break;
+    default:
+        fprintf(stderr, "Unknown frame type %d\n", header->type);
+        return 1;
+    }
+
+    if (!sequenced) {
+        return 1;
+    }
+    // 저장하지 못했으면 확인하지 않고 연결을 닫아 클라이언트가 다시 보내게 함
+    if (!stored) {
+        return 0;
+    }
+    // 확인 응답은 묶음이 커밋된 뒤 (그 전에 죽으면 클라이언트가 다시 보냄)
+    session->high_water = seq.seq;
+    c->pending_ack = seq.seq;
+    if (!c->ack_waiting) {
+        if (ack_waiter_count == MAX_CONNECTIONS) {
+            commit_group();
+            return 1;
+        }
+        c->ack_waiting = 1;
+        ack_waiters[ack_waiter_count++] = c;
+    }
+    return 1;
+}
+
+static int reserve_buffer(Connection *c, size_t need) {
+    if (c->cap >= need) {
+        return 1;
+    }
+    uint8_t *buf = realloc(c->buf, need);
+    if (!buf) {
+        fprintf(stderr, "Out of memory for connection buffer (%zu bytes)\n", need);
+        return 0;
+    }
+    c->buf = buf;
+    c->cap = need;
+    return 1;
+}
+
+// 버퍼에 모인 완성된 프레임을 차례로 처리 (헤더가 잘못됐거나 처리에 실패하면 0)
+// 프레임 크기는 protocol_parse_header가 PROTOCOL_MAX_PAYLOAD로 제한
+static int parse_frames(Connection *c) {
+    FrameHeader header;
+
+    c->want = 0;
+    while (c->len - c->start >= PROTOCOL_HEADER_SIZE) {
+        const uint8_t *frame = c->buf + c->start;
+        if (!protocol_parse_header(frame, &header)) {
+            fprintf(stderr, "Invalid frame header, closing connection\n");
+            return 0;
+        }
+        size_t size = PROTOCOL_HEADER_SIZE + header.length;
+        if (c->len - c->start < size) {
+            c->want = size;
+            return 1;
+        }
+        if (!handle_frame(c, &header, frame + PROTOCOL_HEADER_SIZE)) {
+            return 0;
+        }
+        c->start += size;
+    }
+    return 1;
+}
+
+// 기존 JSON 문서 한 건 (줄 끝 공백/CR은 무시, 빈 줄은 건너뜀)
+static void store_json_document(const uint8_t *data, size_t len) {
+    while (len > 0 && isspace(data[len - 1])) {
+        len--;
+    }
+    if (len == 0) {
+        return;
+    }
+    printf("Received data: %.*s\n", (int)len, (const char *)data);
+    save_to_database((const char *)data, len);
+}
+
+// 기존 JSON 클라이언트: 개행 구분 JSON (데몬의 JSON 모드)
+// 개행 없이 문서 하나씩 보내는 구버전 클라이언트도 있으므로, 개행이 없어도 남은 바이트가 완전한 문서면 처리
+static int parse_json_lines(Connection *c, int eof) {
+    for (;;) {
+        // glibc memchr는 벡터 명령으로 한 번에 여러 바이트를 비교
+        uint8_t *newline = memchr(c->buf + c->scan, '\n', c->len - c->scan);
+        if (!newline) {
+            break;
+        }
+        size_t end = newline - c->buf;
+        store_json_document(c->buf + c->start, end - c->start);
+        c->start = c->scan = end + 1;
+    }
+    c->scan = c->len;
+
+    size_t pending = c->len - c->start;
+    if (pending == 0) {
+        return 1;
+    }
+    struct json_object *complete = eof ? NULL : parse_json_document((const char *)c->buf + c->start, pending);
+    if (eof || complete) {
+        json_object_put(complete);
+        store_json_document(c->buf + c->start, pending);
+        c->start = c->scan = c->len;
+        return 1;
+    }
+    if (pending >= MAX_JSON_DOCUMENT) {
+        fprintf(stderr, "JSON document exceeds %d bytes without a newline, closing connection\n",
+                MAX_JSON_DOCUMENT);
+        return 0;
+    }
+    return 1;
+}
+
+// 처리한 부분을 버리고 읽다 만 나머지를 버퍼 앞으로 (비었으면 큰 버퍼는 놓음)
+static void compact_buffer(Connection *c) {
+    size_t rest = c->len - c->start;
+    if (rest > 0 && c->start > 0) {
+        memmove(c->buf, c->buf + c->start, rest);
+    }
+    c->scan -= c->start;
+    c->len = rest;
+    c->start = 0;
+    if (rest == 0 && c->cap > CONNECTION_BUFFER_KEEP) {
+        free(c->buf);
+        c->buf = NULL;
+        c->cap = 0;
+    }
+}
+
+// 읽을 수 있게 된 연결 처리 (0이면 닫음): 한 번 읽고, 그 안에서 완성된 프레임/줄을 모두 처리
+// 한 세그먼트에 여러 프레임이 와도, 프레임 하나가 여러 세그먼트로 나뉘어 와도 같음
+static int service_connection(Connection *c) {
+    size_t need = c->len + CONNECTION_READ_SIZE;
+    if (c->want > need) {
+        need = c->want;
+    }
+    if (!reserve_buffer(c, need)) {
+        return 0;
+    }
+
+    ssize_t n = recv(c->sock, c->buf + c->len, c->cap - c->len, 0);
+    if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    int eof = n == 0;
+    c->len += n;
+
+    // 첫 두 바이트로 판별: 프로토콜 매직이면 프레임 세션
+    if (c->mode == CONNECTION_UNKNOWN) {
+        if (c->len < 2 && !eof) {
+            return 1;
+        }
+        c->mode = c->len >= 2 && (c->buf[0] << 8 | c->buf[1]) == PROTOCOL_MAGIC ? CONNECTION_FRAMED
+                                                                               : CONNECTION_JSON;
+    }
+
+    int ok = c->mode == CONNECTION_FRAMED ? parse_frames(c) : parse_json_lines(c, eof);
+    compact_buffer(c);
+    return ok && !eof;
+}
+
+static void end_session(Connection *c) {
+    if (c->session.duplicates > 0) {
+        printf("Node %u: %lu duplicate frames skipped\n", c->session.node_id, c->session.duplicates);
+    }
+}
@@ -1,8 +1,50 @@
 #include "adc.h"
 #include "config.h"
+#include "thread_manager.h"
 #include <bcm2835.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// SPI 잠금을 기다리는 최대 시간: 다른 스레드가 전송 중에 멈춰 있으면 그 측정값은 버리고 주기를 이어감
+#define ADC_LOCK_TIMEOUT_MS 10
+
+// 수위/pH 스레드(와 교체된 이전 스레드)가 SPI를 함께 쓰므로 전송과 재초기화를 한 번에 하나씩
+static pthread_mutex_t spi_mutex = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool reinit_requested;
+
+static void spi_configure(void) {
+    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
+    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
+    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_256);
+    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
+    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+}
+
+// spi_mutex를 쥔 채 호출
+static void spi_reinit(void) {
+    bcm2835_spi_end();
+    sleep(1);
+    if (!bcm2835_spi_begin()) {
+        printf("SPI 재초기화 실패\n");
+        return;
+    }
+    spi_configure();
+    printf("SPI 재초기화 완료\n");
+}
+
+static bool spi_lock(void) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += ADC_LOCK_TIMEOUT_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    return pthread_mutex_timedlock(&spi_mutex, &deadline) == 0;
+}
 
 bool adc_init(void) {
     if (!bcm2835_init()) {
@@ -16,22 +58,26 @@ bool adc_init(void) {
         return false;
     }
 
-    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_256);
-    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
+    spi_configure();
 
     return true;
 }
 
+// 워치독이 버린 스레드(전송에서 늦게 돌아온 이전 스레드)는 더 읽지 않음
+// 잠금을 얻지 못하거나 버려진 스레드면 0 (유효하지 않은 샘플)
 uint16_t adc_read(int channel) {
-    if (channel < 0 || channel > 7) {
+    if (channel < 0 || channel > 7 || thread_abandoned() || !spi_lock()) {
         return 0;
     }
 
+    // 워치독이 요청한 재초기화는 SPI를 쓰는 스레드가 전송 사이에 직접 수행
+    if (atomic_exchange(&reinit_requested, false)) {
+        spi_reinit();
+    }
+
     uint8_t buffer[3] = {0x01, (0x08 + channel) << 4, 0x00};
     bcm2835_spi_transfern((char*)buffer, 3);
+    pthread_mutex_unlock(&spi_mutex);
     
     return ((buffer[1] & 0x03) << 8) + buffer[2];
 }
@@ -41,21 +87,12 @@ float adc_to_voltage(uint16_t adc_value) {
 }
 
 void adc_cleanup(void) {
+    pthread_mutex_lock(&spi_mutex);
     bcm2835_spi_end();
     bcm2835_close();
+    pthread_mutex_unlock(&spi_mutex);
 }
 
 void adc_reinit(void) {
-    bcm2835_spi_end();
-    sleep(1);
-    if (!bcm2835_spi_begin()) {
-        printf("SPI 재초기화 실패\n");
-        return;
-    }
-    bcm2835_spi_setBitOrder(BCM2835_SPI_BIT_ORDER_MSBFIRST);
-    bcm2835_spi_setDataMode(BCM2835_SPI_MODE0);
-    bcm2835_spi_setClockDivider(BCM2835_SPI_CLOCK_DIVIDER_256);
-    bcm2835_spi_chipSelect(BCM2835_SPI_CS0);
-    bcm2835_spi_setChipSelectPolarity(BCM2835_SPI_CS0, LOW);
-    printf("SPI 재초기화 완료\n");
+    atomic_store(&reinit_requested, true);
 } 
\ No newline at end of file
@@ -7,6 +7,7 @@
 bool adc_init(void);
 void adc_cleanup(void);
 uint16_t adc_read(int channel);
+// 재초기화 요청 (워치독 복구 동작): 다음 adc_read가 전송 전에 SPI를 다시 시작함
 void adc_reinit(void);
 float adc_to_voltage(uint16_t adc_value);
 
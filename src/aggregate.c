@@ -0,0 +1,177 @@
+#include "aggregate.h"
+#include "readings.h"
+#include "logger.h"
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+// 채널별 현재 구간 (채널당 생산자 하나라 잠금 없음)
+typedef struct {
+    bool open;
+    int64_t window_start_us;
+    uint32_t count;
+    uint32_t quality;
+    float min;
+    float max;
+    float last;
+    double sum;
+} Window;
+
+static AggregateConfig aggregate_config;
+static int64_t window_us;
+static Window windows[NUM_CHANNELS];
+
+// 닫힌 요약 대기열 (생산자는 분에 한 번꼴이라 뮤텍스로 충분)
+static SummaryRecord pending[AGGREGATE_MAX_PENDING];
+static int pending_head = 0;
+static int pending_count = 0;
+static uint64_t dropped = 0;
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void aggregate_init(const AggregateConfig* config) {
+    memcpy(&aggregate_config, config, sizeof(AggregateConfig));
+    memset(windows, 0, sizeof(windows));
+    if (!aggregate_config.enabled) {
+        return;
+    }
+
+    if (aggregate_config.window_s <= 0) {
+        aggregate_config.window_s = DEFAULT_AGGREGATE_WINDOW_S;
+    }
+    window_us = (int64_t)aggregate_config.window_s * 1000000;
+    log_info("Aggregation: %d s windows%s", aggregate_config.window_s,
+             aggregate_config.raw ? " alongside raw uplink" : ", raw uplink off");
+}
+
+// 대기열 뒤에 추가 (가득 차면 가장 오래된 요약을 버림)
+static void push_summary(const SummaryRecord* record) {
+    pthread_mutex_lock(&pending_mutex);
+    if (pending_count == AGGREGATE_MAX_PENDING) {
+        pending_head = (pending_head + 1) % AGGREGATE_MAX_PENDING;
+        pending_count--;
+        dropped++;
+    }
+    pending[(pending_head + pending_count) % AGGREGATE_MAX_PENDING] = *record;
+    pending_count++;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+static void close_window(int channel) {
+    Window* w = &windows[channel];
+    SensorKind kind;
+    int sensor_id;
+
+    if (!w->open || !readings_channel_info(channel, &kind, &sensor_id)) {
+        w->open = false;
+        return;
+    }
+
+    SummaryRecord record = {
+        .channel = channel,
+        .kind = kind,
+        .sensor_id = sensor_id,
+        .quality = w->quality,
+        .window_start_us = w->window_start_us,
+        .window_ms = aggregate_config.window_s * 1000,
+        .count = w->count,
+        .min = w->min,
+        .max = w->max,
+        .mean = (float)(w->sum / w->count),
+        .last = w->last
+    };
+    push_summary(&record);
+    w->open = false;
+}
+
+void aggregate_add(const Reading* reading) {
+    if (!aggregate_config.enabled || reading->channel < 0 || reading->channel >= NUM_CHANNELS ||
+        isnan(reading->value)) {
+        return;
+    }
+
+    // 구간은 벽시계에 맞춰 정렬 (노드와 채널이 달라도 같은 구간 경계)
+    int64_t start = reading->timestamp_us - reading->timestamp_us % window_us;
+
+    Window* w = &windows[reading->channel];
+    if (w->open && w->window_start_us != start) {
+        close_window(reading->channel);
+    }
+
+    if (!w->open) {
+        w->open = true;
+        w->window_start_us = start;
+        w->count = 0;
+        w->quality = 0;
+        w->min = reading->value;
+        w->max = reading->value;
+        w->sum = 0;
+    }
+    if (reading->value < w->min) {
+        w->min = reading->value;
+    }
+    if (reading->value > w->max) {
+        w->max = reading->value;
+    }
+    w->sum += reading->value;
+    w->count++;
+    w->quality |= reading->quality;
+    w->last = reading->value;
+}
+
+void aggregate_flush(void) {
+    if (!aggregate_config.enabled) {
+        return;
+    }
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        close_window(ch);
+    }
+}
+
+int aggregate_take(SummaryRecord* out, int max) {
+    pthread_mutex_lock(&pending_mutex);
+    int n = pending_count < max ? pending_count : max;
+    for (int i = 0; i < n; i++) {
+        out[i] = pending[(pending_head + i) % AGGREGATE_MAX_PENDING];
+    }
+    pending_head = (pending_head + n) % AGGREGATE_MAX_PENDING;
+    pending_count -= n;
+    pthread_mutex_unlock(&pending_mutex);
+    return n;
+}
+
+void aggregate_relay(const SummaryRecord* records, int count) {
+    for (int i = 0; i < count; i++) {
+        push_summary(&records[i]);
+    }
+}
+
+void aggregate_requeue(const SummaryRecord* records, int count) {
+    pthread_mutex_lock(&pending_mutex);
+    // 그사이 새 요약이 들어와 자리가 모자라면 되돌릴 것 중 오래된 쪽부터 버림
+    int room = AGGREGATE_MAX_PENDING - pending_count;
+    if (count > room) {
+        dropped += count - room;
+        records += count - room;
+        count = room;
+    }
+    pending_head = (pending_head - count + AGGREGATE_MAX_PENDING) % AGGREGATE_MAX_PENDING;
+    for (int i = 0; i < count; i++) {
+        pending[(pending_head + i) % AGGREGATE_MAX_PENDING] = records[i];
+    }
+    pending_count += count;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+int aggregate_pending(void) {
+    pthread_mutex_lock(&pending_mutex);
+    int count = pending_count;
+    pthread_mutex_unlock(&pending_mutex);
+    return count;
+}
+
+uint64_t aggregate_dropped(void) {
+    pthread_mutex_lock(&pending_mutex);
+    uint64_t count = dropped;
+    pthread_mutex_unlock(&pending_mutex);
+    return count;
+}
@@ -0,0 +1,40 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "config.h"
+#include "protocol.h"
+
+// 업링크 앞단의 구간 집계
+// 채널마다 현재 구간의 min/max/sum/count/last만 들고 있다가(측정값당 O(1)) 다음 구간의 첫
+// 측정값이 오면 요약 레코드 하나로 닫아 전송 대기열에 넣음. 대기열은 메모리에만 있으며
+// 서버에 닿지 못하는 동안 가득 차면 가장 오래된 요약부터 버림
+
+// 대기열 크기 (채널 13개 × 1분 구간이면 약 5시간 분량)
+#define AGGREGATE_MAX_PENDING 4096
+
+void aggregate_init(const AggregateConfig* config);
+
+// 측정값을 채널의 현재 구간에 반영 (채널별 생산자는 한 스레드뿐이어야 함, uplink_submit과 같은 조건)
+void aggregate_add(const Reading* reading);
+
+// 열려 있는 구간을 모두 닫음 (종료 시, 측정 스레드가 멈춘 뒤)
+void aggregate_flush(void);
+
+// 닫힌 요약을 오래된 순으로 최대 max개 꺼냄 (업링크 스레드)
+int aggregate_take(SummaryRecord* out, int max);
+
+// 보내지 못한 요약을 대기열 앞에 되돌림 (자리가 없으면 버림)
+void aggregate_requeue(const SummaryRecord* records, int count);
+
+// 게이트웨이가 하위 노드에서 받은 요약을 (node_id를 붙인 채) 대기열 뒤에 추가 (중계 스레드)
+// 이 노드의 집계 설정과 무관하게 받으며, 가득 차면 자기 요약과 같이 가장 오래된 것부터 버림
+void aggregate_relay(const SummaryRecord* records, int count);
+
+// 대기 중인 요약 수와 대기열이 넘쳐 버린 요약 수 (실행 중 누적)
+int aggregate_pending(void);
+uint64_t aggregate_dropped(void);
+
+#endif
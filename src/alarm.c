@@ -0,0 +1,50 @@
+#include "alarm.h"
+#include "readings.h"
+#include <math.h>
+#include <string.h>
+
+#define ALARM_STATE_MASK (READING_QUALITY_ALARM_LOW | READING_QUALITY_ALARM_HIGH)
+
+static PriorityConfig priority_config;
+static uint32_t channel_state[NUM_CHANNELS];    // 채널별 현재 경보 플래그 (채널당 생산자 하나)
+
+void alarm_init(const PriorityConfig* config) {
+    memcpy(&priority_config, config, sizeof(PriorityConfig));
+    memset(channel_state, 0, sizeof(channel_state));
+}
+
+// 경보 중이면 한계에서 hysteresis만큼 안쪽으로 돌아와야 해제
+static uint32_t next_state(const AlarmLimit* limit, uint32_t state, float value) {
+    float low_clear = limit->low + ((state & READING_QUALITY_ALARM_LOW) ? limit->hysteresis : 0);
+    float high_clear = limit->high - ((state & READING_QUALITY_ALARM_HIGH) ? limit->hysteresis : 0);
+
+    if (limit->has_low && value < low_clear) {
+        return READING_QUALITY_ALARM_LOW;
+    }
+    if (limit->has_high && value > high_clear) {
+        return READING_QUALITY_ALARM_HIGH;
+    }
+    return 0;
+}
+
+bool alarm_classify(const Reading* reading, Reading* out) {
+    *out = *reading;
+
+    SensorKind kind;
+    int sensor_id;
+    if (!priority_config.enabled || reading->channel < 0 || reading->channel >= NUM_CHANNELS ||
+        !(reading->quality & READING_QUALITY_VALID) || isnan(reading->value) ||
+        !readings_channel_info(reading->channel, &kind, &sensor_id)) {
+        return false;
+    }
+
+    uint32_t state = next_state(&priority_config.limits[kind], channel_state[reading->channel], reading->value);
+    bool changed = state != channel_state[reading->channel];
+
+    channel_state[reading->channel] = state;
+    out->quality = (out->quality & ~ALARM_STATE_MASK) | state;
+    if (changed) {
+        out->quality |= READING_QUALITY_ALARM_CHANGE;
+    }
+    return changed;
+}
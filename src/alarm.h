@@ -0,0 +1,17 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdbool.h>
+#include "types.h"
+#include "config.h"
+
+// 경보 한계 판정: 채널마다 경보 상태(정상/하한/상한)를 들고 측정값에 상태 플래그를 붙임
+// 상태가 바뀐 측정값에는 READING_QUALITY_ALARM_CHANGE를 붙여 업링크가 우선 차선으로 보내게 함
+
+void alarm_init(const PriorityConfig* config);
+
+// out에 경보 상태 플래그를 붙인 측정값을 쓰고, 경보 상태가 바뀌었으면 true
+// 채널별 생산자는 한 스레드뿐이어야 함 (uplink_submit과 같은 조건)
+bool alarm_classify(const Reading* reading, Reading* out);
+
+#endif
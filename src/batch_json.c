@@ -0,0 +1,274 @@
+#include "batch_json.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 u128;
+
+// 10^0 .. 10^38 (float 서식용)
+static u128 pow10_table[39];
+#endif
+
+static void build_pow10(void) {
+#ifdef __SIZEOF_INT128__
+    pow10_table[0] = 1;
+    for (int i = 1; i < 39; i++) {
+        pow10_table[i] = pow10_table[i - 1] * 10;
+    }
+#endif
+}
+
+// 센서 종류별로 미리 만들어 둔 레코드 조각
+//   head:  { "table": "<table>", "dt":
+//   value: , "<field>":
+typedef struct {
+    char head[64];
+    size_t head_len;
+    char value[40];
+    size_t value_len;
+} RecordTemplate;
+
+static RecordTemplate templates[SENSOR_KIND_COUNT];
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static void build_templates(void) {
+    build_pow10();
+    for (int kind = 0; kind < SENSOR_KIND_COUNT; kind++) {
+        RecordTemplate* t = &templates[kind];
+        t->head_len = snprintf(t->head, sizeof(t->head), "{ \"table\": \"%s\", \"dt\": ", protocol_kind_table(kind));
+        t->value_len = snprintf(t->value, sizeof(t->value), ", \"%s\": ", protocol_kind_field(kind));
+    }
+}
+
+#define APPEND_LITERAL(p, s) (memcpy((p), (s), sizeof(s) - 1), (p) + sizeof(s) - 1)
+
+static char* append_int64(char* p, int64_t value) {
+    char digits[20];
+    int n = 0;
+    uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+
+    if (value < 0) {
+        *p++ = '-';
+    }
+    while (n > 0) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+#ifdef __SIZEOF_INT128__
+static int bit_length(u128 v) {
+    int n = 0;
+    while (v > 0) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+}
+
+// q + rem/divisor를 가장 가까운 정수로, 정확히 중간이면 짝수 쪽으로
+static u128 round_even(u128 q, u128 rem, u128 divisor) {
+    if (rem * 2 > divisor || (rem * 2 == divisor && (q & 1))) {
+        q++;
+    }
+    return q;
+}
+
+static bool scaled_digits(uint32_t m, int e, int s, u128* out) {
+    if (s >= 0) {
+        if (s > 31) {
+            return false;   // m * 10^s가 128비트를 넘음
+        }
+        u128 num = (u128)m * pow10_table[s];
+        if (e >= 0) {
+            if (bit_length(num) + e > 127) {
+                return false;
+            }
+            *out = num << e;
+        } else {
+            int shift = -e;
+            if (shift > 126) {
+                return false;
+            }
+            u128 divisor = (u128)1 << shift;
+            *out = round_even(num >> shift, num & (divisor - 1), divisor);
+        }
+    } else {
+        if (-s > 38 || e < 0 || e > 103) {
+            return false;
+        }
+        u128 num = (u128)m << e;
+        u128 divisor = pow10_table[-s];
+        *out = round_even(num / divisor, num % divisor, divisor);
+    }
+    return true;
+}
+
+// float 값의 %.17g를 정수 연산으로 정확히 계산 (값 = m * 2^e, m < 2^24)
+// 유효숫자 17자리 D = round(값 * 10^s)를 128비트로 구하고 반올림은 printf와 같이 짝수 쪽으로
+// 범위를 벗어나면 -1 (호출자가 snprintf 사용)
+static int format_float_g17(char* out, double value) {
+    float f = (float)value;
+    uint32_t bits;
+
+    memcpy(&bits, &f, sizeof(bits));
+    int biased = (bits >> 23) & 0xFF;
+    if ((double)f != value || biased == 0 || biased == 0xFF) {
+        return -1;      // float가 아닌 double, 0, 비정규수, inf/nan
+    }
+
+    uint32_t m = (bits & 0x7FFFFF) | 0x800000;
+    int e = biased - 150;
+    int e10 = (int)floor(log10(fabs(value)));
+    u128 digits = 0;
+
+    // log10 추정이 한 자리 어긋날 수 있어 D가 17자리가 될 때까지 보정
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (!scaled_digits(m, e, 16 - e10, &digits)) {
+            return -1;
+        }
+        if (digits >= pow10_table[17]) {
+            e10++;
+        } else if (digits < pow10_table[16]) {
+            e10--;
+        } else {
+            break;
+        }
+    }
+    if (digits < pow10_table[16] || digits >= pow10_table[17]) {
+        return -1;
+    }
+
+    char d[17];
+    uint64_t v = (uint64_t)digits;
+    for (int i = 16; i >= 0; i--) {
+        d[i] = '0' + v % 10;
+        v /= 10;
+    }
+    int last = 16;      // 끝의 0은 %g처럼 생략
+    while (last > 0 && d[last] == '0') {
+        last--;
+    }
+
+    char* p = out;
+    if (bits >> 31) {
+        *p++ = '-';
+    }
+
+    if (e10 < -4 || e10 >= 17) {
+        *p++ = d[0];
+        if (last > 0) {
+            *p++ = '.';
+            memcpy(p, d + 1, last);
+            p += last;
+        }
+        *p++ = 'e';
+        *p++ = e10 < 0 ? '-' : '+';
+        int x = e10 < 0 ? -e10 : e10;
+        if (x >= 100) {
+            *p++ = '0' + x / 100;
+        }
+        *p++ = '0' + (x / 10) % 10;
+        *p++ = '0' + x % 10;
+    } else if (e10 >= 0) {
+        memcpy(p, d, e10 + 1);
+        p += e10 + 1;
+        if (last > e10) {
+            *p++ = '.';
+            memcpy(p, d + e10 + 1, last - e10);
+            p += last - e10;
+        }
+    } else {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = 0; i < -e10 - 1; i++) {
+            *p++ = '0';
+        }
+        memcpy(p, d, last + 1);
+        p += last + 1;
+    }
+    return p - out;
+}
+#else
+// 128비트 정수가 없는 32비트 ARM: 항상 snprintf
+static int format_float_g17(char* out, double value) {
+    (void)out;
+    (void)value;
+    return -1;
+}
+#endif
+
+// json-c의 double 출력과 같은 규칙: %.17g, 정수처럼 보이면 ".0"을 붙임
+static char* append_double(char* p, double value) {
+    if (isnan(value)) {
+        return APPEND_LITERAL(p, "NaN");
+    }
+    if (isinf(value)) {
+        return value > 0 ? APPEND_LITERAL(p, "Infinity") : APPEND_LITERAL(p, "-Infinity");
+    }
+
+    int len = format_float_g17(p, value);
+    if (len < 0) {
+        len = snprintf(p, 32, "%.17g", value);
+    }
+    bool looks_numeric = isdigit((unsigned char)p[0]) || (len > 1 && p[0] == '-' && isdigit((unsigned char)p[1]));
+    if (looks_numeric && !memchr(p, '.', len) && !memchr(p, 'e', len)) {
+        p[len++] = '.';
+        p[len++] = '0';
+    }
+    return p + len;
+}
+
+size_t batch_json_encode(char* buf, size_t capacity, const WireRecord* records, int count) {
+    pthread_once(&init_once, build_templates);
+
+    if (capacity < BATCH_JSON_MAX_OVERHEAD + (size_t)count * BATCH_JSON_MAX_RECORD) {
+        return 0;
+    }
+
+    int64_t base_ts = count > 0 ? records[0].timestamp_us : 0;
+    for (int i = 1; i < count; i++) {
+        if (records[i].timestamp_us < base_ts) {
+            base_ts = records[i].timestamp_us;
+        }
+    }
+
+    char* p = buf;
+    p = APPEND_LITERAL(p, "{ \"type\": \"batch\", \"base_ts\": ");
+    p = append_int64(p, base_ts);
+    p = APPEND_LITERAL(p, ", \"readings\": [");
+
+    for (int i = 0; i < count; i++) {
+        const RecordTemplate* t = &templates[records[i].kind < SENSOR_KIND_COUNT ? records[i].kind : 0];
+
+        if (i > 0) {
+            *p++ = ',';
+        }
+        *p++ = ' ';
+        memcpy(p, t->head, t->head_len);
+        p += t->head_len;
+        p = append_int64(p, records[i].timestamp_us - base_ts);
+        p = APPEND_LITERAL(p, ", \"sensor_id\": ");
+        p = append_int64(p, records[i].sensor_id);
+        memcpy(p, t->value, t->value_len);
+        p += t->value_len;
+        p = append_double(p, records[i].value);
+        p = APPEND_LITERAL(p, ", \"voltage\": ");
+        p = append_double(p, records[i].voltage);
+        p = APPEND_LITERAL(p, ", \"quality\": ");
+        p = append_int64(p, records[i].quality);
+        p = APPEND_LITERAL(p, " }");
+    }
+
+    p = APPEND_LITERAL(p, " ] }");
+    *p = '\0';
+    return p - buf;
+}
@@ -0,0 +1,18 @@
+#ifndef BATCH_JSON_H
+#define BATCH_JSON_H
+
+#include <stddef.h>
+#include "protocol.h"
+
+// 업링크 배치 JSON 직렬화 (json-c 없이 호출자 버퍼에 바로 기록, 할당 없음)
+// json_object_to_json_string()이 만드는 문서와 바이트 단위로 같음:
+//   { "type": "batch", "base_ts": ..., "readings": [ { "table": ..., "dt": ..., ... }, ... ] }
+
+// 레코드 한 건의 최대 길이 (버퍼 크기 계산용)
+#define BATCH_JSON_MAX_RECORD 256
+#define BATCH_JSON_MAX_OVERHEAD 80
+
+// 기록한 길이(NUL 제외)를 반환, 버퍼가 모자라면 0
+size_t batch_json_encode(char* buf, size_t capacity, const WireRecord* records, int count);
+
+#endif
@@ -1,13 +1,498 @@
 #include "config.h"
 #include "logger.h"
+#include "readings.h"
 #include <json-c/json.h>
+#include <stdlib.h>
 #include <string.h>
 
 static AppConfig app_config;
 
+static void set_default_config(void) {
+    strncpy(app_config.network.endpoints[0].host, DEFAULT_SERVER_HOST, sizeof(app_config.network.endpoints[0].host) - 1);
+    app_config.network.endpoints[0].port = PORT;
+    app_config.network.endpoint_count = 1;
+    app_config.network.shard_by = NETWORK_SHARD_CHANNEL;
+    app_config.network.timeout_seconds = DEFAULT_NETWORK_TIMEOUT;
+    app_config.network.max_retries = MAX_RETRIES;
+    app_config.network.binary_protocol = true;
+    app_config.network.compress = true;
+    app_config.network.node_id = 0;
+    app_config.network.reconnect_min_ms = DEFAULT_RECONNECT_MIN_MS;
+    app_config.network.reconnect_max_ms = DEFAULT_RECONNECT_MAX_MS;
+    app_config.network.keepalive_idle_s = DEFAULT_KEEPALIVE_IDLE_S;
+    app_config.network.keepalive_interval_s = DEFAULT_KEEPALIVE_INTERVAL_S;
+    app_config.network.keepalive_count = DEFAULT_KEEPALIVE_COUNT;
+    app_config.network.user_timeout_ms = DEFAULT_USER_TIMEOUT_MS;
+    strncpy(app_config.network.interface, DEFAULT_NETWORK_INTERFACE, sizeof(app_config.network.interface) - 1);
+    app_config.network.route_wait_ms = DEFAULT_ROUTE_WAIT_MS;
+    app_config.network.link_reset_failures = DEFAULT_LINK_RESET_FAILURES;
+    app_config.network.clock_sync_interval_s = DEFAULT_CLOCK_SYNC_INTERVAL_S;
+
+    app_config.realtime.enabled = false;
+    app_config.realtime.fifo_priority = DEFAULT_RT_PRIORITY;
+    app_config.realtime.acquisition_cpu = -1;
+    app_config.realtime.uplink_cpu = -1;
+    app_config.realtime.lock_memory = false;
+    app_config.realtime.prefault_stack_kb = DEFAULT_PREFAULT_STACK_KB;
+    app_config.realtime.thread_stack_kb = 0;
+    app_config.realtime.jitter_report_interval = DEFAULT_JITTER_REPORT_INTERVAL;
+
+    app_config.watchdog.stall_multiplier = DEFAULT_STALL_MULTIPLIER;
+    app_config.watchdog.min_stall_ms = DEFAULT_MIN_STALL_MS;
+    app_config.watchdog.recover = true;
+    app_config.watchdog.max_restarts = DEFAULT_MAX_RESTARTS;
+
+    app_config.shm_export.enabled = true;
+    strncpy(app_config.shm_export.name, DEFAULT_SHM_NAME, sizeof(app_config.shm_export.name) - 1);
+
+    app_config.ingest.enabled = true;
+    strncpy(app_config.ingest.name, DEFAULT_INGEST_NAME, sizeof(app_config.ingest.name) - 1);
+    app_config.ingest.drain_interval_ms = DEFAULT_INGEST_INTERVAL_MS;
+
+    app_config.uplink.max_batch_records = DEFAULT_UPLINK_BATCH_RECORDS;
+    app_config.uplink.linger_ms = DEFAULT_UPLINK_LINGER_MS;
+    app_config.uplink.queue_size = DEFAULT_UPLINK_QUEUE_SIZE;
+    app_config.uplink.overflow_policy = UPLINK_OVERFLOW_SPILL;
+    app_config.uplink.ack_window = DEFAULT_UPLINK_ACK_WINDOW;
+    app_config.uplink.backpressure.enabled = true;
+    app_config.uplink.backpressure.target_rtt_ms = DEFAULT_BACKPRESSURE_TARGET_RTT_MS;
+    app_config.uplink.backpressure.max_linger_ms = DEFAULT_BACKPRESSURE_MAX_LINGER_MS;
+    app_config.uplink.backpressure.max_divisor = DEFAULT_BACKPRESSURE_MAX_DIVISOR;
+    app_config.uplink.backpressure.critical_kinds = 1u << SENSOR_KIND_WATER_LEVEL;    // 넘침/바닥 경보
+    // 기존 서버는 계단형 행을 구분하지 못하므로 기본은 꺼 둠
+    app_config.uplink.deadband.enabled = false;
+    app_config.uplink.deadband.heartbeat_s = DEFAULT_DEADBAND_HEARTBEAT_S;
+    app_config.uplink.deadband.bands[SENSOR_KIND_WATER_LEVEL].absolute = 0.5f;     // %
+    app_config.uplink.deadband.bands[SENSOR_KIND_PH].absolute = 0.02f;
+    app_config.uplink.deadband.bands[SENSOR_KIND_TEMPERATURE].absolute = 0.1f;     // °C
+    app_config.uplink.deadband.bands[SENSOR_KIND_CONDUCTIVITY].percent = 1.0f;
+    app_config.uplink.deadband.bands[SENSOR_KIND_ILLUMINANCE].percent = 5.0f;
+    app_config.uplink.aggregate.enabled = false;
+    app_config.uplink.aggregate.window_s = DEFAULT_AGGREGATE_WINDOW_S;
+    app_config.uplink.aggregate.raw = true;
+    // 경보 한계 기본값은 대시보드의 tb_sensor_settings 기본값과 같게
+    PriorityConfig* priority = &app_config.uplink.priority;
+    priority->enabled = true;
+    priority->queue_size = DEFAULT_PRIORITY_QUEUE_SIZE;
+    priority->max_batch_records = DEFAULT_PRIORITY_BATCH_RECORDS;
+    priority->linger_ms = DEFAULT_PRIORITY_LINGER_MS;
+    priority->limits[SENSOR_KIND_WATER_LEVEL] = (AlarmLimit){ .has_low = true, .low = 10.0f };
+    priority->limits[SENSOR_KIND_PH] = (AlarmLimit){ .has_low = true, .low = 6.0f, .has_high = true, .high = 8.0f };
+    priority->limits[SENSOR_KIND_TEMPERATURE] =
+        (AlarmLimit){ .has_low = true, .low = 20.0f, .has_high = true, .high = 30.0f };
+    priority->limits[SENSOR_KIND_ILLUMINANCE] = (AlarmLimit){ .has_high = true, .high = 1000.0f };
+
+    app_config.spool.enabled = true;
+    strncpy(app_config.spool.path, DEFAULT_SPOOL_PATH, sizeof(app_config.spool.path) - 1);
+    app_config.spool.size_kb = DEFAULT_SPOOL_SIZE_KB;
+    app_config.spool.drain_rate = DEFAULT_SPOOL_DRAIN_RATE;
+
+    app_config.live.enabled = false;
+    strncpy(app_config.live.address, DEFAULT_LIVE_ADDRESS, sizeof(app_config.live.address) - 1);
+    app_config.live.port = DEFAULT_LIVE_PORT;
+    app_config.live.ttl = DEFAULT_LIVE_TTL;
+    app_config.live.coalesce_ms = DEFAULT_LIVE_COALESCE_MS;
+
+    app_config.relay.enabled = false;
+    app_config.relay.port = PORT;
+    app_config.relay.max_nodes = DEFAULT_RELAY_MAX_NODES;
+    app_config.relay.queue_size = DEFAULT_RELAY_QUEUE_SIZE;
+}
+
+// "host" 또는 "host:port" (포트가 없으면 default_port)
+static void parse_endpoint(const char* spec, int default_port, NetworkEndpoint* out) {
+    const char* colon = strrchr(spec, ':');
+    size_t host_len = colon ? (size_t)(colon - spec) : strlen(spec);
+
+    if (host_len >= sizeof(out->host)) {
+        host_len = sizeof(out->host) - 1;
+    }
+    memcpy(out->host, spec, host_len);
+    out->host[host_len] = '\0';
+    out->port = colon ? atoi(colon + 1) : default_port;
+}
+
+static void load_network_config(struct json_object* network_obj) {
+    struct json_object *host_obj, *port_obj, *timeout_obj, *retries_obj, *servers_obj, *shard_obj;
+    NetworkConfig* network = &app_config.network;
+
+    // 단일 서버 (이전 설정 형식)
+    if (json_object_object_get_ex(network_obj, "port", &port_obj)) {
+        network->endpoints[0].port = json_object_get_int(port_obj);
+    }
+    if (json_object_object_get_ex(network_obj, "host", &host_obj)) {
+        strncpy(network->endpoints[0].host, json_object_get_string(host_obj), sizeof(network->endpoints[0].host) - 1);
+    }
+
+    // 서버 목록: ["10.0.0.5:8080", "ingest-2", ...] (포트를 생략하면 "port" 값)
+    if (json_object_object_get_ex(network_obj, "servers", &servers_obj)) {
+        int default_port = network->endpoints[0].port;
+        int count = json_object_array_length(servers_obj);
+        if (count > NETWORK_MAX_ENDPOINTS) {
+            log_error("Too many uplink servers (%d), using the first %d", count, NETWORK_MAX_ENDPOINTS);
+            count = NETWORK_MAX_ENDPOINTS;
+        }
+        if (count > 0) {
+            memset(network->endpoints, 0, sizeof(network->endpoints));
+            for (int i = 0; i < count; i++) {
+                parse_endpoint(json_object_get_string(json_object_array_get_idx(servers_obj, i)), default_port,
+                               &network->endpoints[i]);
+            }
+            network->endpoint_count = count;
+        }
+    }
+
+    if (json_object_object_get_ex(network_obj, "shard_by", &shard_obj)) {
+        network->shard_by = strcmp(json_object_get_string(shard_obj), "node") == 0
+                            ? NETWORK_SHARD_NODE : NETWORK_SHARD_CHANNEL;
+    }
+
+    if (json_object_object_get_ex(network_obj, "timeout", &timeout_obj)) {
+        network->timeout_seconds = json_object_get_int(timeout_obj);
+    }
+
+    if (json_object_object_get_ex(network_obj, "max_retries", &retries_obj)) {
+        network->max_retries = json_object_get_int(retries_obj);
+    }
+
+    struct json_object *protocol_obj, *node_obj;
+    if (json_object_object_get_ex(network_obj, "protocol", &protocol_obj)) {
+        // "compressed"(기본) | "binary" | "json"
+        const char* protocol = json_object_get_string(protocol_obj);
+        network->binary_protocol = strcmp(protocol, "json") != 0;
+        network->compress = strcmp(protocol, "compressed") == 0;
+    }
+
+    if (json_object_object_get_ex(network_obj, "node_id", &node_obj)) {
+        network->node_id = (uint32_t)json_object_get_int64(node_obj);
+    }
+
+    struct json_object *obj;
+    if (json_object_object_get_ex(network_obj, "reconnect_min_ms", &obj)) {
+        network->reconnect_min_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "reconnect_max_ms", &obj)) {
+        network->reconnect_max_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "keepalive_idle", &obj)) {
+        network->keepalive_idle_s = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "keepalive_interval", &obj)) {
+        network->keepalive_interval_s = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "keepalive_count", &obj)) {
+        network->keepalive_count = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "user_timeout_ms", &obj)) {
+        network->user_timeout_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "interface", &obj)) {
+        strncpy(network->interface, json_object_get_string(obj), sizeof(network->interface) - 1);
+    }
+    if (json_object_object_get_ex(network_obj, "route_wait_ms", &obj)) {
+        network->route_wait_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "link_reset_failures", &obj)) {
+        network->link_reset_failures = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(network_obj, "clock_sync_interval", &obj)) {
+        network->clock_sync_interval_s = json_object_get_int(obj);
+    }
+}
+
+static void load_realtime_config(struct json_object* rt_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(rt_obj, "enabled", &obj)) {
+        app_config.realtime.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "fifo_priority", &obj)) {
+        app_config.realtime.fifo_priority = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "acquisition_cpu", &obj)) {
+        app_config.realtime.acquisition_cpu = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "uplink_cpu", &obj)) {
+        app_config.realtime.uplink_cpu = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "lock_memory", &obj)) {
+        app_config.realtime.lock_memory = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "prefault_stack_kb", &obj)) {
+        app_config.realtime.prefault_stack_kb = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "thread_stack_kb", &obj)) {
+        app_config.realtime.thread_stack_kb = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(rt_obj, "jitter_report_interval", &obj)) {
+        app_config.realtime.jitter_report_interval = json_object_get_int(obj);
+    }
+}
+
+static void load_watchdog_config(struct json_object* wd_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(wd_obj, "stall_multiplier", &obj)) {
+        app_config.watchdog.stall_multiplier = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(wd_obj, "min_stall_ms", &obj)) {
+        app_config.watchdog.min_stall_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(wd_obj, "recover", &obj)) {
+        app_config.watchdog.recover = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(wd_obj, "max_restarts", &obj)) {
+        app_config.watchdog.max_restarts = json_object_get_int(obj);
+    }
+}
+
+static void load_shm_export_config(struct json_object* shm_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(shm_obj, "enabled", &obj)) {
+        app_config.shm_export.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(shm_obj, "name", &obj)) {
+        strncpy(app_config.shm_export.name, json_object_get_string(obj), sizeof(app_config.shm_export.name) - 1);
+    }
+}
+
+static void load_ingest_config(struct json_object* ingest_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(ingest_obj, "enabled", &obj)) {
+        app_config.ingest.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(ingest_obj, "name", &obj)) {
+        strncpy(app_config.ingest.name, json_object_get_string(obj), sizeof(app_config.ingest.name) - 1);
+    }
+    if (json_object_object_get_ex(ingest_obj, "drain_interval_ms", &obj)) {
+        app_config.ingest.drain_interval_ms = json_object_get_int(obj);
+    }
+}
+
+static void load_backpressure_config(struct json_object* bp_obj) {
+    struct json_object *obj;
+    BackpressureConfig* bp = &app_config.uplink.backpressure;
+
+    if (json_object_object_get_ex(bp_obj, "enabled", &obj)) {
+        bp->enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(bp_obj, "target_rtt_ms", &obj)) {
+        bp->target_rtt_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(bp_obj, "max_linger_ms", &obj)) {
+        bp->max_linger_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(bp_obj, "max_divisor", &obj)) {
+        bp->max_divisor = json_object_get_int(obj);
+    }
+    // 줄이지 않을 센서 종류: ["water_level", "ph", ...]
+    if (json_object_object_get_ex(bp_obj, "critical", &obj)) {
+        bp->critical_kinds = 0;
+        for (int i = 0; i < (int)json_object_array_length(obj); i++) {
+            const char* name = json_object_get_string(json_object_array_get_idx(obj, i));
+            int kind = readings_kind_from_name(name);
+            if (kind < 0) {
+                log_error("Unknown sensor kind in backpressure.critical: %s", name);
+                continue;
+            }
+            bp->critical_kinds |= 1u << kind;
+        }
+    }
+}
+
+// "bands": { "water_level": { "absolute": 0.5 }, "conductivity": { "percent": 1 }, ... }
+static void load_deadband_config(struct json_object* db_obj) {
+    struct json_object *obj;
+    DeadbandConfig* db = &app_config.uplink.deadband;
+
+    if (json_object_object_get_ex(db_obj, "enabled", &obj)) {
+        db->enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(db_obj, "heartbeat_s", &obj)) {
+        db->heartbeat_s = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(db_obj, "bands", &obj)) {
+        json_object_object_foreach(obj, name, band_obj) {
+            int kind = readings_kind_from_name(name);
+            if (kind < 0) {
+                log_error("Unknown sensor kind in deadband.bands: %s", name);
+                continue;
+            }
+            struct json_object *value;
+            if (json_object_object_get_ex(band_obj, "absolute", &value)) {
+                db->bands[kind].absolute = json_object_get_double(value);
+            }
+            if (json_object_object_get_ex(band_obj, "percent", &value)) {
+                db->bands[kind].percent = json_object_get_double(value);
+            }
+        }
+    }
+}
+
+static void load_aggregate_config(struct json_object* agg_obj) {
+    struct json_object *obj;
+    AggregateConfig* agg = &app_config.uplink.aggregate;
+
+    if (json_object_object_get_ex(agg_obj, "enabled", &obj)) {
+        agg->enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(agg_obj, "window_s", &obj)) {
+        agg->window_s = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(agg_obj, "raw", &obj)) {
+        agg->raw = json_object_get_boolean(obj);
+    }
+}
+
+// "limits": { "water_level": { "low": 10, "hysteresis": 0.5 }, "ph": { "low": 6, "high": 8 }, ... }
+// 종류를 적으면 그 종류의 기본 한계는 지우고 적은 값만 씀
+static void load_priority_config(struct json_object* priority_obj) {
+    struct json_object *obj;
+    PriorityConfig* priority = &app_config.uplink.priority;
+
+    if (json_object_object_get_ex(priority_obj, "enabled", &obj)) {
+        priority->enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(priority_obj, "queue_size", &obj)) {
+        priority->queue_size = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(priority_obj, "max_batch_records", &obj)) {
+        priority->max_batch_records = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(priority_obj, "linger_ms", &obj)) {
+        priority->linger_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(priority_obj, "limits", &obj)) {
+        json_object_object_foreach(obj, name, limit_obj) {
+            int kind = readings_kind_from_name(name);
+            if (kind < 0) {
+                log_error("Unknown sensor kind in priority.limits: %s", name);
+                continue;
+            }
+            AlarmLimit* limit = &priority->limits[kind];
+            struct json_object *value;
+            memset(limit, 0, sizeof(AlarmLimit));
+            if (json_object_object_get_ex(limit_obj, "low", &value)) {
+                limit->has_low = true;
+                limit->low = json_object_get_double(value);
+            }
+            if (json_object_object_get_ex(limit_obj, "high", &value)) {
+                limit->has_high = true;
+                limit->high = json_object_get_double(value);
+            }
+            if (json_object_object_get_ex(limit_obj, "hysteresis", &value)) {
+                limit->hysteresis = json_object_get_double(value);
+            }
+        }
+    }
+}
+
+static void load_uplink_config(struct json_object* uplink_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(uplink_obj, "max_batch_records", &obj)) {
+        app_config.uplink.max_batch_records = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "linger_ms", &obj)) {
+        app_config.uplink.linger_ms = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "queue_size", &obj)) {
+        app_config.uplink.queue_size = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "overflow_policy", &obj)) {
+        const char* policy = json_object_get_string(obj);
+        if (strcmp(policy, "drop_oldest") == 0) {
+            app_config.uplink.overflow_policy = UPLINK_OVERFLOW_DROP_OLDEST;
+        } else if (strcmp(policy, "spill") == 0) {
+            app_config.uplink.overflow_policy = UPLINK_OVERFLOW_SPILL;
+        } else if (strcmp(policy, "coalesce") == 0) {
+            app_config.uplink.overflow_policy = UPLINK_OVERFLOW_COALESCE;
+        } else {
+            log_error("Unknown uplink overflow_policy: %s", policy);
+        }
+    }
+    if (json_object_object_get_ex(uplink_obj, "ack_window", &obj)) {
+        app_config.uplink.ack_window = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "backpressure", &obj)) {
+        load_backpressure_config(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "deadband", &obj)) {
+        load_deadband_config(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "aggregate", &obj)) {
+        load_aggregate_config(obj);
+    }
+    if (json_object_object_get_ex(uplink_obj, "priority", &obj)) {
+        load_priority_config(obj);
+    }
+}
+
+static void load_spool_config(struct json_object* spool_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(spool_obj, "enabled", &obj)) {
+        app_config.spool.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(spool_obj, "path", &obj)) {
+        strncpy(app_config.spool.path, json_object_get_string(obj), sizeof(app_config.spool.path) - 1);
+    }
+    if (json_object_object_get_ex(spool_obj, "size_kb", &obj)) {
+        app_config.spool.size_kb = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(spool_obj, "drain_rate", &obj)) {
+        app_config.spool.drain_rate = json_object_get_int(obj);
+    }
+}
+
+static void load_live_config(struct json_object* live_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(live_obj, "enabled", &obj)) {
+        app_config.live.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(live_obj, "address", &obj)) {
+        strncpy(app_config.live.address, json_object_get_string(obj), sizeof(app_config.live.address) - 1);
+    }
+    if (json_object_object_get_ex(live_obj, "port", &obj)) {
+        app_config.live.port = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(live_obj, "ttl", &obj)) {
+        app_config.live.ttl = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(live_obj, "coalesce_ms", &obj)) {
+        app_config.live.coalesce_ms = json_object_get_int(obj);
+    }
+}
+
+static void load_relay_config(struct json_object* relay_obj) {
+    struct json_object *obj;
+
+    if (json_object_object_get_ex(relay_obj, "enabled", &obj)) {
+        app_config.relay.enabled = json_object_get_boolean(obj);
+    }
+    if (json_object_object_get_ex(relay_obj, "port", &obj)) {
+        app_config.relay.port = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(relay_obj, "max_nodes", &obj)) {
+        app_config.relay.max_nodes = json_object_get_int(obj);
+    }
+    if (json_object_object_get_ex(relay_obj, "queue_size", &obj)) {
+        app_config.relay.queue_size = json_object_get_int(obj);
+    }
+}
+
+const AppConfig* get_app_config(void) {
+    return &app_config;
+}
+
 bool load_config(const char* config_file) {
     struct json_object *root;
     
+    set_default_config();
+
     root = json_object_from_file(config_file);
     if (!root) {
         log_error("Failed to load config file: %s", config_file);
@@ -17,24 +502,7 @@ bool load_config(const char* config_file) {
     // 네트워크 설정 로드
     struct json_object *network_obj;
     if (json_object_object_get_ex(root, "network", &network_obj)) {
-        struct json_object *host_obj, *port_obj, *timeout_obj, *retries_obj;
-        
-        if (json_object_object_get_ex(network_obj, "host", &host_obj)) {
-            const char* host = json_object_get_string(host_obj);
-            app_config.network.host = strdup(host);
-        }
-        
-        if (json_object_object_get_ex(network_obj, "port", &port_obj)) {
-            app_config.network.port = json_object_get_int(port_obj);
-        }
-        
-        if (json_object_object_get_ex(network_obj, "timeout", &timeout_obj)) {
-            app_config.network.timeout_seconds = json_object_get_int(timeout_obj);
-        }
-        
-        if (json_object_object_get_ex(network_obj, "max_retries", &retries_obj)) {
-            app_config.network.max_retries = json_object_get_int(retries_obj);
-        }
+        load_network_config(network_obj);
     }
 
     // 센서 보정 데이터 로드
@@ -79,6 +547,54 @@ bool load_config(const char* config_file) {
         }
     }
 
+    // 실시간 스케줄링 설정 로드
+    struct json_object *realtime_obj;
+    if (json_object_object_get_ex(root, "realtime", &realtime_obj)) {
+        load_realtime_config(realtime_obj);
+    }
+
+    // 워치독 설정 로드
+    struct json_object *watchdog_obj;
+    if (json_object_object_get_ex(root, "watchdog", &watchdog_obj)) {
+        load_watchdog_config(watchdog_obj);
+    }
+
+    // 공유 메모리 내보내기 설정 로드
+    struct json_object *shm_obj;
+    if (json_object_object_get_ex(root, "shm_export", &shm_obj)) {
+        load_shm_export_config(shm_obj);
+    }
+
+    // 보조 센서 수집 설정 로드
+    struct json_object *ingest_obj;
+    if (json_object_object_get_ex(root, "ingest", &ingest_obj)) {
+        load_ingest_config(ingest_obj);
+    }
+
+    // 업링크 배치 설정 로드
+    struct json_object *uplink_obj;
+    if (json_object_object_get_ex(root, "uplink", &uplink_obj)) {
+        load_uplink_config(uplink_obj);
+    }
+
+    // 업링크 스풀 설정 로드
+    struct json_object *spool_obj;
+    if (json_object_object_get_ex(root, "spool", &spool_obj)) {
+        load_spool_config(spool_obj);
+    }
+
+    // UDP 최신값 채널 설정 로드
+    struct json_object *live_obj;
+    if (json_object_object_get_ex(root, "live", &live_obj)) {
+        load_live_config(live_obj);
+    }
+
+    // 게이트웨이 중계 설정 로드
+    struct json_object *relay_obj;
+    if (json_object_object_get_ex(root, "relay", &relay_obj)) {
+        load_relay_config(relay_obj);
+    }
+
     json_object_put(root);
     return true;
 } 
\ No newline at end of file
@@ -1,11 +1,31 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <stdbool.h>
+#include "types.h"
+
 // 네트워크 설정
 #define PORT 8080
 #define MAX_IP_LENGTH 16
 #define MAX_RETRIES 3
-#define RECONNECT_DELAY 1  // seconds
+#define DEFAULT_SERVER_HOST "127.0.0.1"
+#define DEFAULT_NETWORK_TIMEOUT 5  // seconds
+
+// 재연결 백오프와 끊긴 서버 감지 (Wi-Fi 순단 뒤 빨리 알아채고 다시 붙되, 노드들이 한꺼번에 몰리지 않게)
+#define DEFAULT_RECONNECT_MIN_MS 500
+#define DEFAULT_RECONNECT_MAX_MS 60000
+#define DEFAULT_KEEPALIVE_IDLE_S 10
+#define DEFAULT_KEEPALIVE_INTERVAL_S 5
+#define DEFAULT_KEEPALIVE_COUNT 3
+#define DEFAULT_USER_TIMEOUT_MS 20000
+
+// 시작 경로: 인터페이스를 매번 내렸다 올리지 않고 경로가 생길 때까지만 기다림, 재설정은 연결 실패가 계속될 때만
+#define DEFAULT_NETWORK_INTERFACE "wlan0"
+#define DEFAULT_ROUTE_WAIT_MS 3000
+#define DEFAULT_LINK_RESET_FAILURES 10
+
+// 서버 시계 기준 오프셋 측정 (NTP 없는 격리망에서 노드 사이 시각 정렬용)
+#define DEFAULT_CLOCK_SYNC_INTERVAL_S 10
 
 // 센서 설정
 #define NUM_SENSORS 4
@@ -36,14 +56,198 @@
 #define DEFAULT_LOG_LEVEL LOG_LEVEL_INFO
 #define LOG_FILE_PATH "/var/log/water_monitor.log"
 
+// 실시간 스케줄링 기본값
+#define DEFAULT_RT_PRIORITY 50
+#define DEFAULT_PREFAULT_STACK_KB 64
+#define DEFAULT_JITTER_REPORT_INTERVAL 60  // seconds
+
+// 실시간 스케줄링 설정 (측정 스레드의 지연 상한 보장용)
+typedef struct {
+    bool enabled;
+    int fifo_priority;          // 측정 스레드의 SCHED_FIFO 우선순위 (1~99)
+    int acquisition_cpu;        // 측정 스레드를 고정할 CPU (-1이면 고정 안 함)
+    int uplink_cpu;             // 업링크 스레드를 고정할 CPU (-1이면 고정 안 함)
+    bool lock_memory;           // mlockall로 페이지 폴트 방지
+    int prefault_stack_kb;      // 스레드 시작 시 미리 접근해 둘 스택 크기
+    int thread_stack_kb;        // 스레드 스택 크기 (0이면 시스템 기본값)
+    int jitter_report_interval; // 지터 리포트 주기 (초, 0이면 종료 시에만)
+} RealtimeConfig;
+
+// 워치독 기본값
+#define DEFAULT_STALL_MULTIPLIER 3
+#define DEFAULT_MIN_STALL_MS 5000
+#define DEFAULT_MAX_RESTARTS 3
+
+// 워치독 설정 (하트비트가 멈춘 스레드 감지 및 복구)
+typedef struct {
+    int stall_multiplier;       // 주기의 몇 배 동안 하트비트가 없으면 정지로 판단할지
+    int min_stall_ms;           // 정지 판단 최소 시간 (짧은 주기 스레드의 오탐 방지)
+    bool recover;               // 정지 단계에 맞는 복구 동작(ADC/소켓 재설정) 실행 여부
+    int max_restarts;           // 연속 재시작 한도 (초과 시 프로세스 종료로 상위 감시자에 맡김)
+} WatchdogConfig;
+
+// 공유 메모리 내보내기 설정 (같은 보드의 다른 프로세스용)
+#define DEFAULT_SHM_NAME "/water_monitor"
+
+typedef struct {
+    bool enabled;
+    char name[64];              // shm_open 이름 (/dev/shm 아래)
+} ShmExportConfig;
+
+// 보조 센서 수집 링 설정
+#define DEFAULT_INGEST_NAME "/water_monitor_ingest"
+#define DEFAULT_INGEST_INTERVAL_MS 1000
+
+typedef struct {
+    bool enabled;
+    char name[64];              // shm_open 이름 (/dev/shm 아래)
+    int drain_interval_ms;      // 링을 비우고 채널별 평균을 업링크하는 주기
+} IngestConfig;
+
+// 업링크 배치 설정
+#define UPLINK_MAX_BATCH 64             // 한 프레임에 담을 수 있는 최대 측정값 수
+#define DEFAULT_UPLINK_BATCH_RECORDS 32
+#define DEFAULT_UPLINK_LINGER_MS 200
+
+#define UPLINK_MAX_QUEUE 4096            // 큐 크기 상한 (2의 거듭제곱)
+#define DEFAULT_UPLINK_QUEUE_SIZE 256
+
+// 서버가 커밋을 확인하기 전까지 메모리에 보관하는 프레임 수 (차면 새 측정값은 스풀로)
+#define DEFAULT_UPLINK_ACK_WINDOW 32
+
+// 측정 스레드 → 업링크 스레드 큐가 가득 찼을 때의 처리
+typedef enum {
+    UPLINK_OVERFLOW_DROP_OLDEST = 0,    // 가장 오래된 측정값을 버리고 새 값을 넣음
+    UPLINK_OVERFLOW_SPILL,              // 새 값을 디스크 스풀에 기록 (스풀이 바쁘면 drop_oldest)
+    UPLINK_OVERFLOW_COALESCE            // 채널별 최신값 하나만 따로 보관
+} UplinkOverflowPolicy;
+
+// 적응형 배압: 서버 RTT나 큐 깊이가 늘면 배치/linger를 키우고 비핵심 채널의 업링크 비율을 낮춤
+#define DEFAULT_BACKPRESSURE_TARGET_RTT_MS 200
+#define DEFAULT_BACKPRESSURE_MAX_LINGER_MS 2000
+#define DEFAULT_BACKPRESSURE_MAX_DIVISOR 8
+
+typedef struct {
+    bool enabled;
+    int target_rtt_ms;          // 서버 RTT(또는 배치 전송 시간)가 이보다 길면 부하로 판단
+    int max_linger_ms;          // 부하 시 linger를 늘릴 상한
+    int max_divisor;            // 비핵심 채널을 최대 몇 분의 1까지 줄일지 (1이면 줄이지 않음)
+    uint32_t critical_kinds;    // 줄이지 않는 센서 종류 비트마스크 (1 << SensorKind)
+} BackpressureConfig;
+
+// 예외 보고(deadband): 마지막으로 보낸 값에서 벗어났거나 하트비트 주기가 지났을 때만 업링크
+// 서버는 다음 행까지 값이 유지된 것으로 보고 계단형 시계열을 복원
+#define DEFAULT_DEADBAND_HEARTBEAT_S 300
+
+typedef struct {
+    float absolute;             // 마지막으로 보낸 값과의 차이가 이보다 크면 전송 (0이면 사용 안 함)
+    float percent;              // 마지막으로 보낸 값 대비 변화율(%)이 이보다 크면 전송 (0이면 사용 안 함)
+} DeadbandBand;
+
+typedef struct {
+    bool enabled;
+    int heartbeat_s;            // 값이 그대로여도 이 주기마다 한 번은 전송
+    DeadbandBand bands[SENSOR_KIND_COUNT];
+} DeadbandConfig;
+
+// 구간 집계: 채널마다 구간(기본 1분)의 min/max/mean/last를 요약 레코드 하나로 업링크
+// raw를 끄면 요약만 보냄 (대역폭이 좁은 원격지용, 구간 안의 급변은 min/max로 남음)
+#define DEFAULT_AGGREGATE_WINDOW_S 60
+
+typedef struct {
+    bool enabled;
+    int window_s;               // 요약 구간 길이 (벽시계 기준으로 정렬)
+    bool raw;                   // 요약과 함께 개별 측정값도 업링크
+} AggregateConfig;
+
+// 우선 차선: 경보 한계를 넘나드는 측정값은 별도 큐에 넣어 bulk 배치·스풀 재전송·요약보다 먼저 보냄
+#define DEFAULT_PRIORITY_QUEUE_SIZE 64
+#define DEFAULT_PRIORITY_BATCH_RECORDS 8
+#define DEFAULT_PRIORITY_LINGER_MS 0
+
+typedef struct {
+    bool has_low;
+    float low;
+    bool has_high;
+    float high;
+    float hysteresis;           // 경보 해제에 필요한 여유 (한계 근처에서 경보가 반복되지 않도록)
+} AlarmLimit;
+
+typedef struct {
+    bool enabled;
+    int queue_size;             // 경보 큐 크기 (2의 거듭제곱으로 올림, 가득 차면 가장 오래된 경보를 버림)
+    int max_batch_records;
+    int linger_ms;              // 0이면 경보가 들어오는 즉시 전송
+    AlarmLimit limits[SENSOR_KIND_COUNT];
+} PriorityConfig;
+
+typedef struct {
+    int max_batch_records;      // 이만큼 모이면 바로 전송
+    int linger_ms;              // 첫 측정값이 들어온 뒤 최대 대기 시간
+    int queue_size;             // 측정 스레드 → 업링크 스레드 큐 크기 (2의 거듭제곱으로 올림)
+    UplinkOverflowPolicy overflow_policy;
+    int ack_window;             // 확인 대기 프레임 수 (서버가 확인 응답을 협상한 연결에만 적용, network.node_id 필요)
+    BackpressureConfig backpressure;
+    DeadbandConfig deadband;
+    AggregateConfig aggregate;
+    PriorityConfig priority;
+} UplinkConfig;
+
+// 업링크 장애 시 측정값을 디스크에 보관하는 스풀 설정
+#define DEFAULT_SPOOL_PATH "/var/lib/water_monitor/uplink.spool"
+#define DEFAULT_SPOOL_SIZE_KB 4096
+#define DEFAULT_SPOOL_DRAIN_RATE 50     // records/s
+
+typedef struct {
+    bool enabled;
+    char path[256];
+    int size_kb;                // 스풀 파일 크기 (가득 차면 가장 오래된 측정값부터 덮어씀)
+    int drain_rate;             // 복구 후 스풀을 비우는 최대 속도 (records/s)
+} SpoolConfig;
+
+// UDP 최신값 채널 설정 (대시보드/펌프 제어용, TCP 업링크와 별개)
+#define DEFAULT_LIVE_ADDRESS "239.255.87.77"   // 멀티캐스트 그룹 또는 유니캐스트 주소
+#define DEFAULT_LIVE_PORT 8081
+#define DEFAULT_LIVE_TTL 1                      // 멀티캐스트 홉 수 (1이면 같은 서브넷)
+#define DEFAULT_LIVE_COALESCE_MS 5
+
+typedef struct {
+    bool enabled;
+    char address[64];
+    int port;
+    int ttl;
+    int coalesce_ms;            // 측정 스레드 알림 후 다른 스레드의 같은 주기 값을 기다리는 시간
+} LiveConfig;
+
+// 게이트웨이 중계: 주변 노드의 업링크 연결을 같은 프로토콜로 받아 자기 배치에 합쳐 한 연결로 올려 보냄
+// (건물마다 게이트웨이 하나가 서버에 붙어 서버 연결 수가 노드 수 대신 게이트웨이 수가 됨)
+#define DEFAULT_RELAY_MAX_NODES 64
+#define DEFAULT_RELAY_QUEUE_SIZE 1024
+
+typedef struct {
+    bool enabled;
+    int port;                   // 하위 노드가 접속할 포트 (노드 설정에는 서버 대신 게이트웨이 주소)
+    int max_nodes;              // 동시에 받을 하위 노드 연결 수 (노드별 중복 확인 상태도 이만큼 보관)
+    int queue_size;             // 업링크 스레드가 가져가기 전까지 중계 레코드를 쌓아 두는 큐 (차면 스풀로)
+} RelayConfig;
+
 // JSON 설정 파일에서 로드할 수 있도록 변경
 typedef struct {
     NetworkConfig network;
     SensorCalibration calibrations[NUM_SENSORS];
     int log_level;
     char log_file[256];
+    RealtimeConfig realtime;
+    WatchdogConfig watchdog;
+    ShmExportConfig shm_export;
+    IngestConfig ingest;
+    UplinkConfig uplink;
+    SpoolConfig spool;
+    LiveConfig live;
+    RelayConfig relay;
 } AppConfig;
 
 bool load_config(const char* config_file);
+const AppConfig* get_app_config(void);
 
 #endif 
\ No newline at end of file
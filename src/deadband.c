@@ -0,0 +1,80 @@
+#include "deadband.h"
+#include "readings.h"
+#include "logger.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+// 채널별 마지막으로 보낸 값 (채널당 생산자 하나라 잠금 없음)
+typedef struct {
+    bool sent;
+    float value;
+    uint32_t quality;
+    int64_t timestamp_us;
+} DeadbandState;
+
+static DeadbandConfig deadband_config;
+static DeadbandState states[NUM_CHANNELS];
+static _Atomic uint64_t suppressed_count;
+
+void deadband_init(const DeadbandConfig* config) {
+    memcpy(&deadband_config, config, sizeof(DeadbandConfig));
+    memset(states, 0, sizeof(states));
+    if (deadband_config.heartbeat_s <= 0) {
+        deadband_config.heartbeat_s = DEFAULT_DEADBAND_HEARTBEAT_S;
+    }
+
+    if (deadband_config.enabled) {
+        log_info("Deadband enabled (heartbeat %d s)", deadband_config.heartbeat_s);
+    }
+}
+
+// 마지막으로 보낸 값에서 deadband를 벗어났는지
+static bool outside_band(const DeadbandBand* band, float last, float value) {
+    float delta = fabsf(value - last);
+    if (band->absolute <= 0 && band->percent <= 0) {
+        return delta > 0;           // 대역이 없으면 값이 바뀔 때마다 전송
+    }
+    if (band->absolute > 0 && delta > band->absolute) {
+        return true;
+    }
+    return band->percent > 0 && delta > fabsf(last) * band->percent / 100.0f;
+}
+
+bool deadband_filter(const Reading* reading, Reading* out) {
+    *out = *reading;
+
+    SensorKind kind;
+    int sensor_id;
+    if (!deadband_config.enabled || reading->channel < 0 || reading->channel >= NUM_CHANNELS ||
+        !readings_channel_info(reading->channel, &kind, &sensor_id)) {
+        return true;
+    }
+
+    DeadbandState* state = &states[reading->channel];
+    int64_t heartbeat_us = (int64_t)deadband_config.heartbeat_s * 1000000;
+
+    if (state->sent && reading->quality == state->quality && !isnan(reading->value)) {
+        bool moved = outside_band(&deadband_config.bands[kind], state->value, reading->value);
+        bool silent_too_long = reading->timestamp_us - state->timestamp_us >= heartbeat_us;
+
+        if (!moved && !silent_too_long) {
+            atomic_fetch_add_explicit(&suppressed_count, 1, memory_order_relaxed);
+            return false;
+        }
+        if (!moved) {
+            out->quality |= READING_QUALITY_HEARTBEAT;
+        }
+    }
+
+    out->quality |= READING_QUALITY_DEADBAND;
+    state->sent = true;
+    state->value = reading->value;
+    state->quality = reading->quality;
+    state->timestamp_us = reading->timestamp_us;
+    return true;
+}
+
+uint64_t deadband_suppressed(void) {
+    return atomic_load_explicit(&suppressed_count, memory_order_relaxed);
+}
@@ -0,0 +1,23 @@
+#ifndef DEADBAND_H
+#define DEADBAND_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "config.h"
+
+// 업링크 앞단의 예외 보고(report-by-exception) 단계
+// 채널마다 마지막으로 보낸 값을 기억해 두고 그 값에서 deadband(절대값 또는 %)를 벗어났거나
+// 품질이 바뀌었거나 하트비트 주기가 지났을 때만 통과시킴. 통과한 값에는 READING_QUALITY_DEADBAND를
+// 붙여 서버가 다음 행까지 값이 유지된 것(계단형)으로 해석하게 함
+
+void deadband_init(const DeadbandConfig* config);
+
+// 보낼 값이면 플래그를 붙여 out에 쓰고 true, 걸러졌으면 false
+// 채널별 생산자는 한 스레드뿐이어야 함 (uplink_submit과 같은 조건)
+bool deadband_filter(const Reading* reading, Reading* out);
+
+// 걸러진 측정값 수 (실행 중 누적)
+uint64_t deadband_suppressed(void);
+
+#endif
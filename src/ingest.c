@@ -0,0 +1,259 @@
+#include "ingest.h"
+#include "wm_shm.h"
+#include "readings.h"
+#include "shm_export.h"
+#include "live.h"
+#include "uplink.h"
+#include "logger.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 생산자가 칸을 확보한 뒤 이 시간 안에 기록을 끝내지 않으면 건너뛸 수 있는지 확인
+// (아직 칸을 차지하지 않았거나 차지한 생산자가 종료됐을 때만: 느릴 뿐인 생산자는 기다림)
+#define INGEST_STUCK_CELL_MS 1000
+
+static WmIngestSegment* segment = NULL;
+static char segment_name[64];
+static int64_t stuck_since_us = 0;
+static bool stuck_reported = false;
+static bool channel_named[NUM_CHANNELS];
+
+// 센서 종류별 허용 범위 (범위 밖의 값은 업링크 전에 버림)
+static const struct {
+    float min;
+    float max;
+} kind_ranges[SENSOR_KIND_COUNT] = {
+    [SENSOR_KIND_WATER_LEVEL] = { 0.0f, 100.0f },
+    [SENSOR_KIND_PH] = { 0.0f, 14.0f },
+    [SENSOR_KIND_TEMPERATURE] = { -20.0f, 80.0f },
+    [SENSOR_KIND_CONDUCTIVITY] = { 0.0f, 20000.0f },
+    [SENSOR_KIND_ILLUMINANCE] = { 0.0f, 200000.0f },
+};
+
+// 수집 주기 동안 채널별로 모으는 값
+typedef struct {
+    int count;
+    float value_sum;
+    float voltage_sum;
+    int64_t last_timestamp_us;
+    uint32_t quality;
+} ChannelWindow;
+
+bool ingest_init(const char* name) {
+    strncpy(segment_name, name, sizeof(segment_name) - 1);
+    shm_unlink(segment_name);
+
+    int fd = shm_open(segment_name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (fd < 0) {
+        log_error("shm_open(%s) failed: %s", segment_name, strerror(errno));
+        return false;
+    }
+
+    // 다른 사용자로 실행되는 센서 프로그램도 쓸 수 있도록 umask와 무관하게 권한 설정
+    fchmod(fd, 0666);
+
+    if (ftruncate(fd, sizeof(WmIngestSegment)) != 0) {
+        log_error("ftruncate(%s) failed: %s", segment_name, strerror(errno));
+        close(fd);
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    segment = mmap(NULL, sizeof(WmIngestSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        log_error("mmap(%s) failed: %s", segment_name, strerror(errno));
+        segment = NULL;
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    memset(segment, 0, sizeof(WmIngestSegment));
+    segment->version = WM_INGEST_VERSION;
+    segment->segment_size = sizeof(WmIngestSegment);
+    segment->ring_size = WM_INGEST_RING_SIZE;
+    for (uint64_t i = 0; i < WM_INGEST_RING_SIZE; i++) {
+        atomic_init(&segment->cells[i].seq, i);
+        atomic_init(&segment->cells[i].owner, WM_INGEST_OWNER(0, i));
+    }
+    atomic_store_explicit(&segment->state, WM_SHM_STATE_ACTIVE, memory_order_relaxed);
+    atomic_store_explicit(&segment->magic, WM_INGEST_MAGIC, memory_order_release);
+
+    log_info("Ingest ring ready: /dev/shm%s (%d records)", segment_name, WM_INGEST_RING_SIZE);
+    return true;
+}
+
+// 칸을 다음 바퀴의 생산자에게 돌려줌 (owner를 먼저 비워 두어야 다음 생산자가 차지할 수 있음)
+static void release_cell(WmIngestCell* cell, uint64_t pos) {
+    uint64_t next = pos + WM_INGEST_RING_SIZE;
+
+    atomic_store_explicit(&cell->owner, WM_INGEST_OWNER(0, next), memory_order_relaxed);
+    atomic_store_explicit(&cell->seq, next, memory_order_release);
+    atomic_store_explicit(&segment->dequeue_pos, pos + 1, memory_order_relaxed);
+    stuck_since_us = 0;
+    stuck_reported = false;
+}
+
+// 기록이 끝나지 않은 칸을 건너뛸 수 있으면 true
+// 아직 아무도 차지하지 않은 칸은 CAS로 다음 바퀴에 넘김: 늦게 온 생산자는 owner CAS가 실패해 기록하지 않음
+// 차지한 생산자가 있으면 그 프로세스가 종료됐을 때만 (살아 있으면 느릴 뿐이므로 기다림)
+static bool abandon_cell(WmIngestCell* cell, uint64_t pos) {
+    uint64_t owner = WM_INGEST_OWNER(0, pos);
+    if (atomic_compare_exchange_strong_explicit(&cell->owner, &owner, WM_INGEST_OWNER(0, pos + WM_INGEST_RING_SIZE),
+                                                memory_order_acq_rel, memory_order_acquire)) {
+        return true;
+    }
+
+    pid_t pid = WM_INGEST_OWNER_PID(owner);
+    if (kill(pid, 0) < 0 && errno == ESRCH) {
+        return true;
+    }
+    if (!stuck_reported) {
+        stuck_reported = true;
+        log_error("Ingest: record %llu still being written by pid %d, waiting",
+                  (unsigned long long)pos, (int)pid);
+    }
+    return false;
+}
+
+// 단일 소비자 꺼내기 (데몬의 수집 스레드만 호출)
+static bool pop_record(WmIngestRecord* out) {
+    uint64_t pos = atomic_load_explicit(&segment->dequeue_pos, memory_order_relaxed);
+    WmIngestCell* cell = &segment->cells[pos & (WM_INGEST_RING_SIZE - 1)];
+    uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+    if (seq != pos + 1) {
+        // 확보만 되고 기록이 끝나지 않은 칸이 오래 남아 있으면 건너뛸 수 있는지 확인
+        if (atomic_load_explicit(&segment->enqueue_pos, memory_order_relaxed) > pos) {
+            int64_t now = reading_timestamp_now();
+            if (stuck_since_us == 0) {
+                stuck_since_us = now;
+            } else if (now - stuck_since_us > INGEST_STUCK_CELL_MS * 1000LL && abandon_cell(cell, pos)) {
+                log_error("Ingest: skipping record %llu abandoned by its producer", (unsigned long long)pos);
+                release_cell(cell, pos);
+            }
+        }
+        return false;
+    }
+
+    *out = cell->record;
+    release_cell(cell, pos);
+    return true;
+}
+
+static bool record_in_range(const WmIngestRecord* record) {
+    if (record->kind >= SENSOR_KIND_COUNT || !isfinite(record->value) || !isfinite(record->voltage)) {
+        return false;
+    }
+    return record->value >= kind_ranges[record->kind].min && record->value <= kind_ranges[record->kind].max;
+}
+
+static int channel_for(const WmIngestRecord* record) {
+    int channel = readings_register_channel((SensorKind)record->kind, record->sensor_id);
+    if (channel < 0) {
+        return -1;
+    }
+
+    if (!channel_named[channel]) {
+        channel_named[channel] = true;
+        shm_export_set_channel_name(channel, readings_channel_name(channel));
+        log_info("Ingest: channel %d assigned to %s (pid %d)",
+                 channel, readings_channel_name(channel), record->producer_pid);
+    }
+    return channel;
+}
+
+void* ingest_thread(void* arg) {
+    ChannelWindow windows[NUM_AUX_CHANNELS];
+    WmIngestRecord record;
+    int drained = 0, filtered = 0, unassigned = 0;
+    (void)arg;
+
+    if (!segment) {
+        return NULL;
+    }
+
+    memset(windows, 0, sizeof(windows));
+
+    while (drained < WM_INGEST_RING_SIZE && pop_record(&record)) {
+        drained++;
+
+        if (!record_in_range(&record)) {
+            filtered++;
+            continue;
+        }
+
+        int channel = channel_for(&record);
+        if (channel < 0) {
+            unassigned++;
+            continue;
+        }
+
+        // 최신값은 바로 게시 (제어/상태 조회용)
+        Reading reading = {
+            .channel = channel,
+            .value = record.value,
+            .voltage = record.voltage,
+            .timestamp_us = record.timestamp_us,
+            .quality = record.quality
+        };
+        readings_publish(&reading);
+        shm_export_publish(&reading);
+
+        ChannelWindow* window = &windows[channel - CHANNEL_AUX_BASE];
+        window->count++;
+        window->value_sum += record.value;
+        window->voltage_sum += record.voltage;
+        window->quality |= record.quality;
+        if (record.timestamp_us > window->last_timestamp_us) {
+            window->last_timestamp_us = record.timestamp_us;
+        }
+    }
+
+    if (drained > filtered + unassigned) {
+        live_notify();
+    }
+
+    if (filtered > 0 || unassigned > 0) {
+        log_debug("Ingest: %d records drained, %d out of range, %d without a free channel",
+                  drained, filtered, unassigned);
+    }
+
+    // 채널별로 주기당 한 건만 업링크
+    for (int i = 0; i < NUM_AUX_CHANNELS; i++) {
+        if (windows[i].count == 0) {
+            continue;
+        }
+
+        int channel = CHANNEL_AUX_BASE + i;
+        Reading summary = {
+            .channel = channel,
+            .value = windows[i].value_sum / windows[i].count,
+            .voltage = windows[i].voltage_sum / windows[i].count,
+            .timestamp_us = windows[i].last_timestamp_us,
+            .quality = windows[i].quality
+        };
+        if (!uplink_submit(&summary)) {
+            log_error("Failed to queue ingested data for %s", readings_channel_name(channel));
+        }
+    }
+
+    return NULL;
+}
+
+void ingest_cleanup(void) {
+    if (!segment) {
+        return;
+    }
+
+    atomic_store_explicit(&segment->state, WM_SHM_STATE_CLOSED, memory_order_release);
+    munmap(segment, sizeof(WmIngestSegment));
+    segment = NULL;
+    shm_unlink(segment_name);
+}
@@ -0,0 +1,16 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <stdbool.h>
+
+// 보조 센서 프로그램(libwm_ingest)이 기록할 공유 메모리 수집 링 생성
+bool ingest_init(const char* name);
+
+// 수집 스레드 함수 (한 주기): 링을 비우고 범위를 벗어난 값은 거른 뒤,
+// 최신값은 바로 게시하고 채널별 평균 한 건씩 업링크 배치에 추가
+void* ingest_thread(void* arg);
+
+// 수집 링을 종료 상태로 표시하고 해제
+void ingest_cleanup(void);
+
+#endif
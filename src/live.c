@@ -0,0 +1,201 @@
+#include "live.h"
+#include "readings.h"
+#include "protocol.h"
+#include "logger.h"
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <arpa/inet.h>
+#include <linux/futex.h>
+
+// 알림이 없어도 이 주기로 깨어나 하트비트를 남김
+#define LIVE_IDLE_WAIT_MS 100
+
+#define LIVE_PACKET_SIZE (PROTOCOL_HEADER_SIZE + PROTOCOL_LIVE_HEADER_SIZE + \
+                          PROTOCOL_BATCH_HEADER_SIZE + NUM_CHANNELS * PROTOCOL_RECORD_SIZE)
+
+static int live_socket = -1;
+static LiveConfig live_config;
+static uint32_t live_node_id = 0;
+static uint32_t live_seq = 0;
+
+static _Atomic uint32_t wake_word __attribute__((aligned(64)));    // 최신값 스레드를 깨우는 futex 워드
+static uint32_t handled_wake = 0;   // 최신값 스레드 전용
+
+static _Atomic uint64_t sent_count;
+static _Atomic uint64_t error_count;
+static bool send_failing = false;
+
+bool live_init(const LiveConfig* config, uint32_t node_id) {
+    struct sockaddr_in addr = {0};
+
+    live_config = *config;
+    live_node_id = node_id;
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config->port);
+    if (inet_pton(AF_INET, config->address, &addr.sin_addr) <= 0) {
+        log_error("Invalid live address: %s", config->address);
+        return false;
+    }
+
+    live_socket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (live_socket < 0) {
+        log_error("Live socket creation failed: %s", strerror(errno));
+        return false;
+    }
+
+    // 벌크 업링크보다 먼저 나가도록 저지연 표시
+    int tos = IPTOS_LOWDELAY;
+    setsockopt(live_socket, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+
+    bool multicast = IN_MULTICAST(ntohl(addr.sin_addr.s_addr));
+    if (multicast) {
+        unsigned char ttl = config->ttl;
+        unsigned char loop = 1;     // 같은 보드의 구독자(pumpControl 등)도 받음
+        if (setsockopt(live_socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) < 0 ||
+            setsockopt(live_socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+            log_error("Live multicast setup failed: %s", strerror(errno));
+        }
+    }
+
+    // 목적지가 하나뿐이므로 connect로 고정 (전송마다 주소 조회 없음)
+    if (connect(live_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        log_error("Live socket connect failed: %s", strerror(errno));
+        close(live_socket);
+        live_socket = -1;
+        return false;
+    }
+
+    log_info("Live values: udp://%s:%d (%s)", config->address, config->port, multicast ? "multicast" : "unicast");
+    return true;
+}
+
+void live_notify(void) {
+    if (live_socket < 0) {
+        return;
+    }
+    atomic_fetch_add_explicit(&wake_word, 1, memory_order_release);
+    syscall(SYS_futex, &wake_word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+// 최신값 테이블을 와이어 레코드로 (가장 최근 측정을 맨 앞에 두어 배치 기준 시각으로 사용)
+static int collect_latest(WireRecord* records) {
+    Reading latest[NUM_CHANNELS];
+    int n = 0, newest = 0;
+
+    readings_snapshot(latest);
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        SensorKind kind;
+        int sensor_id;
+        if (latest[ch].timestamp_us == 0 || !readings_channel_info(ch, &kind, &sensor_id)) {
+            continue;   // 아직 측정값이 없거나 등록되지 않은 채널
+        }
+
+        records[n].channel = ch;
+        records[n].kind = kind;
+        records[n].sensor_id = sensor_id;
+        records[n].quality = latest[ch].quality;
+        records[n].timestamp_us = latest[ch].timestamp_us;
+        records[n].value = latest[ch].value;
+        records[n].voltage = latest[ch].voltage;
+        if (records[n].timestamp_us > records[newest].timestamp_us) {
+            newest = n;
+        }
+        n++;
+    }
+
+    if (newest != 0) {
+        WireRecord tmp = records[0];
+        records[0] = records[newest];
+        records[newest] = tmp;
+    }
+
+    // dt(i32 µs, 약 35분)를 넘게 멈춘 채널은 빼고 보냄
+    int kept = n > 0 ? 1 : 0;
+    for (int i = 1; i < n; i++) {
+        if (records[0].timestamp_us - records[i].timestamp_us <= INT32_MAX) {
+            records[kept++] = records[i];
+        }
+    }
+    return kept;
+}
+
+static void send_snapshot(void) {
+    WireRecord records[NUM_CHANNELS];
+    uint8_t packet[LIVE_PACKET_SIZE];
+
+    int count = collect_latest(records);
+    if (count == 0) {
+        return;
+    }
+
+    size_t len = protocol_encode_live(packet + PROTOCOL_HEADER_SIZE, sizeof(packet) - PROTOCOL_HEADER_SIZE,
+                                      live_node_id, live_seq++, records, count);
+    protocol_write_header(packet, FRAME_LIVE, len);
+
+    // 받는 쪽이 없거나(ECONNREFUSED) 송신 버퍼가 차면 이번 스냅샷은 버림 (다음 주기 값이 대신함)
+    if (send(live_socket, packet, PROTOCOL_HEADER_SIZE + len, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+        atomic_fetch_add_explicit(&error_count, 1, memory_order_relaxed);
+        if (!send_failing) {
+            log_error("Live snapshot send failed: %s", strerror(errno));
+            send_failing = true;
+        }
+        return;
+    }
+    if (send_failing) {
+        log_info("Live snapshots resumed");
+        send_failing = false;
+    }
+    atomic_fetch_add_explicit(&sent_count, 1, memory_order_relaxed);
+}
+
+void* live_thread(void* arg) {
+    (void)arg;
+
+    uint32_t wake = atomic_load_explicit(&wake_word, memory_order_acquire);
+    if (wake == handled_wake) {
+        struct timespec timeout = { .tv_sec = 0, .tv_nsec = LIVE_IDLE_WAIT_MS * 1000000L };
+        syscall(SYS_futex, &wake_word, FUTEX_WAIT_PRIVATE, wake, &timeout, NULL, 0);
+        if (atomic_load_explicit(&wake_word, memory_order_acquire) == handled_wake) {
+            return NULL;
+        }
+    }
+
+    // 같은 주기에 끝나는 다른 측정 스레드의 값까지 한 패킷에 담음
+    if (live_config.coalesce_ms > 0) {
+        struct timespec delay = {
+            .tv_sec = live_config.coalesce_ms / 1000,
+            .tv_nsec = (live_config.coalesce_ms % 1000) * 1000000L
+        };
+        nanosleep(&delay, NULL);
+    }
+    handled_wake = atomic_load_explicit(&wake_word, memory_order_acquire);
+
+    if (live_socket >= 0) {
+        send_snapshot();
+    }
+    return NULL;
+}
+
+void live_report_stats(void) {
+    if (live_socket < 0) {
+        return;
+    }
+    log_info("Live: %llu snapshots sent, %llu failed",
+             (unsigned long long)atomic_load_explicit(&sent_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&error_count, memory_order_relaxed));
+}
+
+void live_cleanup(void) {
+    if (live_socket >= 0) {
+        close(live_socket);
+        live_socket = -1;
+    }
+}
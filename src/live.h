@@ -0,0 +1,26 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+
+// UDP 최신값 채널: 측정 주기마다 모든 채널의 최신값을 데이터그램 하나로 보냄
+// 대시보드/펌프 제어처럼 "모든 값"이 아니라 "가장 새 값"이 필요한 쪽용이며,
+// 손실·재전송이 없으므로 TCP 업링크가 밀려 있어도 지연되지 않음 (기록은 여전히 TCP가 담당)
+
+// 소켓 준비 (주소가 멀티캐스트 그룹이면 TTL 설정), 실패하면 false
+bool live_init(const LiveConfig* config, uint32_t node_id);
+
+// 측정 스레드에서 호출: 한 주기의 측정을 마쳤음을 알림 (시스템 콜 하나, 기다리지 않음)
+void live_notify(void);
+
+// 최신값 스레드 함수 (한 주기): 알림을 기다렸다가 coalesce_ms 뒤 스냅샷 전송
+void* live_thread(void* arg);
+
+// 전송/실패 횟수 로그
+void live_report_stats(void);
+
+void live_cleanup(void);
+
+#endif
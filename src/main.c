@@ -11,6 +11,13 @@
 #include "water_level.h"
 #include "ph_sensor.h"
 #include "thread_manager.h"
+#include "realtime.h"
+#include "readings.h"
+#include "shm_export.h"
+#include "ingest.h"
+#include "uplink.h"
+#include "live.h"
+#include "relay.h"
 
 static volatile bool running = true;
 
@@ -22,33 +29,43 @@ static void signal_handler(int signum) {
     }
 }
 
-// 수위 모니터링 스레드 함수
+// 최신값 테이블에 게시 (제어 로직/상태 조회는 ADC나 DB 대신 이 값을 사용)
+// 유효한 측정값만 업링크 배치에 추가
+// 워치독이 버린 이전 스레드는 게시하지 않음 (채널마다 생산자는 교체된 새 스레드 하나)
+static void publish_reading(int channel, float value, float voltage, bool valid) {
+    if (thread_abandoned()) {
+        return;
+    }
+    Reading reading = {
+        .channel = channel,
+        .value = value,
+        .voltage = voltage,
+        .timestamp_us = reading_timestamp_now(),
+        .quality = valid ? READING_QUALITY_VALID : READING_QUALITY_LOW_SAMPLES
+    };
+    readings_publish(&reading);
+    shm_export_publish(&reading);
+
+    if (valid && !uplink_submit(&reading)) {
+        log_error("Failed to queue %s reading", readings_channel_name(channel));
+    }
+}
+
+// 수위 모니터링 스레드 함수 (한 주기 측정, 주기 타이밍은 thread_manager가 담당)
 static void* water_level_thread(void* arg) {
-    while (running) {
-        for (int i = 0; i < NUM_SENSORS; i++) {
-            SensorData data = read_sensor_with_filtering(i);
-            if (data.water_level >= 0) {  // 유효한 데이터인 경우
-                if (!send_sensor_data(&data)) {
-                    log_error("Failed to send water level data for sensor %d", i);
-                }
-            }
-        }
-        usleep(MEASUREMENT_INTERVAL * 1000000);
+    for (int i = 0; i < NUM_SENSORS && running && !thread_abandoned(); i++) {
+        SensorData data = read_sensor_with_filtering(i);
+        publish_reading(CHANNEL_WATER_LEVEL_BASE + i, data.water_level, data.voltage, data.voltage > 0);
     }
+    live_notify();
     return NULL;
 }
 
-// pH 모니터링 스레드 함수
+// pH 모니터링 스레드 함수 (한 주기 측정)
 static void* ph_thread(void* arg) {
-    while (running) {
-        PhData data = read_ph_with_filtering();
-        if (data.ph_value > 0) {  // 유효한 데이터인 경우
-            if (!send_ph_data(&data)) {
-                log_error("Failed to send pH data");
-            }
-        }
-        usleep(MEASUREMENT_INTERVAL * 1000000);
-    }
+    PhData data = read_ph_with_filtering();
+    publish_reading(CHANNEL_PH, data.ph_value, data.voltage, data.ph_value > 0);
+    live_notify();
     return NULL;
 }
 
@@ -70,6 +87,20 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    const AppConfig* app_config = get_app_config();
+
+    // 실시간 스케줄링/메모리 잠금 적용 (실패해도 측정은 계속하되 로그로 남김)
+    if (!realtime_init(&app_config->realtime)) {
+        log_error("Realtime settings were not fully applied");
+    }
+
+    readings_init();
+
+    // 같은 보드의 다른 프로세스(pumpControl 등)에 최신값 공개 (실패해도 측정은 계속)
+    if (app_config->shm_export.enabled && !shm_export_init(app_config->shm_export.name)) {
+        log_error("Shared memory export disabled");
+    }
+
     // ADC 초기화
     if (!adc_init()) {
         log_error("Failed to initialize ADC");
@@ -83,28 +114,83 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // 네트워크 초기화
-    NetworkConfig net_config = {
-        .host = "localhost",  // 설정 파일에서 로드한 값으로 대체
-        .port = PORT,
-        .timeout_seconds = 5,
-        .max_retries = 3
-    };
-    
-    if (!network_init(&net_config)) {
+    // 네트워크 초기화 (설정 파일의 서버 목록)
+    if (!network_init(&app_config->network)) {
         log_error("Failed to initialize network");
         ph_sensor_cleanup();
         adc_cleanup();
         return 1;
     }
 
+    if (!uplink_init(&app_config->uplink, &app_config->spool)) {
+        log_error("Failed to initialize uplink");
+        network_cleanup();
+        ph_sensor_cleanup();
+        adc_cleanup();
+        return 1;
+    }
+
+    // 최신값 UDP 채널 (실패해도 TCP 업링크는 그대로)
+    bool live_enabled = app_config->live.enabled && live_init(&app_config->live, app_config->network.node_id);
+    if (app_config->live.enabled && !live_enabled) {
+        log_error("Live value channel disabled");
+    }
+
+    // 게이트웨이 중계: 주변 노드의 업링크를 받아 이 노드의 업링크로 합침 (실패해도 자기 측정값은 그대로)
+    bool relay_enabled = app_config->relay.enabled && uplink_relay_init(app_config->relay.queue_size) &&
+                         relay_init(&app_config->relay);
+    if (app_config->relay.enabled && !relay_enabled) {
+        log_error("Relay mode disabled");
+    }
+
     // 시그널 핸들러 설정
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
     // 모니터링 스레드 추가
-    add_monitoring_thread(water_level_thread, NULL, MEASUREMENT_INTERVAL * 1000);
-    add_monitoring_thread(ph_thread, NULL, MEASUREMENT_INTERVAL * 1000);
+    add_monitoring_thread("water_level", water_level_thread, NULL, MEASUREMENT_INTERVAL * 1000);
+    add_monitoring_thread("ph", ph_thread, NULL, MEASUREMENT_INTERVAL * 1000);
+    add_monitoring_thread("uplink", uplink_thread, NULL, 0);
+    if (live_enabled) {
+        add_monitoring_thread("live", live_thread, NULL, 0);
+    }
+    if (relay_enabled) {
+        add_monitoring_thread("relay", relay_thread, NULL, 0);
+    }
+
+    // 보조 센서 프로그램의 측정값 수집 (각자 소켓을 여는 대신 데몬의 업링크 사용)
+    if (app_config->ingest.enabled) {
+        if (ingest_init(app_config->ingest.name)) {
+            add_monitoring_thread("ingest", ingest_thread, NULL, app_config->ingest.drain_interval_ms);
+        } else {
+            log_error("Sensor ingest disabled");
+        }
+    }
+
+    if (app_config->realtime.enabled) {
+        set_thread_realtime("water_level", app_config->realtime.fifo_priority,
+                            app_config->realtime.acquisition_cpu);
+        set_thread_realtime("ph", app_config->realtime.fifo_priority,
+                            app_config->realtime.acquisition_cpu);
+        set_thread_realtime("uplink", 0, app_config->realtime.uplink_cpu);
+    }
+
+    // 워치독: 하트비트가 멈춘 단계에 따라 ADC 재초기화 또는 소켓 리셋
+    // 업링크 스레드의 대기 하나(경로 대기, 연결 시도, 송신, 시계 측정)가 끝나기 전에 정지로 보지 않도록
+    // 정지 판단 최소 시간을 그보다 길게 (감시 주기 1초 + 여유)
+    WatchdogConfig watchdog = app_config->watchdog;
+    int network_wait_ms = app_config->network.timeout_seconds * 1000;
+    if (app_config->network.route_wait_ms > network_wait_ms) {
+        network_wait_ms = app_config->network.route_wait_ms;
+    }
+    if (watchdog.min_stall_ms < network_wait_ms + 2000) {
+        watchdog.min_stall_ms = network_wait_ms + 2000;
+        log_info("Watchdog stall limit raised to %d ms to cover network timeouts", watchdog.min_stall_ms);
+    }
+    configure_watchdog(&watchdog);
+    set_stage_recovery(STAGE_ADC_READ, adc_reinit);
+    set_stage_recovery(STAGE_UPLINK_CONNECT, network_reset);
+    set_stage_recovery(STAGE_UPLINK_SEND, network_reset);
 
     // 모니터링 시작
     if (!start_monitoring_threads()) {
@@ -118,16 +204,35 @@ int main(int argc, char* argv[]) {
     log_info("Water level and pH monitoring started");
 
     // 메인 루프
+    int jitter_report_interval = app_config->realtime.jitter_report_interval;
+    int seconds_since_report = 0;
     while (running) {
         if (!check_thread_health()) {
             log_error("Thread health check failed");
             break;
         }
+        if (jitter_report_interval > 0 && ++seconds_since_report >= jitter_report_interval) {
+            report_thread_jitter();
+            uplink_report_stats();
+            live_report_stats();
+            relay_report_stats();
+            seconds_since_report = 0;
+        }
         sleep(1);
     }
 
     // 정리
     stop_monitoring_threads();
+    report_thread_jitter();
+    relay_report_stats();
+    relay_cleanup();
+    uplink_flush();
+    uplink_report_stats();
+    uplink_cleanup();
+    live_report_stats();
+    live_cleanup();
+    ingest_cleanup();
+    shm_export_cleanup();
     network_cleanup();
     ph_sensor_cleanup();
     adc_cleanup();
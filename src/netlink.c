@@ -0,0 +1,238 @@
+#include "netlink.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#define NETLINK_BUFFER_SIZE 8192
+#define NETLINK_REPLY_TIMEOUT_MS 1000
+
+// 변경 알림이 없어도 이 간격으로 다시 확인 (이름 풀이는 DNS가 살아나야 되므로 알림과 어긋날 수 있음)
+#define ROUTE_RECHECK_MS 500
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// groups가 0이면 요청/응답용, 아니면 그 그룹의 변경 알림을 받는 소켓
+static int open_socket(unsigned int groups) {
+    int sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (sock < 0) {
+        log_error("Failed to open rtnetlink socket: %s", strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_nl local = { .nl_family = AF_NETLINK, .nl_groups = groups };
+    if (bind(sock, (struct sockaddr*)&local, sizeof(local)) < 0) {
+        log_error("Failed to bind rtnetlink socket: %s", strerror(errno));
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static void add_attr(struct nlmsghdr* nh, int type, const void* data, size_t len) {
+    struct rtattr* rta = (struct rtattr*)((char*)nh + NLMSG_ALIGN(nh->nlmsg_len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(len);
+    memcpy(RTA_DATA(rta), data, len);
+    nh->nlmsg_len = NLMSG_ALIGN(nh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+// 요청을 보내고 같은 seq의 응답 메시지를 buf 안에서 찾아 반환 (시간 안에 없으면 NULL)
+static struct nlmsghdr* transact(int sock, struct nlmsghdr* request, char* buf, size_t len) {
+    static uint32_t seq = 0;
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+
+    request->nlmsg_seq = ++seq;
+    if (sendto(sock, request, request->nlmsg_len, 0, (struct sockaddr*)&kernel, sizeof(kernel)) < 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        struct pollfd pfd = { .fd = sock, .events = POLLIN };
+        if (poll(&pfd, 1, NETLINK_REPLY_TIMEOUT_MS) <= 0) {
+            errno = ETIMEDOUT;
+            return NULL;
+        }
+        ssize_t n = recv(sock, buf, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NULL;
+        }
+
+        int remaining = (int)n;
+        for (struct nlmsghdr* nh = (struct nlmsghdr*)buf; NLMSG_OK(nh, remaining); nh = NLMSG_NEXT(nh, remaining)) {
+            if (nh->nlmsg_seq == request->nlmsg_seq) {
+                return nh;
+            }
+        }
+    }
+}
+
+static bool resolve_ipv4(const char* host, struct in_addr* addr) {
+    if (inet_pton(AF_INET, host, addr) == 1) {
+        return true;
+    }
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* result;
+    if (getaddrinfo(host, NULL, &hints, &result) != 0) {
+        return false;
+    }
+    *addr = ((struct sockaddr_in*)result->ai_addr)->sin_addr;
+    freeaddrinfo(result);
+    return true;
+}
+
+bool netlink_route_to(const char* host, char* ifname, size_t ifname_len) {
+    struct in_addr dst;
+    if (!resolve_ipv4(host, &dst)) {
+        return false;
+    }
+
+    int sock = open_socket(0);
+    if (sock < 0) {
+        return false;
+    }
+
+    // 커널 FIB 조회 (ip route get과 같음): 경로가 없으면 ENETUNREACH 오류 응답
+    struct {
+        struct nlmsghdr nh;
+        struct rtmsg rt;
+        char attrs[32];
+    } request;
+    char buf[NETLINK_BUFFER_SIZE];
+
+    memset(&request, 0, sizeof(request));
+    request.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+    request.nh.nlmsg_type = RTM_GETROUTE;
+    request.nh.nlmsg_flags = NLM_F_REQUEST;
+    request.rt.rtm_family = AF_INET;
+    request.rt.rtm_dst_len = 32;
+    add_attr(&request.nh, RTA_DST, &dst, sizeof(dst));
+
+    struct nlmsghdr* reply = transact(sock, &request.nh, buf, sizeof(buf));
+    close(sock);
+    if (!reply || reply->nlmsg_type != RTM_NEWROUTE) {
+        return false;
+    }
+
+    // 연결이 끊긴 Wi-Fi에도 주소와 경로는 남아 있을 수 있으므로 링크 상태(linkdown)도 봄
+    struct rtmsg* rt = NLMSG_DATA(reply);
+    if ((rt->rtm_type != RTN_UNICAST && rt->rtm_type != RTN_LOCAL) || (rt->rtm_flags & RTNH_F_LINKDOWN)) {
+        return false;
+    }
+
+    if (ifname && ifname_len > 0) {
+        ifname[0] = '\0';
+        int attr_len = RTM_PAYLOAD(reply);
+        for (struct rtattr* rta = RTM_RTA(rt); RTA_OK(rta, attr_len); rta = RTA_NEXT(rta, attr_len)) {
+            char name[IF_NAMESIZE];
+            if (rta->rta_type == RTA_OIF && if_indextoname(*(int*)RTA_DATA(rta), name)) {
+                snprintf(ifname, ifname_len, "%s", name);
+            }
+        }
+    }
+    return true;
+}
+
+int netlink_wait_for_route(const char* const* hosts, int count, int timeout_ms, char* ifname, size_t ifname_len) {
+    // 알림 소켓을 먼저 열어 확인과 대기 사이의 변경을 놓치지 않음
+    int events = open_socket(RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE);
+    int64_t deadline = monotonic_ms() + timeout_ms;
+    int found = -1;
+
+    for (;;) {
+        for (int i = 0; i < count && found < 0; i++) {
+            if (netlink_route_to(hosts[i], ifname, ifname_len)) {
+                found = i;
+            }
+        }
+        int64_t remaining = deadline - monotonic_ms();
+        if (found >= 0 || remaining <= 0) {
+            break;
+        }
+
+        int wait_ms = remaining < ROUTE_RECHECK_MS ? (int)remaining : ROUTE_RECHECK_MS;
+        if (events < 0) {
+            usleep(wait_ms * 1000);
+            continue;
+        }
+        struct pollfd pfd = { .fd = events, .events = POLLIN };
+        if (poll(&pfd, 1, wait_ms) > 0) {
+            // 알림 내용은 보지 않고 비운 뒤 경로를 다시 조회
+            char buf[NETLINK_BUFFER_SIZE];
+            while (recv(events, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+            }
+        }
+    }
+
+    if (events >= 0) {
+        close(events);
+    }
+    return found;
+}
+
+static bool set_link_up(int sock, int index, bool up) {
+    struct {
+        struct nlmsghdr nh;
+        struct ifinfomsg ifi;
+    } request;
+    char buf[NETLINK_BUFFER_SIZE];
+
+    memset(&request, 0, sizeof(request));
+    request.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.nh.nlmsg_type = RTM_NEWLINK;
+    request.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    request.ifi.ifi_family = AF_UNSPEC;
+    request.ifi.ifi_index = index;
+    request.ifi.ifi_change = IFF_UP;
+    request.ifi.ifi_flags = up ? IFF_UP : 0;
+
+    struct nlmsghdr* reply = transact(sock, &request.nh, buf, sizeof(buf));
+    if (!reply) {
+        return false;
+    }
+    if (reply->nlmsg_type == NLMSG_ERROR) {
+        struct nlmsgerr* err = NLMSG_DATA(reply);
+        if (err->error != 0) {
+            errno = -err->error;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool netlink_reset_link(const char* ifname) {
+    unsigned int index = if_nametoindex(ifname);
+    if (index == 0) {
+        log_error("Network interface %s not found", ifname);
+        return false;
+    }
+
+    int sock = open_socket(0);
+    if (sock < 0) {
+        return false;
+    }
+    bool reset = set_link_up(sock, index, false) && set_link_up(sock, index, true);
+    if (!reset) {
+        log_error("Failed to reset network interface %s: %s", ifname, strerror(errno));
+    }
+    close(sock);
+    return reset;
+}
@@ -0,0 +1,21 @@
+#ifndef NETLINK_H
+#define NETLINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// rtnetlink로 링크/주소/경로 상태를 확인하고 링크를 재설정
+// (ifconfig/dhclient를 부르지 않음: 주소는 시스템의 DHCP 클라이언트가 관리)
+
+// 서버 주소로 가는 경로 확인: 경로가 있고 나가는 링크가 살아 있으면(linkdown이 아니면) true
+// ifname에 나가는 인터페이스 이름 (NULL이면 생략)
+bool netlink_route_to(const char* host, char* ifname, size_t ifname_len);
+
+// hosts 중 하나로 가는 경로가 생길 때까지 링크·주소·경로 변경 알림을 기다림 (최대 timeout_ms)
+// 경로가 생기면 그 호스트의 번호, 시간 안에 생기지 않으면 -1
+int netlink_wait_for_route(const char* const* hosts, int count, int timeout_ms, char* ifname, size_t ifname_len);
+
+// 링크를 내렸다 올림 (Wi-Fi 연결이 멈췄을 때의 마지막 수단, CAP_NET_ADMIN 필요)
+bool netlink_reset_link(const char* ifname);
+
+#endif
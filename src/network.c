@@ -1,17 +1,103 @@
+#define _GNU_SOURCE
 #include "network.h"
 #include "logger.h"
+#include "thread_manager.h"
+#include "protocol.h"
+#include "config.h"
+#include "netlink.h"
+#include "readings.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <fcntl.h>
 #include <errno.h>
-#include <json-c/json.h>
 #include <time.h>
+#include <pthread.h>
+#include <poll.h>
+#include <net/if.h>
+
+// 커널 송신 버퍼에 쌓아 둘 미전송 데이터 상한: 서버가 느리면 커널 안에 숨지 않고 전송 시간과
+// 업링크 큐 깊이로 드러나 배압 판단에 쓰임
+#define NOTSENT_LOWAT_BYTES (16 * 1024)
+
+// 시계 오프셋: 최소 RTT를 고를 최근 표본 수와 연결 직후 연달아 재는 횟수
+#define CLOCK_WINDOW 8
+#define CLOCK_BURST 4
+
+// 서버마다 해시 링에 올리는 가상 노드 수 (서버가 빠질 때 그 몫이 나머지에 고르게 흩어지도록)
+#define RING_REPLICAS 64
+
+typedef struct {
+    int64_t offset_us;          // 서버 시각 - 노드 시각
+    int64_t rtt_us;
+} ClockSample;
+
+// 서버별 연결과 상태
+typedef struct {
+    NetworkEndpoint address;
+    ConnectionState connection;
+    int64_t retry_at_ms;        // 백오프 중이면 이 시각(단조 시계) 전에는 재연결·라우팅하지 않음
+    bool binary_rejected;       // 서버가 HELLO에 응답하지 않았음 (구버전): 재연결 때 협상을 건너뜀
+    bool ever_connected;        // 재연결 횟수 집계용
+    int64_t down_since_ms;      // 끊긴 시각 (0이면 정상): 다운타임 집계와 상태 변화 로그용
+
+    // 확인 응답 (PROTOCOL_FEATURE_ACK)
+    uint64_t next_seq;          // 다음 데이터 프레임의 seq (이 서버로 가는 스트림에서 단조 증가)
+    uint64_t acked_seq;         // 서버가 커밋을 확인한 마지막 seq
+    uint32_t generation;        // 연결에 성공할 때마다 증가 (확인 전에 끊긴 프레임 판별용)
+    uint8_t rx[PROTOCOL_HEADER_SIZE + PROTOCOL_TIME_REPLY_SIZE];  // 읽다 만 FRAME_ACK / FRAME_TIME_REPLY
+    size_t rx_len;
+
+    // 시계 오프셋 (PROTOCOL_FEATURE_CLOCK): 재연결해도 같은 서버 시계이므로 표본은 유지
+    ClockSample clock_samples[CLOCK_WINDOW];
+    int clock_sample_count;
+    int clock_next;
+    int64_t clock_pending_t1;   // 답을 기다리는 TIME_REQUEST의 t1 (0이면 없음)
+    int64_t clock_offset_us;    // 최근 표본 중 RTT가 가장 짧은 것
+    int64_t clock_rtt_us;
+    int64_t clock_due_ms;       // 다음 주기 측정 시각 (단조 시계)
+
+    // 재연결 통계 (stats_mutex)
+    uint64_t reconnects;
+    uint64_t connect_failures;
+    uint64_t dead_peers;
+    uint64_t downtime_ms;
+} Endpoint;
+
+typedef struct {
+    uint32_t hash;
+    int endpoint;
+} RingPoint;
 
-static ConnectionState connection = {0};
 static NetworkConfig network_config;
+static Endpoint endpoints[NETWORK_MAX_ENDPOINTS];
+static int endpoint_count = 0;
+static RingPoint ring[NETWORK_MAX_ENDPOINTS * RING_REPLICAS];
+static int ring_size = 0;
+
+// 여러 측정/수집 스레드가 같은 연결로 전송하므로 연결 관리와 전송을 직렬화
+static pthread_mutex_t send_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 통계는 연결 시도 중에도 읽을 수 있도록 따로 보호 (send_mutex는 connect 제한 시간만큼 잡혀 있을 수 있음)
+static pthread_mutex_t stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 백오프 지터용 (send_mutex 안에서만 사용)
+static unsigned int jitter_seed;
+
+// 어느 서버와도 연결하지 못한 연속 시도 수 (send_mutex): link_reset_failures에 이르면 인터페이스 재설정
+static int link_failures = 0;
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
 static bool set_socket_nonblocking(int sock) {
     int flags = fcntl(sock, F_GETFL, 0);
@@ -26,160 +112,889 @@ static bool set_socket_nonblocking(int sock) {
     return true;
 }
 
+// iovec 배열을 모두 보낼 때까지 sendmsg 반복 (부분 전송 시 남은 부분부터 이어서)
+// 송신 버퍼가 차면 timeout_seconds까지만 쓸 수 있기를 기다림: 넘으면 ETIMEDOUT으로 실패해
+// 멈춘 서버가 send_mutex를 잡은 채 업링크와 경보 레인을 TCP_USER_TIMEOUT까지 붙잡지 않게 함
+static bool send_all(Endpoint* e, struct iovec* cur, int remaining) {
+    int64_t deadline = monotonic_ms() + network_config.timeout_seconds * 1000;
+
+    while (remaining > 0) {
+        struct msghdr msg = { .msg_iov = cur, .msg_iovlen = remaining };
+        ssize_t sent = sendmsg(e->connection.socket, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            int64_t wait_ms = deadline - monotonic_ms();
+            struct pollfd pfd = { .fd = e->connection.socket, .events = POLLOUT };
+            int ready = wait_ms > 0 ? poll(&pfd, 1, (int)wait_ms) : 0;
+            if (ready == 0) {
+                errno = ETIMEDOUT;
+                return false;
+            }
+            if (ready < 0 && errno != EINTR) {
+                return false;
+            }
+            continue;
+        }
+
+        // 보낸 만큼 iovec 앞부분을 소비
+        while (remaining > 0 && (size_t)sent >= cur->iov_len) {
+            sent -= cur->iov_len;
+            cur++;
+            remaining--;
+        }
+        if (remaining > 0) {
+            cur->iov_base = (char*)cur->iov_base + sent;
+            cur->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+static int remaining_ms(int64_t deadline_ms) {
+    int64_t remaining = deadline_ms - monotonic_ms();
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+// deadline_ms까지 정확히 len 바이트 수신 (논블로킹 소켓)
+// 시간 초과는 ETIMEDOUT, 상대가 닫으면 ECONNRESET
+static bool recv_exact(Endpoint* e, uint8_t* buf, size_t len, int64_t deadline_ms) {
+    size_t got = 0;
+    while (got < len) {
+        struct pollfd pfd = { .fd = e->connection.socket, .events = POLLIN };
+        int ready = poll(&pfd, 1, remaining_ms(deadline_ms));
+        if (ready == 0) {
+            errno = ETIMEDOUT;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+
+        ssize_t n = recv(e->connection.socket, buf + got, len - got, 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            continue;
+        }
+        if (n == 0) {
+            errno = ECONNRESET;     // 상대가 연결을 닫음
+        }
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+// TIME_REPLY로 표본 하나를 더하고 최근 표본 중 RTT가 가장 짧은 것을 고름
+// (대기열 지연이 적은 왕복일수록 두 방향이 대칭에 가까워 오프셋 오차가 작음)
+static void add_clock_sample(Endpoint* e, const uint8_t* payload) {
+    int64_t t4 = reading_timestamp_now();
+    int64_t t[3];
+
+    protocol_decode_time(payload, t, 3);
+    if (t[0] != e->clock_pending_t1) {
+        return;     // 기다리다 포기한 요청의 늦은 답
+    }
+    e->clock_pending_t1 = 0;
+
+    ClockSample* sample = &e->clock_samples[e->clock_next];
+    sample->offset_us = ((t[1] - t[0]) + (t[2] - t4)) / 2;
+    sample->rtt_us = (t4 - t[0]) - (t[2] - t[1]);
+    e->clock_next = (e->clock_next + 1) % CLOCK_WINDOW;
+    if (e->clock_sample_count < CLOCK_WINDOW) {
+        e->clock_sample_count++;
+    }
+
+    const ClockSample* best = &e->clock_samples[0];
+    for (int i = 1; i < e->clock_sample_count; i++) {
+        if (e->clock_samples[i].rtt_us < best->rtt_us) {
+            best = &e->clock_samples[i];
+        }
+    }
+    pthread_mutex_lock(&stats_mutex);
+    e->clock_offset_us = best->offset_us;
+    e->clock_rtt_us = best->rtt_us;
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+// 서버가 먼저 보내는 프레임(FRAME_ACK, FRAME_TIME_REPLY)을 와 있는 만큼 읽어 반영
+// 1: 더 읽을 것 없음, 0: 서버가 연결을 닫음, -1: 오류 (형식이 잘못되면 EPROTO)
+static int read_replies(Endpoint* e) {
+    FrameHeader header;
+
+    for (;;) {
+        size_t want = PROTOCOL_HEADER_SIZE;
+        if (e->rx_len >= PROTOCOL_HEADER_SIZE) {
+            if (!protocol_parse_header(e->rx, &header) ||
+                !((header.type == FRAME_ACK && header.length == PROTOCOL_SEQ_SIZE) ||
+                  (header.type == FRAME_TIME_REPLY && header.length == PROTOCOL_TIME_REPLY_SIZE))) {
+                errno = EPROTO;
+                return -1;
+            }
+            want += header.length;
+        }
+        if (e->rx_len < want) {
+            ssize_t n = recv(e->connection.socket, e->rx + e->rx_len, want - e->rx_len, MSG_DONTWAIT);
+            if (n == 0) {
+                return 0;
+            }
+            if (n < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 1 : -1;
+            }
+            e->rx_len += n;
+            continue;
+        }
+
+        e->rx_len = 0;
+        if (header.type == FRAME_TIME_REPLY) {
+            add_clock_sample(e, e->rx + PROTOCOL_HEADER_SIZE);
+            continue;
+        }
+        uint64_t seq = protocol_decode_seq(e->rx + PROTOCOL_HEADER_SIZE);
+        if (seq > e->acked_seq) {
+            e->acked_seq = seq;
+        }
+    }
+}
+
+// TIME_REQUEST를 보내고 답이 올 때까지 기다림 (그 사이에 오는 확인 응답도 반영)
+// 1: 표본을 얻음, 0: 시간 안에 답이 없음, -1: 연결 오류
+static int measure_clock(Endpoint* e, int timeout_ms) {
+    uint8_t request[PROTOCOL_HEADER_SIZE + PROTOCOL_TIME_REQUEST_SIZE];
+    int64_t t1 = reading_timestamp_now();
+
+    protocol_write_header(request, FRAME_TIME_REQUEST, PROTOCOL_TIME_REQUEST_SIZE);
+    protocol_encode_time(request + PROTOCOL_HEADER_SIZE, &t1, 1);
+    struct iovec iov = { .iov_base = request, .iov_len = sizeof(request) };
+    e->clock_pending_t1 = t1;
+    if (!send_all(e, &iov, 1)) {
+        return -1;
+    }
+
+    int64_t deadline = monotonic_ms() + timeout_ms;
+    while (e->clock_pending_t1 != 0) {
+        int64_t remaining = deadline - monotonic_ms();
+        struct pollfd pfd = { .fd = e->connection.socket, .events = POLLIN };
+        if (remaining <= 0 || poll(&pfd, 1, (int)remaining) <= 0) {
+            return 0;
+        }
+        int status = read_replies(e);
+        if (status == 0) {
+            errno = ECONNRESET;
+        }
+        if (status <= 0) {
+            return -1;
+        }
+    }
+    return 1;
+}
+
+// HELLO를 보내고 HELLO_ACK로 전송 형식을 정함 (응답, high-water mark, 시계 측정 모두 deadline_ms까지)
+// 상대가 연결을 닫거나 프로토콜이 아닌 바이트로 답하면 구버전 서버로 보고 *rejected = true,
+// 그 밖의 실패(보내기 실패, 시간 초과)는 연결 실패
+static bool negotiate_protocol(Endpoint* e, int64_t deadline_ms, bool* rejected) {
+    uint8_t hello[PROTOCOL_HEADER_SIZE + PROTOCOL_HELLO_SIZE];
+    HelloInfo info = {
+        .version = PROTOCOL_VERSION,
+        .schema_id = PROTOCOL_SCHEMA_ID,
+        .encodings = PROTOCOL_ENCODING_BINARY | PROTOCOL_ENCODING_JSON |
+                     (network_config.compress ? PROTOCOL_ENCODING_COMPRESSED : 0) | PROTOCOL_FEATURE_SUMMARY |
+                     PROTOCOL_FEATURE_RELAY |
+                     (network_config.node_id != 0 ? PROTOCOL_FEATURE_ACK : 0) |
+                     (network_config.clock_sync_interval_s > 0 ? PROTOCOL_FEATURE_CLOCK : 0),
+        .node_id = network_config.node_id
+    };
+
+    protocol_write_header(hello, FRAME_HELLO, PROTOCOL_HELLO_SIZE);
+    protocol_encode_hello(hello + PROTOCOL_HEADER_SIZE, &info);
+
+    struct iovec iov = { .iov_base = hello, .iov_len = sizeof(hello) };
+    *rejected = false;
+    if (!send_all(e, &iov, 1)) {
+        return false;
+    }
+
+    uint8_t reply[PROTOCOL_HEADER_SIZE + PROTOCOL_HELLO_SIZE];
+    FrameHeader header;
+    HelloInfo ack;
+
+    // 느리거나 잠시 멈춘 서버의 시간 초과는 거부가 아님: 재시도 간격을 거쳐 다시 협상
+    if (!recv_exact(e, reply, PROTOCOL_HEADER_SIZE, deadline_ms) ||
+        !recv_exact(e, reply + PROTOCOL_HEADER_SIZE, PROTOCOL_HELLO_SIZE, deadline_ms)) {
+        *rejected = errno == ECONNRESET;
+        return false;
+    }
+    if (!protocol_parse_header(reply, &header) ||
+        header.type != FRAME_HELLO_ACK || header.length != PROTOCOL_HELLO_SIZE ||
+        !protocol_decode_hello(reply + PROTOCOL_HEADER_SIZE, PROTOCOL_HELLO_SIZE, &ack)) {
+        *rejected = true;
+        errno = EPROTO;
+        return false;
+    }
+
+    e->connection.summaries = (ack.encodings & PROTOCOL_FEATURE_SUMMARY) != 0;
+    e->connection.relay = (ack.encodings & PROTOCOL_FEATURE_RELAY) != 0;
+    e->connection.acks = (ack.encodings & PROTOCOL_FEATURE_ACK) != 0;
+    e->connection.clock = (ack.encodings & PROTOCOL_FEATURE_CLOCK) != 0;
+
+    // 서버의 high-water mark: 그 이하로 보낸 프레임은 이미 저장됨. 재시작한 뒤에도 seq가 뒤로 가지 않도록
+    // 다음 seq를 그 뒤로 맞춤
+    if (e->connection.acks) {
+        uint8_t hwm[PROTOCOL_HEADER_SIZE + PROTOCOL_SEQ_SIZE];
+        if (!recv_exact(e, hwm, sizeof(hwm), deadline_ms)) {
+            return false;
+        }
+        if (!protocol_parse_header(hwm, &header) || header.type != FRAME_ACK ||
+            header.length != PROTOCOL_SEQ_SIZE) {
+            errno = EPROTO;
+            return false;
+        }
+        e->acked_seq = protocol_decode_seq(hwm + PROTOCOL_HEADER_SIZE);
+        if (e->next_seq <= e->acked_seq) {
+            e->next_seq = e->acked_seq + 1;
+        }
+    }
+    switch (ack.encodings & PROTOCOL_ENCODING_RECORDS) {
+    case PROTOCOL_ENCODING_COMPRESSED:
+        e->connection.encoding = WIRE_COMPRESSED;
+        break;
+    case PROTOCOL_ENCODING_BINARY:
+        e->connection.encoding = WIRE_BINARY;
+        break;
+    default:
+        e->connection.encoding = WIRE_JSON_FRAMED;
+        break;
+    }
+    log_info("Negotiated protocol v%d with %s:%d (schema %d, %s records%s)", ack.version,
+             e->address.host, e->address.port, ack.schema_id,
+             e->connection.encoding == WIRE_COMPRESSED ? "compressed" :
+             e->connection.encoding == WIRE_BINARY ? "binary" : "JSON",
+             e->connection.acks ? ", acknowledged" : "");
+
+    // 첫 데이터 프레임에 실을 오프셋을 연결 직후 몇 번 재어 둠 (답이 늦거나 연결 시간을 다 쓰면 이전 추정값 유지)
+    if (e->connection.clock) {
+        for (int i = 0; i < CLOCK_BURST && remaining_ms(deadline_ms) > 0; i++) {
+            if (measure_clock(e, remaining_ms(deadline_ms)) < 0) {
+                return false;
+            }
+        }
+        e->clock_due_ms = monotonic_ms() + network_config.clock_sync_interval_s * 1000;
+        log_debug("Clock offset to %s:%d: %+.3f ms (rtt %.3f ms)", e->address.host, e->address.port,
+                  e->clock_offset_us / 1000.0, e->clock_rtt_us / 1000.0);
+    }
+    return true;
+}
+
+// FNV-1a (링 위치용)
+static uint32_t hash_string(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// 정수 키를 링 위에 고르게 흩뜨림 (murmur3 finalizer)
+static uint32_t hash_key(uint32_t k) {
+    k ^= k >> 16;
+    k *= 0x85ebca6bu;
+    k ^= k >> 13;
+    k *= 0xc2b2ae35u;
+    k ^= k >> 16;
+    return k;
+}
+
+static int compare_ring_points(const void* a, const void* b) {
+    uint32_t x = ((const RingPoint*)a)->hash, y = ((const RingPoint*)b)->hash;
+    return (x > y) - (x < y);
+}
+
+// 링 위치는 서버 주소로만 정해지므로 목록 순서가 바뀌거나 서버가 추가돼도 나머지 배정은 그대로
+static void build_ring(void) {
+    ring_size = 0;
+    for (int i = 0; i < endpoint_count; i++) {
+        for (int r = 0; r < RING_REPLICAS; r++) {
+            char label[96];
+            snprintf(label, sizeof(label), "%s:%d#%d", endpoints[i].address.host, endpoints[i].address.port, r);
+            ring[ring_size].hash = hash_string(label);
+            ring[ring_size].endpoint = i;
+            ring_size++;
+        }
+    }
+    qsort(ring, ring_size, sizeof(RingPoint), compare_ring_points);
+}
+
 bool network_init(const NetworkConfig* config) {
     memcpy(&network_config, config, sizeof(NetworkConfig));
-    connection.is_connected = false;
-    connection.failed_attempts = 0;
+
+    if (config->endpoint_count < 1 || config->endpoint_count > NETWORK_MAX_ENDPOINTS) {
+        log_error("Invalid number of uplink servers: %d", config->endpoint_count);
+        return false;
+    }
+
+    if (network_config.reconnect_min_ms < 1) {
+        network_config.reconnect_min_ms = DEFAULT_RECONNECT_MIN_MS;
+    }
+    if (network_config.reconnect_max_ms < network_config.reconnect_min_ms) {
+        network_config.reconnect_max_ms = network_config.reconnect_min_ms;
+    }
+    // 노드마다 다른 씨앗: 같은 AP 아래 노드들이 순단 뒤 같은 순간에 재연결하지 않도록
+    jitter_seed = (unsigned int)(config->node_id * 2654435761u) ^ (unsigned int)getpid() ^ (unsigned int)time(NULL);
+
+    endpoint_count = config->endpoint_count;
+    for (int i = 0; i < endpoint_count; i++) {
+        memset(&endpoints[i], 0, sizeof(Endpoint));
+        endpoints[i].next_seq = 1;
+        endpoints[i].address = config->endpoints[i];
+        log_info("Uplink server %d: %s:%d", i, config->endpoints[i].host, config->endpoints[i].port);
+    }
+    build_ring();
     return true;
 }
 
-bool network_ensure_connection(void) {
-    // 이미 연결되어 있다면 true 반환
-    if (connection.is_connected) {
+bool network_wait_for_route(void) {
+    const char* hosts[NETWORK_MAX_ENDPOINTS];
+    char ifname[IF_NAMESIZE];
+    int64_t started = monotonic_ms();
+
+    if (network_config.route_wait_ms <= 0) {
         return true;
     }
+    for (int i = 0; i < endpoint_count; i++) {
+        hosts[i] = endpoints[i].address.host;
+    }
 
-    // 재연결 시도 횟수 초과 확인
-    if (connection.failed_attempts >= network_config.max_retries) {
-        log_error("Maximum reconnection attempts reached");
+    thread_set_stage(STAGE_UPLINK_CONNECT);
+    thread_heartbeat();
+    int found = netlink_wait_for_route(hosts, endpoint_count, network_config.route_wait_ms, ifname, sizeof(ifname));
+    if (found < 0) {
+        log_error("No route to any uplink server after %d ms, connecting anyway", network_config.route_wait_ms);
         return false;
     }
+    log_info("Route to %s via %s ready after %lld ms", hosts[found], ifname[0] ? ifname : "?",
+             (long long)(monotonic_ms() - started));
+    return true;
+}
+
+// 연속 실패 n번째 뒤의 재연결 대기: min * 2^(n-1)을 max에서 자르고 그 절반은 무작위
+// (끊긴 직후에는 빨리 다시 붙고, 서버가 오래 죽어 있으면 드물게 시도)
+static int64_t backoff_ms(int attempts) {
+    int64_t ceiling = network_config.reconnect_min_ms;
+    for (int i = 1; i < attempts && ceiling < network_config.reconnect_max_ms; i++) {
+        ceiling *= 2;
+    }
+    if (ceiling > network_config.reconnect_max_ms) {
+        ceiling = network_config.reconnect_max_ms;
+    }
+    return ceiling / 2 + rand_r(&jitter_seed) % (ceiling / 2 + 1);
+}
+
+static bool any_connected(void) {
+    for (int i = 0; i < endpoint_count; i++) {
+        if (endpoints[i].connection.phase == CONN_CONNECTED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 연결/전송 실패 기록: 백오프 동안 라우팅에서 빼서 그 몫이 같은 호출 안에서 다음 서버로 넘어가게 함
+static void mark_failed(Endpoint* e) {
+    int64_t now = monotonic_ms();
+    bool was_up = e->down_since_ms == 0;
+    bool connecting = e->connection.phase == CONN_CONNECTING;
+
+    pthread_mutex_lock(&stats_mutex);
+    if (connecting) {
+        e->connect_failures++;
+    }
+    if (was_up) {
+        e->down_since_ms = now;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    e->connection.phase = CONN_BACKOFF;
+    e->connection.failed_attempts++;
+    if (was_up) {
+        e->binary_rejected = false;     // 서버가 갱신되었을 수 있으므로 다음 연결에서 다시 협상
+    }
+    e->retry_at_ms = now + backoff_ms(e->connection.failed_attempts);
+
+    if (was_up && endpoint_count > 1) {
+        log_error("Uplink server %s:%d down, failing over its channels", e->address.host, e->address.port);
+    }
+    if (e->connection.failed_attempts == network_config.max_retries) {
+        log_error("Uplink server %s:%d unreachable after %d attempts, backing off up to %d ms",
+                  e->address.host, e->address.port, e->connection.failed_attempts, network_config.reconnect_max_ms);
+    }
+
+    // 마지막 수단: Wi-Fi가 연결된 채 멈춘 경우 링크를 내렸다 올려 다시 연결시킴 (주소는 DHCP 클라이언트가 다시 받음)
+    if (connecting && !any_connected() && network_config.link_reset_failures > 0 &&
+        ++link_failures >= network_config.link_reset_failures && network_config.interface[0] != '\0') {
+        log_error("No uplink server reachable after %d attempts, resetting %s", link_failures,
+                  network_config.interface);
+        link_failures = 0;
+        if (netlink_reset_link(network_config.interface)) {
+            log_info("Network interface %s reset", network_config.interface);
+        }
+    }
+}
+
+// 끊긴 서버를 전송 실패 전에 알아채도록: 유휴 연결은 keepalive 탐침으로, 보낸 데이터가 확인되지
+// 않는 연결은 TCP_USER_TIMEOUT으로 끊음 (기본값이면 커널이 15분 넘게 재전송만 반복)
+static void configure_liveness(int sock) {
+    if (network_config.keepalive_idle_s > 0) {
+        int on = 1;
+        setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &network_config.keepalive_idle_s, sizeof(int));
+        if (network_config.keepalive_interval_s > 0) {
+            setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &network_config.keepalive_interval_s, sizeof(int));
+        }
+        if (network_config.keepalive_count > 0) {
+            setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &network_config.keepalive_count, sizeof(int));
+        }
+    }
+    if (network_config.user_timeout_ms > 0) {
+        unsigned int timeout = network_config.user_timeout_ms;
+        if (setsockopt(sock, IPPROTO_TCP, TCP_USER_TIMEOUT, &timeout, sizeof(timeout)) < 0) {
+            log_error("Failed to set TCP_USER_TIMEOUT: %s", strerror(errno));
+        }
+    }
+}
+
+// 호스트 이름도 받도록 getaddrinfo로 해석 (IPv4)
+static bool resolve_endpoint(const Endpoint* e, struct sockaddr_in* out) {
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* result;
+
+    int rc = getaddrinfo(e->address.host, NULL, &hints, &result);
+    if (rc != 0) {
+        log_error("Invalid address %s: %s", e->address.host, gai_strerror(rc));
+        return false;
+    }
+    memcpy(out, result->ai_addr, sizeof(struct sockaddr_in));
+    out->sin_port = htons(e->address.port);
+    freeaddrinfo(result);
+    return true;
+}
+
+// TCP 연결, 협상, 첫 시계 측정을 합쳐 timeout_seconds 안에 끝냄 (한 번의 시도가 워치독 정지 기준을 넘지 않도록)
+static bool connect_endpoint(Endpoint* e) {
+    ConnectionState* connection = &e->connection;
+    int64_t deadline_ms = monotonic_ms() + network_config.timeout_seconds * 1000;
+
+    thread_set_stage(STAGE_UPLINK_CONNECT);
+    thread_heartbeat();
+    connection->phase = CONN_CONNECTING;
 
     // 기존 소켓이 있다면 닫기
-    if (connection.socket > 0) {
-        close(connection.socket);
+    if (connection->socket > 0) {
+        close(connection->socket);
+        connection->socket = 0;
+    }
+
+    // 서버 주소 설정
+    struct sockaddr_in server_addr;
+    if (!resolve_endpoint(e, &server_addr)) {
+        mark_failed(e);
+        return false;
     }
 
     // 새 소켓 생성
-    connection.socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (connection.socket < 0) {
+    connection->socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (connection->socket < 0) {
         log_error("Socket creation failed: %s", strerror(errno));
-        connection.failed_attempts++;
+        connection->socket = 0;
+        mark_failed(e);
         return false;
     }
 
     // 논블로킹 모드 설정
-    if (!set_socket_nonblocking(connection.socket)) {
-        close(connection.socket);
-        connection.failed_attempts++;
+    if (!set_socket_nonblocking(connection->socket)) {
+        close(connection->socket);
+        connection->socket = 0;
+        mark_failed(e);
         return false;
     }
 
-    // 서버 주소 설정
-    struct sockaddr_in server_addr = {0};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(network_config.port);
-    
-    if (inet_pton(AF_INET, network_config.host, &server_addr.sin_addr) <= 0) {
-        log_error("Invalid address: %s", network_config.host);
-        close(connection.socket);
-        connection.failed_attempts++;
-        return false;
-    }
+    configure_liveness(connection->socket);
 
     // 연결 시도
-    if (connect(connection.socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (connect(connection->socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         if (errno != EINPROGRESS) {
-            log_error("Connection failed: %s", strerror(errno));
-            close(connection.socket);
-            connection.failed_attempts++;
+            log_error("Connection to %s:%d failed: %s", e->address.host, e->address.port, strerror(errno));
+            close(connection->socket);
+            connection->socket = 0;
+            mark_failed(e);
             return false;
         }
 
-        // select로 연결 완료 대기
-        fd_set write_fds;
-        struct timeval timeout;
-        
-        FD_ZERO(&write_fds);
-        FD_SET(connection.socket, &write_fds);
-        
-        timeout.tv_sec = network_config.timeout_seconds;
-        timeout.tv_usec = 0;
-
-        int result = select(connection.socket + 1, NULL, &write_fds, NULL, &timeout);
+        // poll로 연결 완료 대기
+        struct pollfd pfd = { .fd = connection->socket, .events = POLLOUT };
+        int result = poll(&pfd, 1, remaining_ms(deadline_ms));
         if (result <= 0) {
-            log_error("Connection timeout");
-            close(connection.socket);
-            connection.failed_attempts++;
+            log_error("Connection timeout (%s:%d)", e->address.host, e->address.port);
+            close(connection->socket);
+            connection->socket = 0;
+            mark_failed(e);
+            return false;
+        }
+
+        // 쓰기 가능은 연결 시도가 끝났다는 뜻일 뿐: 거부/도달 불가는 SO_ERROR로 확인
+        int error = 0;
+        socklen_t error_len = sizeof(error);
+        if (getsockopt(connection->socket, SOL_SOCKET, SO_ERROR, &error, &error_len) < 0) {
+            error = errno;
+        }
+        if (error != 0) {
+            log_error("Connection to %s:%d failed: %s", e->address.host, e->address.port, strerror(error));
+            close(connection->socket);
+            connection->socket = 0;
+            mark_failed(e);
             return false;
         }
     }
 
+    int lowat = NOTSENT_LOWAT_BYTES;
+    setsockopt(connection->socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat));
+
+    // 프로토콜 협상 (구버전 서버는 HELLO를 JSON으로 해석하지 못하고 연결을 닫음)
+    connection->encoding = WIRE_JSON_LEGACY;
+    connection->summaries = false;
+    connection->relay = false;
+    connection->acks = false;
+    connection->clock = false;
+    e->rx_len = 0;
+    e->clock_pending_t1 = 0;
+    if (network_config.binary_protocol && !e->binary_rejected) {
+        bool rejected;
+        if (!negotiate_protocol(e, deadline_ms, &rejected)) {
+            close(connection->socket);
+            connection->socket = 0;
+            if (!rejected) {
+                log_error("Protocol handshake with %s:%d failed: %s", e->address.host, e->address.port,
+                          strerror(errno));
+                mark_failed(e);
+                return false;
+            }
+            log_info("Server %s:%d rejected protocol handshake, falling back to JSON",
+                     e->address.host, e->address.port);
+            e->binary_rejected = true;
+            return connect_endpoint(e);
+        }
+    }
+
     // 연결 성공
-    connection.is_connected = true;
-    connection.last_success = time(NULL);
-    connection.failed_attempts = 0;
-    log_info("Connected to server %s:%d", network_config.host, network_config.port);
-    
+    int64_t down_ms = 0;
+    pthread_mutex_lock(&stats_mutex);
+    if (e->down_since_ms != 0) {
+        down_ms = monotonic_ms() - e->down_since_ms;
+        e->downtime_ms += down_ms;
+        e->down_since_ms = 0;
+    }
+    if (e->ever_connected) {
+        e->reconnects++;
+    }
+    pthread_mutex_unlock(&stats_mutex);
+
+    int attempts = connection->failed_attempts + 1;
+    connection->phase = CONN_CONNECTED;
+    e->generation++;
+    connection->last_success = time(NULL);
+    connection->failed_attempts = 0;
+    e->retry_at_ms = 0;
+    link_failures = 0;
+    if (e->ever_connected) {
+        log_info("Reconnected to server %s:%d after %.1f s down (%d attempts)", e->address.host, e->address.port,
+                 down_ms / 1000.0, attempts);
+    } else {
+        log_info("Connected to server %s:%d", e->address.host, e->address.port);
+    }
+    e->ever_connected = true;
+
     return true;
 }
 
-static bool send_json_data(const char* json_str) {
-    if (!network_ensure_connection()) {
+int network_endpoint_count(void) {
+    return endpoint_count;
+}
+
+int network_route(int channel) {
+    return network_route_node(0, channel);
+}
+
+int network_route_node(uint32_t node_id, int channel) {
+    if (node_id == 0) {
+        node_id = network_config.node_id;
+    }
+    uint32_t key = network_config.shard_by == NETWORK_SHARD_NODE ? node_id : node_id * 256u + (uint32_t)channel;
+    uint32_t h = hash_key(key);
+    int64_t now = monotonic_ms();
+
+    // h 이상인 첫 링 위치 (이진 탐색), 거기서부터 시계 방향으로 쓸 수 있는 첫 서버
+    int lo = 0, hi = ring_size;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (ring[mid].hash < h) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (int i = 0; i < ring_size; i++) {
+        const Endpoint* e = &endpoints[ring[(lo + i) % ring_size].endpoint];
+        if (e->connection.phase == CONN_CONNECTED || now >= e->retry_at_ms) {
+            return ring[(lo + i) % ring_size].endpoint;
+        }
+    }
+    return -1;
+}
+
+bool network_ensure_connection(int endpoint) {
+    Endpoint* e = &endpoints[endpoint];
+
+    // 이미 연결되어 있다면 true 반환
+    if (e->connection.phase == CONN_CONNECTED) {
+        return true;
+    }
+    // 백오프 중: 재시도 시각 전에는 연결하지 않음
+    if (monotonic_ms() < e->retry_at_ms) {
         return false;
     }
 
-    size_t total = 0;
-    size_t len = strlen(json_str);
-    
-    while (total < len) {
-        ssize_t sent = send(connection.socket, json_str + total, len - total, 0);
-        if (sent < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                usleep(1000);
+    pthread_mutex_lock(&send_mutex);
+    bool connected = e->connection.phase == CONN_CONNECTED || connect_endpoint(e);
+    pthread_mutex_unlock(&send_mutex);
+    return connected;
+}
+
+// 프레임 전송: 연결이 없으면 먼저 (재)연결
+bool network_send_frame(int endpoint, const struct iovec* iov, int iovcnt) {
+    struct iovec parts[NETWORK_MAX_IOV];
+    Endpoint* e = &endpoints[endpoint];
+
+    if (iovcnt <= 0 || iovcnt > NETWORK_MAX_IOV) {
+        return false;
+    }
+    memcpy(parts, iov, sizeof(struct iovec) * iovcnt);
+
+    if (!network_ensure_connection(endpoint)) {
+        return false;
+    }
+
+    thread_set_stage(STAGE_UPLINK_SEND);
+    thread_heartbeat();
+    pthread_mutex_lock(&send_mutex);
+    if (!send_all(e, parts, iovcnt)) {
+        log_error("Send to %s:%d failed: %s", e->address.host, e->address.port, strerror(errno));
+        mark_failed(e);
+        pthread_mutex_unlock(&send_mutex);
+        return false;
+    }
+
+    pthread_mutex_unlock(&send_mutex);
+    return true;
+}
+
+bool network_send_data(int endpoint, uint8_t type, const void* payload, size_t len, uint64_t* seq) {
+    Endpoint* e = &endpoints[endpoint];
+    uint8_t header[PROTOCOL_HEADER_SIZE + PROTOCOL_SEQ_SIZE + PROTOCOL_OFFSET_SIZE];
+    struct iovec iov[2];
+
+    *seq = 0;
+    if (e->connection.phase != CONN_CONNECTED) {
+        return false;
+    }
+
+    // seq는 보내기 직전에 정함 (재연결로 다음 seq가 서버 high-water mark 뒤로 옮겨졌을 수 있음)
+    size_t header_len = PROTOCOL_HEADER_SIZE;
+    if (e->connection.acks) {
+        *seq = e->next_seq;
+        protocol_encode_seq(header + PROTOCOL_HEADER_SIZE, *seq);
+        header_len += PROTOCOL_SEQ_SIZE;
+    }
+    if (e->connection.clock) {
+        protocol_encode_time(header + header_len, &e->clock_offset_us, 1);
+        header_len += PROTOCOL_OFFSET_SIZE;
+    }
+    protocol_write_header(header, type, header_len - PROTOCOL_HEADER_SIZE + len);
+
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_len;
+    iov[1].iov_base = (void*)payload;
+    iov[1].iov_len = len;
+    if (!network_send_frame(endpoint, iov, 2)) {
+        *seq = 0;
+        return false;
+    }
+    if (*seq != 0) {
+        e->next_seq++;
+    }
+    return true;
+}
+
+void network_sync_clocks(void) {
+    int64_t now = monotonic_ms();
+
+    pthread_mutex_lock(&send_mutex);
+    for (int i = 0; i < endpoint_count; i++) {
+        Endpoint* e = &endpoints[i];
+        if (e->connection.phase != CONN_CONNECTED || !e->connection.clock || now < e->clock_due_ms) {
+            continue;
+        }
+        // 끊긴 연결은 다음 network_check_peers나 전송이 처리
+        thread_heartbeat();
+        if (measure_clock(e, network_config.timeout_seconds * 1000) > 0) {
+            log_debug("Clock offset to %s:%d: %+.3f ms (rtt %.3f ms)", e->address.host, e->address.port,
+                      e->clock_offset_us / 1000.0, e->clock_rtt_us / 1000.0);
+        }
+        e->clock_due_ms = now + network_config.clock_sync_interval_s * 1000;
+    }
+    pthread_mutex_unlock(&send_mutex);
+}
+
+bool network_clock_offset(int endpoint, int64_t* offset_us, int64_t* rtt_us) {
+    const Endpoint* e = &endpoints[endpoint];
+
+    pthread_mutex_lock(&stats_mutex);
+    bool measured = e->clock_sample_count > 0;
+    *offset_us = e->clock_offset_us;
+    *rtt_us = e->clock_rtt_us;
+    pthread_mutex_unlock(&stats_mutex);
+    return measured;
+}
+
+uint32_t network_rtt_us(void) {
+    uint32_t rtt = 0;
+    for (int i = 0; i < endpoint_count; i++) {
+        struct tcp_info info;
+        socklen_t len = sizeof(info);
+        if (endpoints[i].connection.phase == CONN_CONNECTED &&
+            getsockopt(endpoints[i].connection.socket, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 &&
+            info.tcpi_rtt > rtt) {
+            rtt = info.tcpi_rtt;
+        }
+    }
+    return rtt;
+}
+
+WireEncoding network_encoding(int endpoint) {
+    return endpoints[endpoint].connection.encoding;
+}
+
+bool network_accepts_summaries(int endpoint) {
+    return endpoints[endpoint].connection.summaries;
+}
+
+bool network_accepts_relay(int endpoint) {
+    return endpoints[endpoint].connection.relay;
+}
+
+void network_check_peers(void) {
+    struct pollfd fds[NETWORK_MAX_ENDPOINTS];
+    int owners[NETWORK_MAX_ENDPOINTS];
+    int count = 0;
+
+    pthread_mutex_lock(&send_mutex);
+    for (int i = 0; i < endpoint_count; i++) {
+        if (endpoints[i].connection.phase == CONN_CONNECTED) {
+            fds[count] = (struct pollfd){ .fd = endpoints[i].connection.socket, .events = POLLIN | POLLRDHUP };
+            owners[count++] = i;
+        }
+    }
+
+    if (count > 0 && poll(fds, count, 0) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (fds[i].revents == 0) {
                 continue;
             }
-            log_error("Send failed: %s", strerror(errno));
-            connection.is_connected = false;
-            return false;
+
+            // 서버가 먼저 보내는 것은 확인 응답과 시각 답뿐: 닫기 전에 보낸 확인도 놓치지 않도록 끝까지 읽음
+            Endpoint* e = &endpoints[owners[i]];
+            int status = (fds[i].revents & POLLERR) ? -1 : read_replies(e);
+            if (status > 0) {
+                continue;
+            }
+
+            // 정상 종료(서버가 쉬는 연결을 닫음)는 다음 전송 때 바로 다시 연결
+            if (status == 0) {
+                log_debug("Server %s:%d closed the connection", e->address.host, e->address.port);
+                close(e->connection.socket);
+                e->connection.socket = 0;
+                e->connection.phase = CONN_DISCONNECTED;
+                continue;
+            }
+
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &error, &error_len);
+            log_error("Connection to %s:%d lost: %s", e->address.host, e->address.port,
+                      strerror(error != 0 ? error : errno));
+
+            pthread_mutex_lock(&stats_mutex);
+            e->dead_peers++;
+            pthread_mutex_unlock(&stats_mutex);
+            mark_failed(e);
         }
-        total += sent;
     }
-    
-    return true;
+    pthread_mutex_unlock(&send_mutex);
 }
 
-bool send_sensor_data(const SensorData* data) {
-    struct json_object* json = json_object_new_object();
-    char timestamp[32];
-    time_t now = time(NULL);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
-    
-    json_object_object_add(json, "table", json_object_new_string("tb_water_level"));
-    json_object_object_add(json, "timestamp", json_object_new_string(timestamp));
-    json_object_object_add(json, "sensor_id", json_object_new_int(data->sensor_id));
-    json_object_object_add(json, "water_level", json_object_new_double(data->water_level));
-    json_object_object_add(json, "voltage", json_object_new_double(data->voltage));
-    
-    const char* json_str = json_object_to_json_string(json);
-    bool result = send_json_data(json_str);
-    
-    json_object_put(json);
-    return result;
-}
-
-bool send_ph_data(const PhData* data) {
-    struct json_object* json = json_object_new_object();
-    char timestamp[32];
-    time_t now = time(NULL);
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
-    
-    json_object_object_add(json, "table", json_object_new_string("tb_ph"));
-    json_object_object_add(json, "timestamp", json_object_new_string(timestamp));
-    json_object_object_add(json, "ph_value", json_object_new_double(data->ph_value));
-    json_object_object_add(json, "voltage", json_object_new_double(data->voltage));
-    
-    const char* json_str = json_object_to_json_string(json);
-    bool result = send_json_data(json_str);
-    
-    json_object_put(json);
-    return result;
+bool network_acks_enabled(int endpoint) {
+    return endpoints[endpoint].connection.acks;
+}
+
+uint64_t network_acked_seq(int endpoint) {
+    return endpoints[endpoint].acked_seq;
+}
+
+uint32_t network_generation(int endpoint) {
+    return endpoints[endpoint].generation;
+}
+
+void network_get_stats(NetworkStats* stats) {
+    int64_t now = monotonic_ms();
+
+    memset(stats, 0, sizeof(NetworkStats));
+    pthread_mutex_lock(&stats_mutex);
+    for (int i = 0; i < endpoint_count; i++) {
+        const Endpoint* e = &endpoints[i];
+        stats->reconnects += e->reconnects;
+        stats->connect_failures += e->connect_failures;
+        stats->dead_peers += e->dead_peers;
+        stats->downtime_ms += e->downtime_ms;
+        if (e->down_since_ms != 0) {
+            stats->downtime_ms += now - e->down_since_ms;
+            stats->servers_down++;
+        }
+    }
+    pthread_mutex_unlock(&stats_mutex);
+}
+
+// 감시자에서 호출: 멈춘 send/connect를 깨우기만 함
+// 연결 상태와 백오프는 업링크 스레드만 바꿈 (깨어난 호출이 실패를 mark_failed로 처리)
+void network_reset(void) {
+    for (int i = 0; i < endpoint_count; i++) {
+        int sock = endpoints[i].connection.socket;
+        if (sock > 0) {
+            shutdown(sock, SHUT_RDWR);
+        }
+    }
+    log_info("Network connection reset");
 }
 
 void network_cleanup(void) {
-    if (connection.socket > 0) {
-        close(connection.socket);
-        connection.socket = 0;
+    for (int i = 0; i < endpoint_count; i++) {
+        Endpoint* e = &endpoints[i];
+        if (e->connection.socket > 0) {
+            close(e->connection.socket);
+            e->connection.socket = 0;
+        }
+        e->connection.phase = CONN_DISCONNECTED;
     }
-    connection.is_connected = false;
-} 
\ No newline at end of file
+}
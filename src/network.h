@@ -2,30 +2,114 @@
 #define NETWORK_H
 
 #include <stdbool.h>
+#include <sys/uio.h>
 #include "types.h"
 
-typedef struct {
-    char* host;
-    int port;
-    int timeout_seconds;
-    int max_retries;
-} NetworkConfig;
+// network_send_frame 한 번에 넘길 수 있는 최대 조각 수
+#define NETWORK_MAX_IOV 16
+
+// 현재 연결에서 합의된 전송 형식
+typedef enum {
+    WIRE_JSON_LEGACY = 0,   // 개행 구분 JSON (HELLO에 응답하지 않는 구버전 서버)
+    WIRE_JSON_FRAMED,       // 프로토콜 프레임에 담은 JSON
+    WIRE_BINARY,            // 고정 레이아웃 바이너리 레코드
+    WIRE_COMPRESSED         // 시계열 압축 레코드
+} WireEncoding;
+
+// 서버 연결 단계
+typedef enum {
+    CONN_DISCONNECTED = 0,  // 연결 전 (또는 워치독 재설정 후): 다음 전송 때 바로 연결
+    CONN_CONNECTING,        // connect/HELLO 진행 중
+    CONN_CONNECTED,
+    CONN_BACKOFF            // 실패 후 retry_at_ms까지 재연결하지 않음 (라우팅에서도 빠짐)
+} ConnectionPhase;
 
 // 연결 상태를 관리하는 구조체
 typedef struct {
     int socket;
-    bool is_connected;
+    ConnectionPhase phase;
     time_t last_success;
     int failed_attempts;
+    WireEncoding encoding;
+    bool summaries;         // 서버가 구간 요약 프레임을 받음
+    bool acks;              // 데이터 프레임에 seq를 붙이고 서버가 커밋 후 FRAME_ACK로 확인
+    bool clock;             // 데이터 프레임에 서버 시계 기준 오프셋을 붙임
+    bool relay;             // 서버가 다른 노드의 레코드를 담은 중계 프레임(FRAME_RELAY)을 받음
 } ConnectionState;
 
-// 네트워크 초기화 및 연결 관리
+// 네트워크 초기화 (서버 목록으로 해시 링 구성)
 bool network_init(const NetworkConfig* config);
-bool network_ensure_connection(void);
 
-// 데이터 전송 (자동 재연결 포함)
-bool send_sensor_data(const SensorData* data);
-bool send_ph_data(const PhData* data);
+// 시작 경로: 인터페이스를 재설정하지 않고 서버 중 하나로 가는 경로가 생길 때까지만 기다림 (최대 route_wait_ms)
+// 이미 경로가 있으면(재시작, 배포) 바로 반환. 시간 안에 생기지 않으면 false (연결은 평소처럼 백오프로 재시도)
+// 모든 서버에 연속으로 link_reset_failures번 연결하지 못하면 그때 인터페이스를 재설정함
+bool network_wait_for_route(void);
+
+// 업링크 서버가 여럿이면 채널(또는 노드)을 일관 해싱으로 나눔: 링에서 키 다음에 오는 첫
+// 정상 서버가 담당하고, 그 서버가 실패하면 같은 링의 다음 서버가 이어받음 (복구되면 되돌아옴)
+// 채널의 담당 서버 번호, 쓸 수 있는 서버가 없으면 -1
+int network_route(int channel);
+// 중계한 레코드는 원래 노드 기준으로 (node_id가 0이면 이 노드, network_route와 같음)
+int network_route_node(uint32_t node_id, int channel);
+int network_endpoint_count(void);
+
+// 서버 연결 확보 (최근 실패한 서버는 재시도 시각 전까지 false)
+bool network_ensure_connection(int endpoint);
+
+// 연결된 서버들의 커널 RTT 추정값(TCP_INFO) 중 최댓값, µs (연결이 없으면 0)
+uint32_t network_rtt_us(void);
+
+// 서버 연결의 전송 형식 (network_ensure_connection 성공 후 유효)
+WireEncoding network_encoding(int endpoint);
+
+// 서버가 구간 요약 프레임(FRAME_SUMMARY)을 받는지 (network_ensure_connection 성공 후 유효)
+bool network_accepts_summaries(int endpoint);
+
+// 서버가 중계 프레임(FRAME_RELAY)을 받는지 (network_ensure_connection 성공 후 유효)
+bool network_accepts_relay(int endpoint);
+
+// 프레임 전송 (자동 재연결 포함): 여러 조각을 한 번의 sendmsg로
+// 실패하면 그 서버는 잠시 라우팅에서 빠짐
+bool network_send_frame(int endpoint, const struct iovec* iov, int iovcnt);
+
+// 연결된 서버 소켓을 기다리지 않고 확인 (업링크 스레드가 주기적으로 호출)
+// 와 있는 확인 응답을 읽고, keepalive/TCP_USER_TIMEOUT 등으로 끊긴 연결은 다음 전송을 기다리지 않고
+// 실패로 처리해 재연결 백오프를 시작. 서버가 정상적으로 닫은 연결은 다음 전송 때 바로 다시 연결
+void network_check_peers(void);
+
+// 재연결 통계 (실행 중 누적, 모든 서버 합계)
+typedef struct {
+    uint64_t reconnects;        // 연결이 끊긴 뒤 다시 연결된 횟수
+    uint64_t connect_failures;  // 실패한 연결 시도
+    uint64_t dead_peers;        // 전송 전에 network_check_peers가 찾아낸 끊긴 연결
+    uint64_t downtime_ms;       // 서버가 끊겨 있던 시간 (지금 끊겨 있는 서버는 현재까지)
+    int servers_down;
+} NetworkStats;
+
+void network_get_stats(NetworkStats* stats);
+
+// 데이터 프레임 전송: 헤더를 붙이고, 협상한 연결이면 seq와 시계 오프셋 접두도 붙임
+// *seq에 붙인 seq (확인 응답을 쓰지 않는 연결이거나 실패하면 0)
+// 다시 연결하지 않음: 호출자가 network_ensure_connection으로 연결을 확보하고 확인 대기 프레임을 정리한 뒤 호출
+bool network_send_data(int endpoint, uint8_t type, const void* payload, size_t len, uint64_t* seq);
+
+// 확인 응답 상태 (network_check_peers가 소켓에 와 있는 FRAME_ACK를 읽어 갱신)
+// seq가 acked_seq 이하인 프레임은 서버 DB에 커밋됨. generation이 보낼 때와 다르면 확인 전에 연결이
+// 끊겼으므로 그 프레임은 다시 보내야 함 (재연결 직후 acked_seq는 서버의 high-water mark이고,
+// 그 뒤의 누적 확인은 새 연결로 보낸 프레임에 대한 것이므로 끊긴 프레임에 적용하면 안 됨)
+bool network_acks_enabled(int endpoint);
+uint64_t network_acked_seq(int endpoint);
+uint32_t network_generation(int endpoint);
+
+// 시계 오프셋: 연결 직후와 clock_sync_interval_s마다 서버와 시각을 주고받아 오프셋을 추정
+// (최근 표본 중 RTT가 가장 짧은 것). 주기가 된 연결된 서버에만 보내고 답을 기다림 (업링크 스레드에서 호출)
+void network_sync_clocks(void);
+
+// 서버 시계 기준 오프셋(서버 시각 - 노드 시각)과 그 표본의 RTT, µs (아직 표본이 없으면 false)
+bool network_clock_offset(int endpoint, int64_t* offset_us, int64_t* rtt_us);
+
+// 멈춘 송수신을 깨움 (워치독 복구용, 연결 상태와 백오프는 깨어난 업링크 스레드가 정리)
+void network_reset(void);
 
 // 연결 종료
 void network_cleanup(void);
@@ -2,6 +2,7 @@
 #include "adc.h"
 #include "logger.h"
 #include "config.h"
+#include "thread_manager.h"
 #include <math.h>
 
 static MovingAverage ph_filter;
@@ -30,6 +31,7 @@ PhData read_ph_with_filtering(void) {
     int valid_samples = 0;
     
     // 여러 샘플 수집
+    thread_set_stage(STAGE_ADC_READ);
     for (int i = 0; i < PH_SAMPLES; i++) {
         uint16_t adc_value = adc_read(0);  // pH 센서는 채널 0 사용
         if (adc_value > 0 && adc_value < ADC_MAX_VALUE) {
@@ -43,6 +45,10 @@ PhData read_ph_with_filtering(void) {
         log_error("No valid pH readings");
         return result;
     }
+    // 워치독이 버린 이전 스레드는 교체된 스레드의 이동 평균을 건드리지 않음
+    if (thread_abandoned()) {
+        return result;
+    }
     
     result.voltage = adc_to_voltage(adc_sum / valid_samples);
     float raw_ph = voltage_to_ph(result.voltage);
@@ -0,0 +1,598 @@
+#include "protocol.h"
+#include <string.h>
+
+// 센서 종류별 서버 테이블과 값 필드 이름
+static const struct {
+    const char* table;
+    const char* field;
+} kind_tables[SENSOR_KIND_COUNT] = {
+    [SENSOR_KIND_WATER_LEVEL] = { "tb_water_level", "water_level" },
+    [SENSOR_KIND_PH] = { "tb_ph", "ph_value" },
+    [SENSOR_KIND_TEMPERATURE] = { "tb_water_temperature", "temperature" },
+    [SENSOR_KIND_CONDUCTIVITY] = { "tb_conductivity", "conductivity" },
+    [SENSOR_KIND_ILLUMINANCE] = { "tb_illuminance", "illuminance" },
+};
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = v >> 8;
+    p[1] = v;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void put_u64(uint8_t* p, uint64_t v) {
+    put_u32(p, v >> 32);
+    put_u32(p + 4, (uint32_t)v);
+}
+
+static void put_f32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint64_t get_u64(const uint8_t* p) {
+    return (uint64_t)get_u32(p) << 32 | get_u32(p + 4);
+}
+
+static float get_f32(const uint8_t* p) {
+    uint32_t bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+void protocol_write_header(uint8_t* buf, uint8_t type, uint32_t length) {
+    put_u16(buf, PROTOCOL_MAGIC);
+    buf[2] = PROTOCOL_VERSION;
+    buf[3] = type;
+    put_u32(buf + 4, length);
+}
+
+bool protocol_parse_header(const uint8_t* buf, FrameHeader* out) {
+    if (get_u16(buf) != PROTOCOL_MAGIC || buf[2] == 0 || buf[2] > PROTOCOL_VERSION) {
+        return false;
+    }
+    out->type = buf[3];
+    out->length = get_u32(buf + 4);
+    return out->length <= PROTOCOL_MAX_PAYLOAD;
+}
+
+void protocol_encode_seq(uint8_t* buf, uint64_t seq) {
+    put_u64(buf, seq);
+}
+
+uint64_t protocol_decode_seq(const uint8_t* buf) {
+    return get_u64(buf);
+}
+
+void protocol_encode_time(uint8_t* buf, const int64_t* stamps, int count) {
+    for (int i = 0; i < count; i++) {
+        put_u64(buf + i * 8, (uint64_t)stamps[i]);
+    }
+}
+
+void protocol_decode_time(const uint8_t* buf, int64_t* stamps, int count) {
+    for (int i = 0; i < count; i++) {
+        stamps[i] = (int64_t)get_u64(buf + i * 8);
+    }
+}
+
+void protocol_encode_hello(uint8_t* buf, const HelloInfo* hello) {
+    buf[0] = hello->version;
+    buf[1] = hello->encodings;
+    put_u16(buf + 2, hello->schema_id);
+    put_u32(buf + 4, hello->node_id);
+}
+
+bool protocol_decode_hello(const uint8_t* payload, size_t len, HelloInfo* out) {
+    if (len < PROTOCOL_HELLO_SIZE) {
+        return false;
+    }
+    out->version = payload[0];
+    out->encodings = payload[1];
+    out->schema_id = get_u16(payload + 2);
+    out->node_id = get_u32(payload + 4);
+    return true;
+}
+
+size_t protocol_encode_batch(uint8_t* buf, size_t capacity, const WireRecord* records, int count, int* consumed) {
+    *consumed = 0;
+    if (count <= 0 || capacity < PROTOCOL_BATCH_HEADER_SIZE + PROTOCOL_RECORD_SIZE) {
+        return 0;
+    }
+
+    int64_t base_ts = records[0].timestamp_us;
+    uint8_t* p = buf + PROTOCOL_BATCH_HEADER_SIZE;
+    int n = 0;
+
+    while (n < count && n < PROTOCOL_MAX_RECORDS &&
+           (size_t)(p - buf) + PROTOCOL_RECORD_SIZE <= capacity) {
+        int64_t dt = records[n].timestamp_us - base_ts;
+        if (dt > INT32_MAX || dt < INT32_MIN) {
+            break;  // 기준 시각에서 너무 멀면 다음 배치로
+        }
+
+        p[0] = records[n].channel;
+        p[1] = records[n].kind;
+        p[2] = records[n].sensor_id;
+        p[3] = records[n].quality;
+        put_u32(p + 4, (uint32_t)(int32_t)dt);
+        put_f32(p + 8, records[n].value);
+        put_f32(p + 12, records[n].voltage);
+        p += PROTOCOL_RECORD_SIZE;
+        n++;
+    }
+
+    put_u64(buf, (uint64_t)base_ts);
+    put_u16(buf + 8, (uint16_t)n);
+    put_u16(buf + 10, 0);
+
+    *consumed = n;
+    return (size_t)(p - buf);
+}
+
+int protocol_decode_batch(const uint8_t* payload, size_t len, WireRecord* out, int max) {
+    if (len < PROTOCOL_BATCH_HEADER_SIZE) {
+        return -1;
+    }
+
+    int64_t base_ts = (int64_t)get_u64(payload);
+    int count = get_u16(payload + 8);
+    if (len != PROTOCOL_BATCH_HEADER_SIZE + (size_t)count * PROTOCOL_RECORD_SIZE || count > max) {
+        return -1;
+    }
+
+    const uint8_t* p = payload + PROTOCOL_BATCH_HEADER_SIZE;
+    for (int i = 0; i < count; i++, p += PROTOCOL_RECORD_SIZE) {
+        out[i].channel = p[0];
+        out[i].kind = p[1];
+        out[i].sensor_id = p[2];
+        out[i].quality = p[3];
+        out[i].timestamp_us = base_ts + (int32_t)get_u32(p + 4);
+        out[i].value = get_f32(p + 8);
+        out[i].voltage = get_f32(p + 12);
+        out[i].node_id = 0;
+    }
+    return count;
+}
+
+size_t protocol_encode_summary(uint8_t* buf, size_t capacity, const SummaryRecord* records, int count,
+                               int* consumed) {
+    *consumed = 0;
+    if (count <= 0 || capacity < PROTOCOL_BATCH_HEADER_SIZE + PROTOCOL_SUMMARY_RECORD_SIZE) {
+        return 0;
+    }
+
+    int64_t base_ts = records[0].window_start_us;
+    uint8_t* p = buf + PROTOCOL_BATCH_HEADER_SIZE;
+    int n = 0;
+
+    while (n < count && n < PROTOCOL_MAX_SUMMARIES &&
+           (size_t)(p - buf) + PROTOCOL_SUMMARY_RECORD_SIZE <= capacity) {
+        int64_t dt = records[n].window_start_us - base_ts;
+        if (dt > INT32_MAX || dt < INT32_MIN) {
+            break;
+        }
+
+        p[0] = records[n].channel;
+        p[1] = records[n].kind;
+        p[2] = records[n].sensor_id;
+        p[3] = records[n].quality;
+        put_u32(p + 4, (uint32_t)(int32_t)dt);
+        put_u32(p + 8, records[n].window_ms);
+        put_u32(p + 12, records[n].count);
+        put_f32(p + 16, records[n].min);
+        put_f32(p + 20, records[n].max);
+        put_f32(p + 24, records[n].mean);
+        put_f32(p + 28, records[n].last);
+        p += PROTOCOL_SUMMARY_RECORD_SIZE;
+        n++;
+    }
+
+    put_u64(buf, (uint64_t)base_ts);
+    put_u16(buf + 8, (uint16_t)n);
+    put_u16(buf + 10, 0);
+
+    *consumed = n;
+    return (size_t)(p - buf);
+}
+
+int protocol_decode_summary(const uint8_t* payload, size_t len, SummaryRecord* out, int max) {
+    if (len < PROTOCOL_BATCH_HEADER_SIZE) {
+        return -1;
+    }
+
+    int64_t base_ts = (int64_t)get_u64(payload);
+    int count = get_u16(payload + 8);
+    if (len != PROTOCOL_BATCH_HEADER_SIZE + (size_t)count * PROTOCOL_SUMMARY_RECORD_SIZE || count > max) {
+        return -1;
+    }
+
+    const uint8_t* p = payload + PROTOCOL_BATCH_HEADER_SIZE;
+    for (int i = 0; i < count; i++, p += PROTOCOL_SUMMARY_RECORD_SIZE) {
+        out[i].channel = p[0];
+        out[i].kind = p[1];
+        out[i].sensor_id = p[2];
+        out[i].quality = p[3];
+        out[i].window_start_us = base_ts + (int32_t)get_u32(p + 4);
+        out[i].window_ms = get_u32(p + 8);
+        out[i].count = get_u32(p + 12);
+        out[i].min = get_f32(p + 16);
+        out[i].max = get_f32(p + 20);
+        out[i].mean = get_f32(p + 24);
+        out[i].last = get_f32(p + 28);
+        out[i].node_id = 0;
+    }
+    return count;
+}
+
+size_t protocol_encode_live(uint8_t* buf, size_t capacity, uint32_t node_id, uint32_t seq,
+                            const WireRecord* records, int count) {
+    int consumed;
+
+    if (capacity < PROTOCOL_LIVE_HEADER_SIZE + PROTOCOL_BATCH_HEADER_SIZE) {
+        return 0;
+    }
+    put_u32(buf, node_id);
+    put_u32(buf + 4, seq);
+    return PROTOCOL_LIVE_HEADER_SIZE +
+           protocol_encode_batch(buf + PROTOCOL_LIVE_HEADER_SIZE, capacity - PROTOCOL_LIVE_HEADER_SIZE,
+                                 records, count, &consumed);
+}
+
+int protocol_decode_live(const uint8_t* payload, size_t len, uint32_t* node_id, uint32_t* seq,
+                         WireRecord* out, int max) {
+    if (len < PROTOCOL_LIVE_HEADER_SIZE) {
+        return -1;
+    }
+    *node_id = get_u32(payload);
+    *seq = get_u32(payload + 4);
+    return protocol_decode_batch(payload + PROTOCOL_LIVE_HEADER_SIZE, len - PROTOCOL_LIVE_HEADER_SIZE, out, max);
+}
+
+// ---- 시계열 압축 배치 ----
+
+#define XOR_NO_WINDOW 32    // 이전 XOR 구간 없음 (첫 값 다음은 항상 구간을 새로 기록)
+
+static void put_bits(CompressEncoder* enc, uint64_t value, int n) {
+    for (int i = n - 1; i >= 0; i--) {
+        uint8_t* byte = &enc->buf[PROTOCOL_BATCH_HEADER_SIZE + (enc->bits >> 3)];
+        if ((enc->bits & 7) == 0) {
+            *byte = 0;
+        }
+        if ((value >> i) & 1) {
+            *byte |= 0x80 >> (enc->bits & 7);
+        }
+        enc->bits++;
+    }
+}
+
+static bool get_bits(CompressDecoder* dec, int n, uint64_t* out) {
+    if (dec->bits + n > dec->total_bits) {
+        return false;
+    }
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) {
+        v = (v << 1) | ((dec->buf[dec->bits >> 3] >> (7 - (dec->bits & 7))) & 1);
+        dec->bits++;
+    }
+    *out = v;
+    return true;
+}
+
+static int64_t sign_extend(uint64_t v, int n) {
+    return n == 64 ? (int64_t)v : (int64_t)(v << (64 - n)) >> (64 - n);
+}
+
+static uint32_t float_bits(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// 시각 delta-of-delta: 0 | 10+10비트 | 110+16비트 | 1110+24비트 | 1111+64비트
+static void put_dod(CompressEncoder* enc, int64_t dod) {
+    if (dod == 0) {
+        put_bits(enc, 0, 1);
+    } else if (dod >= -(1 << 9) && dod < (1 << 9)) {
+        put_bits(enc, 0x2, 2);
+        put_bits(enc, (uint64_t)dod, 10);
+    } else if (dod >= -(1 << 15) && dod < (1 << 15)) {
+        put_bits(enc, 0x6, 3);
+        put_bits(enc, (uint64_t)dod, 16);
+    } else if (dod >= -(1 << 23) && dod < (1 << 23)) {
+        put_bits(enc, 0xE, 4);
+        put_bits(enc, (uint64_t)dod, 24);
+    } else {
+        put_bits(enc, 0xF, 4);
+        put_bits(enc, (uint64_t)dod, 64);
+    }
+}
+
+static bool get_dod(CompressDecoder* dec, int64_t* dod) {
+    static const int widths[] = { 10, 16, 24, 64 };
+    uint64_t bit, v;
+    int prefix = 0;
+
+    // 앞의 1 개수(최대 4)로 구간 선택
+    while (prefix < 4) {
+        if (!get_bits(dec, 1, &bit)) {
+            return false;
+        }
+        if (bit == 0) {
+            break;
+        }
+        prefix++;
+    }
+    if (prefix == 0) {
+        *dod = 0;
+        return true;
+    }
+    int width = widths[prefix - 1];
+    if (!get_bits(dec, width, &v)) {
+        return false;
+    }
+    *dod = sign_extend(v, width);
+    return true;
+}
+
+// Gorilla 방식 XOR: 같으면 0, 이전 구간 안이면 10+구간 비트, 아니면 11+선행0(5)+길이-1(5)+비트
+static void put_xor(CompressEncoder* enc, uint32_t xor_bits, uint8_t* leading, uint8_t* trailing) {
+    if (xor_bits == 0) {
+        put_bits(enc, 0, 1);
+        return;
+    }
+
+    int lead = __builtin_clz(xor_bits);
+    int trail = __builtin_ctz(xor_bits);
+    if (*leading != XOR_NO_WINDOW && lead >= *leading && trail >= *trailing) {
+        put_bits(enc, 0x2, 2);
+        put_bits(enc, xor_bits >> *trailing, 32 - *leading - *trailing);
+        return;
+    }
+
+    int length = 32 - lead - trail;
+    put_bits(enc, 0x3, 2);
+    put_bits(enc, lead, 5);
+    put_bits(enc, length - 1, 5);
+    put_bits(enc, xor_bits >> trail, length);
+    *leading = lead;
+    *trailing = trail;
+}
+
+static bool get_xor(CompressDecoder* dec, uint32_t* xor_bits, uint8_t* leading, uint8_t* trailing) {
+    uint64_t bit, v, lead, length;
+
+    if (!get_bits(dec, 1, &bit)) {
+        return false;
+    }
+    if (bit == 0) {
+        *xor_bits = 0;
+        return true;
+    }
+    if (!get_bits(dec, 1, &bit)) {
+        return false;
+    }
+
+    if (bit == 0) {
+        if (*leading == XOR_NO_WINDOW || !get_bits(dec, 32 - *leading - *trailing, &v)) {
+            return false;
+        }
+        *xor_bits = (uint32_t)(v << *trailing);
+        return true;
+    }
+
+    if (!get_bits(dec, 5, &lead) || !get_bits(dec, 5, &length) || lead + length + 1 > 32 ||
+        !get_bits(dec, (int)length + 1, &v)) {
+        return false;
+    }
+    *leading = lead;
+    *trailing = 32 - lead - (length + 1);
+    *xor_bits = (uint32_t)(v << *trailing);
+    return true;
+}
+
+void protocol_compress_begin(CompressEncoder* enc, uint8_t* buf, size_t capacity, int64_t base_ts) {
+    enc->buf = buf;
+    enc->capacity = capacity;
+    enc->bits = 0;
+    enc->count = 0;
+    enc->base_ts = base_ts;
+    memset(enc->channels, 0, sizeof(enc->channels));
+}
+
+bool protocol_compress_add(CompressEncoder* enc, const WireRecord* record) {
+    if (record->channel >= PROTOCOL_COMPRESS_CHANNELS || enc->count >= UINT16_MAX ||
+        PROTOCOL_BATCH_HEADER_SIZE + (enc->bits + PROTOCOL_COMPRESS_MAX_RECORD_BITS + 7) / 8 > enc->capacity) {
+        return false;
+    }
+
+    CompressChannel* ch = &enc->channels[record->channel];
+    uint32_t value_bits = float_bits(record->value);
+    uint32_t voltage_bits = float_bits(record->voltage);
+
+    if (!ch->seen) {
+        int64_t dt = record->timestamp_us - enc->base_ts;
+        if (dt > INT32_MAX || dt < INT32_MIN) {
+            return false;
+        }
+
+        put_bits(enc, record->channel, 4);
+        put_bits(enc, record->kind, 8);
+        put_bits(enc, record->sensor_id, 8);
+        put_bits(enc, record->quality, 8);
+        put_bits(enc, (uint32_t)(int32_t)dt, 32);
+        put_bits(enc, value_bits, 32);
+        put_bits(enc, voltage_bits, 32);
+
+        ch->seen = true;
+        ch->delta_us = 0;
+        ch->value_leading = ch->voltage_leading = XOR_NO_WINDOW;
+    } else {
+        put_bits(enc, record->channel, 4);
+        if (record->kind == ch->kind && record->sensor_id == ch->sensor_id && record->quality == ch->quality) {
+            put_bits(enc, 0, 1);
+        } else {
+            put_bits(enc, 1, 1);
+            put_bits(enc, record->kind, 8);
+            put_bits(enc, record->sensor_id, 8);
+            put_bits(enc, record->quality, 8);
+        }
+
+        int64_t delta = record->timestamp_us - ch->timestamp_us;
+        put_dod(enc, delta - ch->delta_us);
+        put_xor(enc, value_bits ^ ch->value_bits, &ch->value_leading, &ch->value_trailing);
+        put_xor(enc, voltage_bits ^ ch->voltage_bits, &ch->voltage_leading, &ch->voltage_trailing);
+        ch->delta_us = delta;
+    }
+
+    ch->kind = record->kind;
+    ch->sensor_id = record->sensor_id;
+    ch->quality = record->quality;
+    ch->timestamp_us = record->timestamp_us;
+    ch->value_bits = value_bits;
+    ch->voltage_bits = voltage_bits;
+    enc->count++;
+    return true;
+}
+
+size_t protocol_compress_finish(CompressEncoder* enc) {
+    put_u64(enc->buf, (uint64_t)enc->base_ts);
+    put_u16(enc->buf + 8, (uint16_t)enc->count);
+    put_u16(enc->buf + 10, 0);
+    return PROTOCOL_BATCH_HEADER_SIZE + (enc->bits + 7) / 8;
+}
+
+bool protocol_decompress_begin(CompressDecoder* dec, const uint8_t* payload, size_t len) {
+    if (len < PROTOCOL_BATCH_HEADER_SIZE) {
+        return false;
+    }
+    dec->base_ts = (int64_t)get_u64(payload);
+    dec->remaining = get_u16(payload + 8);
+    dec->buf = payload + PROTOCOL_BATCH_HEADER_SIZE;
+    dec->total_bits = (len - PROTOCOL_BATCH_HEADER_SIZE) * 8;
+    dec->bits = 0;
+    memset(dec->channels, 0, sizeof(dec->channels));
+    return true;
+}
+
+int protocol_decompress_next(CompressDecoder* dec, WireRecord* out) {
+    uint64_t channel, flag, kind, sensor_id, quality, dt, value_bits, voltage_bits;
+
+    if (dec->remaining == 0) {
+        return 0;
+    }
+    if (!get_bits(dec, 4, &channel)) {
+        return -1;
+    }
+
+    CompressChannel* ch = &dec->channels[channel];
+    if (!ch->seen) {
+        if (!get_bits(dec, 8, &kind) || !get_bits(dec, 8, &sensor_id) || !get_bits(dec, 8, &quality) ||
+            !get_bits(dec, 32, &dt) || !get_bits(dec, 32, &value_bits) || !get_bits(dec, 32, &voltage_bits)) {
+            return -1;
+        }
+        ch->seen = true;
+        ch->kind = kind;
+        ch->sensor_id = sensor_id;
+        ch->quality = quality;
+        ch->timestamp_us = dec->base_ts + sign_extend(dt, 32);
+        ch->delta_us = 0;
+        ch->value_bits = value_bits;
+        ch->voltage_bits = voltage_bits;
+        ch->value_leading = ch->voltage_leading = XOR_NO_WINDOW;
+    } else {
+        int64_t dod;
+        uint32_t value_xor, voltage_xor;
+
+        if (!get_bits(dec, 1, &flag)) {
+            return -1;
+        }
+        if (flag) {
+            if (!get_bits(dec, 8, &kind) || !get_bits(dec, 8, &sensor_id) || !get_bits(dec, 8, &quality)) {
+                return -1;
+            }
+            ch->kind = kind;
+            ch->sensor_id = sensor_id;
+            ch->quality = quality;
+        }
+        if (!get_dod(dec, &dod) ||
+            !get_xor(dec, &value_xor, &ch->value_leading, &ch->value_trailing) ||
+            !get_xor(dec, &voltage_xor, &ch->voltage_leading, &ch->voltage_trailing)) {
+            return -1;
+        }
+        ch->delta_us += dod;
+        ch->timestamp_us += ch->delta_us;
+        ch->value_bits ^= value_xor;
+        ch->voltage_bits ^= voltage_xor;
+    }
+
+    out->channel = channel;
+    out->kind = ch->kind;
+    out->sensor_id = ch->sensor_id;
+    out->quality = ch->quality;
+    out->timestamp_us = ch->timestamp_us;
+    out->value = bits_float(ch->value_bits);
+    out->voltage = bits_float(ch->voltage_bits);
+    out->node_id = 0;
+    dec->remaining--;
+    return 1;
+}
+
+// ---- 중계 ----
+
+void protocol_encode_relay_section(uint8_t* buf, uint32_t node_id, uint8_t type, uint32_t length) {
+    put_u32(buf, node_id);
+    buf[4] = type;
+    buf[5] = 0;
+    put_u16(buf + 6, 0);
+    put_u32(buf + 8, length);
+}
+
+int protocol_next_relay_section(const uint8_t* payload, size_t len, size_t* offset, RelaySection* out) {
+    if (*offset == len) {
+        return 0;
+    }
+    if (len - *offset < PROTOCOL_RELAY_SECTION_HEADER_SIZE) {
+        return -1;
+    }
+
+    const uint8_t* p = payload + *offset;
+    out->node_id = get_u32(p);
+    out->type = p[4];
+    out->length = get_u32(p + 8);
+    if (out->length > len - *offset - PROTOCOL_RELAY_SECTION_HEADER_SIZE) {
+        return -1;
+    }
+    out->payload = p + PROTOCOL_RELAY_SECTION_HEADER_SIZE;
+    *offset += PROTOCOL_RELAY_SECTION_HEADER_SIZE + out->length;
+    return 1;
+}
+
+const char* protocol_kind_table(int kind) {
+    return (kind >= 0 && kind < SENSOR_KIND_COUNT) ? kind_tables[kind].table : NULL;
+}
+
+const char* protocol_kind_field(int kind) {
+    return (kind >= 0 && kind < SENSOR_KIND_COUNT) ? kind_tables[kind].field : NULL;
+}
@@ -0,0 +1,229 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// 업링크 와이어 프로토콜 (데몬의 network.c와 server.c가 공용)
+//
+// 프레임 = 헤더 8바이트 + 페이로드, 모든 정수는 네트워크 바이트 순서
+//   u16 magic ("WM") | u8 version | u8 type | u32 payload length
+//
+// 연결 직후 클라이언트가 HELLO(버전, 스키마, 지원 인코딩)를 보내고 서버가 HELLO_ACK로
+// 사용할 인코딩을 정함. 서버가 응답하지 않으면(구버전) 개행 구분 JSON으로 대체.
+//
+// 확인 응답(PROTOCOL_FEATURE_ACK)을 협상한 연결에서는 데이터 프레임(BATCH*, SUMMARY) 페이로드 앞에
+// u64 seq(서버별로 단조 증가)를 붙임. 서버는 프레임을 저장한 트랜잭션을 커밋한 뒤 누적 FRAME_ACK
+// (이 seq까지 모두 저장됨)로 응답하고, 노드별 high-water mark 이하의 seq는 다시 와도 저장하지 않음.
+// HELLO_ACK 바로 뒤에도 FRAME_ACK 하나로 서버의 현재 high-water mark를 알려 줌.
+//
+// 시계 오프셋(PROTOCOL_FEATURE_CLOCK)을 협상한 연결에서는 클라이언트가 TIME_REQUEST(t1)를 보내고 서버가
+// 받은 시각 t2와 답하는 시각 t3를 붙여 TIME_REPLY로 돌려줌. 클라이언트는 답을 받은 시각 t4로
+// offset = ((t2 - t1) + (t3 - t4)) / 2, rtt = (t4 - t1) - (t3 - t2)를 구하고 최근 표본 중 RTT가 가장
+// 짧은 것의 offset을 씀. 데이터 프레임 페이로드 앞(seq 뒤)에 i64 offset(µs, 서버 시각 - 노드 시각)을
+// 붙이고, 서버는 레코드 시각에 더해 자기 시계 기준으로 저장함.
+//
+// 중계(PROTOCOL_FEATURE_RELAY)를 협상한 연결에서는 게이트웨이가 하위 노드들에서 받은 레코드를 자기 배치와
+// 합쳐 FRAME_RELAY 하나로 보냄. 노드별 구간에 원래 node_id가 남고, seq와 오프셋 접두는 프레임 전체
+// (게이트웨이의 스트림)에 붙음. 하위 노드의 시각은 게이트웨이가 자기 시계 기준으로 옮긴 뒤 싣음.
+// 하위 노드의 구간 요약도 같은 방식으로 요약 구간(FRAME_SUMMARY)에 실어 보냄.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+#define PROTOCOL_MAGIC 0x574D           // "WM"
+#define PROTOCOL_VERSION 1
+#define PROTOCOL_SCHEMA_ID 1            // 레코드 레이아웃과 센서 종류 번호가 바뀌면 증가
+#define PROTOCOL_HEADER_SIZE 8
+#define PROTOCOL_MAX_PAYLOAD (64 * 1024)
+
+// 프레임 종류
+#define FRAME_HELLO 1
+#define FRAME_HELLO_ACK 2
+#define FRAME_BATCH 3                   // 고정 레이아웃 바이너리 레코드
+#define FRAME_BATCH_JSON 4              // 배치 JSON 문서를 그대로 담음
+#define FRAME_BATCH_COMPRESSED 5        // 시계열 압축 레코드
+#define FRAME_LIVE 6                    // UDP 최신값 스냅샷 (TCP 연결에는 쓰지 않음)
+#define FRAME_SUMMARY 7                 // 구간 요약 레코드
+#define FRAME_ACK 8                     // 서버 → 클라이언트: u64 seq (누적 확인)
+#define FRAME_TIME_REQUEST 9            // 클라이언트 → 서버: i64 t1
+#define FRAME_TIME_REPLY 10             // 서버 → 클라이언트: i64 t1 | i64 t2 | i64 t3
+#define FRAME_RELAY 11                  // 여러 노드의 배치 페이로드를 노드별 구간으로 묶음
+
+// 인코딩 (HELLO에는 지원 목록 비트마스크, HELLO_ACK에는 선택된 레코드 인코딩 하나)
+#define PROTOCOL_ENCODING_BINARY 0x01
+#define PROTOCOL_ENCODING_JSON 0x02
+#define PROTOCOL_ENCODING_COMPRESSED 0x04
+#define PROTOCOL_ENCODING_RECORDS 0x07  // 레코드 인코딩 비트
+// 추가 프레임 지원 (HELLO와 HELLO_ACK 모두 선택된 인코딩에 함께 표시)
+#define PROTOCOL_FEATURE_SUMMARY 0x80
+#define PROTOCOL_FEATURE_ACK 0x40
+#define PROTOCOL_FEATURE_CLOCK 0x20
+#define PROTOCOL_FEATURE_RELAY 0x10
+
+// 배치 페이로드: i64 base_ts(µs) | u16 count | u16 reserved | 레코드 * count
+#define PROTOCOL_BATCH_HEADER_SIZE 12
+// 레코드: u8 channel | u8 kind | u8 sensor_id | u8 quality | i32 dt(µs) | f32 value | f32 voltage
+#define PROTOCOL_RECORD_SIZE 16
+#define PROTOCOL_MAX_RECORDS ((PROTOCOL_MAX_PAYLOAD - PROTOCOL_BATCH_HEADER_SIZE) / PROTOCOL_RECORD_SIZE)
+
+typedef struct {
+    uint8_t type;
+    uint32_t length;
+} FrameHeader;
+
+typedef struct {
+    uint8_t version;
+    uint16_t schema_id;
+    uint8_t encodings;                  // HELLO: 지원 목록, HELLO_ACK: 선택된 인코딩
+    uint32_t node_id;
+} HelloInfo;
+
+// 와이어로 주고받는 측정값 한 건 (채널 메타데이터 포함)
+typedef struct {
+    uint8_t channel;
+    uint8_t kind;                       // SensorKind
+    uint8_t sensor_id;
+    uint8_t quality;
+    int64_t timestamp_us;
+    float value;
+    float voltage;
+    uint32_t node_id;                   // 중계한 레코드의 원래 노드 (0이면 보내는 노드 자신, 인코딩에는 없음)
+} WireRecord;
+
+// 헤더
+void protocol_write_header(uint8_t* buf, uint8_t type, uint32_t length);
+bool protocol_parse_header(const uint8_t* buf, FrameHeader* out);
+
+// 데이터 프레임의 seq 접두와 FRAME_ACK 페이로드 (u64)
+#define PROTOCOL_SEQ_SIZE 8
+void protocol_encode_seq(uint8_t* buf, uint64_t seq);
+uint64_t protocol_decode_seq(const uint8_t* buf);
+
+// 시각 동기 페이로드와 데이터 프레임의 offset 접두 (i64 µs UNIX 시각을 count개 이어 붙임)
+#define PROTOCOL_TIME_REQUEST_SIZE 8
+#define PROTOCOL_TIME_REPLY_SIZE 24
+#define PROTOCOL_OFFSET_SIZE 8
+void protocol_encode_time(uint8_t* buf, const int64_t* stamps, int count);
+void protocol_decode_time(const uint8_t* buf, int64_t* stamps, int count);
+
+// HELLO / HELLO_ACK 페이로드 (8바이트)
+#define PROTOCOL_HELLO_SIZE 8
+void protocol_encode_hello(uint8_t* buf, const HelloInfo* hello);
+bool protocol_decode_hello(const uint8_t* payload, size_t len, HelloInfo* out);
+
+// 배치 페이로드 인코딩: records[0]의 시각을 기준으로, 용량이나 dt 범위를 넘는 레코드에서 멈춤
+// 인코딩한 바이트 수를 반환하고 *consumed에 담은 레코드 수를 기록
+size_t protocol_encode_batch(uint8_t* buf, size_t capacity, const WireRecord* records, int count, int* consumed);
+
+// 배치 페이로드 디코딩: 레코드 수 반환, 형식이 잘못되면 -1
+int protocol_decode_batch(const uint8_t* payload, size_t len, WireRecord* out, int max);
+
+// 최신값 스냅샷 (UDP 데이터그램 하나 = 헤더 + 페이로드)
+// 페이로드: u32 node_id | u32 seq | 배치 페이로드 (채널별 최신값, 기준 시각은 가장 최근 측정)
+// seq는 노드가 재시작하면 0부터 다시 시작하므로 받는 쪽은 작아진 seq도 새 스트림으로 받아들여야 함
+#define PROTOCOL_LIVE_HEADER_SIZE 8
+
+size_t protocol_encode_live(uint8_t* buf, size_t capacity, uint32_t node_id, uint32_t seq,
+                            const WireRecord* records, int count);
+int protocol_decode_live(const uint8_t* payload, size_t len, uint32_t* node_id, uint32_t* seq,
+                         WireRecord* out, int max);
+
+// 구간 요약 페이로드: i64 base_ts(µs) | u16 count | u16 reserved | 요약 레코드 * count
+// 요약 레코드: u8 channel | u8 kind | u8 sensor_id | u8 quality(구간 내 OR)
+//              | i32 dt(구간 시작, µs) | u32 window_ms | u32 count | f32 min | f32 max | f32 mean | f32 last
+#define PROTOCOL_SUMMARY_RECORD_SIZE 32
+#define PROTOCOL_MAX_SUMMARIES ((PROTOCOL_MAX_PAYLOAD - PROTOCOL_BATCH_HEADER_SIZE) / PROTOCOL_SUMMARY_RECORD_SIZE)
+
+// 한 채널의 한 구간 요약
+typedef struct {
+    uint8_t channel;
+    uint8_t kind;
+    uint8_t sensor_id;
+    uint8_t quality;
+    int64_t window_start_us;
+    uint32_t window_ms;
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float last;
+    uint32_t node_id;                   // 중계한 요약의 원래 노드 (0이면 보내는 노드 자신, 인코딩에는 없음)
+} SummaryRecord;
+
+// 배치와 같은 규칙: records[0]의 구간 시작을 기준으로, 용량이나 dt 범위를 넘는 레코드에서 멈춤
+size_t protocol_encode_summary(uint8_t* buf, size_t capacity, const SummaryRecord* records, int count,
+                               int* consumed);
+int protocol_decode_summary(const uint8_t* payload, size_t len, SummaryRecord* out, int max);
+
+// 압축 배치 페이로드: i64 base_ts(µs) | u16 count | u16 reserved | 비트 스트림
+// 채널별로 앞 레코드와의 차이만 기록 (프레임마다 상태를 새로 시작하므로 프레임 단위로 독립 복원)
+//   channel(4) | 채널의 첫 레코드: kind(8) sensor_id(8) quality(8) dt(32) value(32) voltage(32)
+//              | 이후 레코드: 메타데이터 변경(1 [+kind sensor_id quality 24]) | 시각 delta-of-delta | value XOR | voltage XOR
+#define PROTOCOL_COMPRESS_CHANNELS 16
+#define PROTOCOL_COMPRESS_MAX_RECORD_BITS 256   // 레코드 한 건의 최대 비트 수
+
+typedef struct {
+    bool seen;
+    uint8_t kind;
+    uint8_t sensor_id;
+    uint8_t quality;
+    int64_t timestamp_us;
+    int64_t delta_us;
+    uint32_t value_bits;
+    uint32_t voltage_bits;
+    uint8_t value_leading, value_trailing;
+    uint8_t voltage_leading, voltage_trailing;
+} CompressChannel;
+
+// 인코더/디코더 상태 (고정 크기, 레코드 단위로 진행)
+typedef struct {
+    uint8_t* buf;
+    size_t capacity;
+    size_t bits;
+    int count;
+    int64_t base_ts;
+    CompressChannel channels[PROTOCOL_COMPRESS_CHANNELS];
+} CompressEncoder;
+
+typedef struct {
+    const uint8_t* buf;
+    size_t total_bits;
+    size_t bits;
+    int remaining;
+    int64_t base_ts;
+    CompressChannel channels[PROTOCOL_COMPRESS_CHANNELS];
+} CompressDecoder;
+
+// 인코딩: begin → add(레코드마다) → finish가 페이로드 길이 반환
+// add는 버퍼가 모자라거나 채널/시각이 범위를 벗어나면 false (그 레코드는 기록되지 않음)
+void protocol_compress_begin(CompressEncoder* enc, uint8_t* buf, size_t capacity, int64_t base_ts);
+bool protocol_compress_add(CompressEncoder* enc, const WireRecord* record);
+size_t protocol_compress_finish(CompressEncoder* enc);
+
+// 스트리밍 디코딩: next가 1이면 out에 한 건, 0이면 끝, -1이면 형식 오류
+bool protocol_decompress_begin(CompressDecoder* dec, const uint8_t* payload, size_t len);
+int protocol_decompress_next(CompressDecoder* dec, WireRecord* out);
+
+// 중계 페이로드: 구간 * n (같은 노드가 여러 구간에 나올 수 있음)
+// 구간: u32 node_id(0이면 보낸 노드 자신) | u8 type(FRAME_BATCH, FRAME_BATCH_COMPRESSED, FRAME_SUMMARY)
+//       | u8 reserved | u16 reserved | u32 length | 그 종류의 페이로드
+#define PROTOCOL_RELAY_SECTION_HEADER_SIZE 12
+
+typedef struct {
+    uint32_t node_id;
+    uint8_t type;
+    uint32_t length;
+    const uint8_t* payload;
+} RelaySection;
+
+// 구간 헤더 기록 (배치 페이로드는 호출자가 buf + PROTOCOL_RELAY_SECTION_HEADER_SIZE에 인코딩)
+void protocol_encode_relay_section(uint8_t* buf, uint32_t node_id, uint8_t type, uint32_t length);
+
+// *offset부터 구간 하나를 읽고 offset을 다음 구간으로: 1이면 out에 한 구간, 0이면 끝, -1이면 형식 오류
+int protocol_next_relay_section(const uint8_t* payload, size_t len, size_t* offset, RelaySection* out);
+
+// 센서 종류별 서버 테이블과 값 필드 이름 (알 수 없는 종류면 NULL)
+const char* protocol_kind_table(int kind);
+const char* protocol_kind_field(int kind);
+
+#endif
@@ -0,0 +1,175 @@
+#include "readings.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define CACHE_LINE_SIZE 64
+
+// 채널별 최신값 슬롯: 작성자 간 false sharing을 막기 위해 캐시 라인 단위로 정렬
+// seq가 홀수면 작성 중, 짝수면 안정 상태 (seqlock)
+typedef struct {
+    atomic_uint seq;
+    Reading reading;
+} __attribute__((aligned(CACHE_LINE_SIZE))) ReadingSlot;
+
+static ReadingSlot slots[NUM_CHANNELS];
+
+// 채널 메타데이터 (기본 채널은 초기화 시, 보조 채널은 수집 스레드가 실행 중에 등록)
+// 다른 스레드는 registered를 acquire로 읽은 뒤에만 나머지 필드를 읽음 (등록은 필드를 다 쓴 뒤 release)
+typedef struct {
+    atomic_bool registered;
+    SensorKind kind;
+    int sensor_id;
+    char name[16];
+} ChannelInfo;
+
+static ChannelInfo channels[NUM_CHANNELS];
+
+static const char* kind_names[SENSOR_KIND_COUNT] = {
+    [SENSOR_KIND_WATER_LEVEL] = "water_level",
+    [SENSOR_KIND_PH] = "ph",
+    [SENSOR_KIND_TEMPERATURE] = "temperature",
+    [SENSOR_KIND_CONDUCTIVITY] = "conductivity",
+    [SENSOR_KIND_ILLUMINANCE] = "illuminance",
+};
+
+static void set_channel_info(int channel, SensorKind kind, int sensor_id, const char* name) {
+    channels[channel].kind = kind;
+    channels[channel].sensor_id = sensor_id;
+    snprintf(channels[channel].name, sizeof(channels[channel].name), "%s", name);
+    atomic_store_explicit(&channels[channel].registered, true, memory_order_release);
+}
+
+static bool channel_registered(int channel) {
+    return atomic_load_explicit(&channels[channel].registered, memory_order_acquire);
+}
+
+int64_t reading_timestamp_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void readings_init(void) {
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        atomic_init(&slots[i].seq, 0);
+        memset(&slots[i].reading, 0, sizeof(Reading));
+        slots[i].reading.channel = i;
+    }
+
+    memset(channels, 0, sizeof(channels));
+    for (int i = 0; i < NUM_SENSORS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "water_level_%d", i);
+        set_channel_info(CHANNEL_WATER_LEVEL_BASE + i, SENSOR_KIND_WATER_LEVEL, i, name);
+    }
+    set_channel_info(CHANNEL_PH, SENSOR_KIND_PH, 0, "ph");
+}
+
+const char* readings_channel_name(int channel) {
+    if (channel < 0 || channel >= NUM_CHANNELS || !channel_registered(channel)) {
+        return "unknown";
+    }
+    return channels[channel].name;
+}
+
+int readings_kind_from_name(const char* name) {
+    for (int kind = 0; kind < SENSOR_KIND_COUNT; kind++) {
+        if (strcmp(kind_names[kind], name) == 0) {
+            return kind;
+        }
+    }
+    return -1;
+}
+
+bool readings_channel_info(int channel, SensorKind* kind, int* sensor_id) {
+    if (channel < 0 || channel >= NUM_CHANNELS || !channel_registered(channel)) {
+        return false;
+    }
+    *kind = channels[channel].kind;
+    *sensor_id = channels[channel].sensor_id;
+    return true;
+}
+
+int readings_register_channel(SensorKind kind, int sensor_id) {
+    if (kind < 0 || kind >= SENSOR_KIND_COUNT) {
+        return -1;
+    }
+
+    for (int ch = CHANNEL_AUX_BASE; ch < NUM_CHANNELS; ch++) {
+        if (channel_registered(ch) && channels[ch].kind == kind && channels[ch].sensor_id == sensor_id) {
+            return ch;
+        }
+    }
+
+    for (int ch = CHANNEL_AUX_BASE; ch < NUM_CHANNELS; ch++) {
+        if (!channel_registered(ch)) {
+            char name[16];
+            snprintf(name, sizeof(name), "%s_%d", kind_names[kind], sensor_id);
+            set_channel_info(ch, kind, sensor_id, name);
+            return ch;
+        }
+    }
+    return -1;
+}
+
+void readings_publish(const Reading* reading) {
+    if (reading->channel < 0 || reading->channel >= NUM_CHANNELS) {
+        return;
+    }
+
+    ReadingSlot* slot = &slots[reading->channel];
+    unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    // 작성 시작 (홀수), 이후의 데이터 쓰기가 seq 변경보다 먼저 보이지 않도록 fence
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->reading = *reading;
+
+    // 작성 완료 (짝수)
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+// 읽는 도중 작성이 겹친 경우에만 다시 읽음 (작성자는 절대 기다리지 않음)
+static void read_slot(const ReadingSlot* slot, Reading* out, unsigned int* seq_out) {
+    unsigned int seq_before, seq_after;
+
+    do {
+        seq_before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq_before & 1) {
+            continue;
+        }
+
+        *out = slot->reading;
+
+        atomic_thread_fence(memory_order_acquire);
+        seq_after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    } while ((seq_before & 1) || seq_before != seq_after);
+
+    *seq_out = seq_before;
+}
+
+bool readings_get(int channel, Reading* out) {
+    if (channel < 0 || channel >= NUM_CHANNELS) {
+        return false;
+    }
+
+    unsigned int seq;
+    read_slot(&slots[channel], out, &seq);
+    return seq != 0;
+}
+
+int readings_snapshot(Reading* out) {
+    int published = 0;
+
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        unsigned int seq;
+        read_slot(&slots[i], &out[i], &seq);
+        if (seq != 0) {
+            published++;
+        }
+    }
+    return published;
+}
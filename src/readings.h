@@ -0,0 +1,44 @@
+#ifndef READINGS_H
+#define READINGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+#include "config.h"
+
+// 채널 번호: 수위 센서 0~(NUM_SENSORS-1), 그 다음이 pH, 이후는 보조 센서(수집 링으로 들어오는 값)
+#define CHANNEL_WATER_LEVEL_BASE 0
+#define CHANNEL_PH NUM_SENSORS
+#define CHANNEL_AUX_BASE (NUM_SENSORS + 1)
+#define NUM_AUX_CHANNELS 8
+#define NUM_CHANNELS (CHANNEL_AUX_BASE + NUM_AUX_CHANNELS)
+
+// 최신값 테이블 초기화 (모든 슬롯을 측정 전 상태로)
+void readings_init(void);
+
+// 채널의 최신값 게시 (채널별 작성자는 한 스레드뿐이어야 함, 읽는 쪽을 기다리지 않음)
+void readings_publish(const Reading* reading);
+
+// 한 채널의 최신값 읽기 (아직 측정값이 없으면 false)
+bool readings_get(int channel, Reading* out);
+
+// 모든 채널의 최신값을 한 번에 읽기 (out은 NUM_CHANNELS개), 측정값이 있는 채널 수 반환
+int readings_snapshot(Reading* out);
+
+// 채널 이름 (예: "water_level_0", "ph", "temperature_1")
+const char* readings_channel_name(int channel);
+
+// 채널의 센서 종류와 센서 번호 (등록되지 않은 보조 채널이면 false)
+bool readings_channel_info(int channel, SensorKind* kind, int* sensor_id);
+
+// 센서 종류 이름("water_level", "ph", ...)으로 종류 찾기 (없으면 -1)
+int readings_kind_from_name(const char* name);
+
+// 보조 센서에 채널 할당 (이미 할당돼 있으면 그 채널, 빈 채널이 없으면 -1)
+// 수집 스레드 한 곳에서만 호출
+int readings_register_channel(SensorKind kind, int sensor_id);
+
+// 현재 시각 (epoch 기준 µs)
+int64_t reading_timestamp_now(void);
+
+#endif
@@ -0,0 +1,190 @@
+#define _GNU_SOURCE
+#include "realtime.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+static RealtimeConfig rt_config = { .acquisition_cpu = -1, .uplink_cpu = -1 };
+static bool memory_locked = false;
+static atomic_int thread_setup_failures = 0;
+static char description[160];
+
+// /proc/self/status의 VmLck 값으로 mlockall이 실제 적용됐는지 확인
+static long read_locked_memory_kb(void) {
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (!fp) {
+        return -1;
+    }
+
+    char line[128];
+    long locked_kb = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "VmLck: %ld kB", &locked_kb) == 1) {
+            break;
+        }
+    }
+    fclose(fp);
+    return locked_kb;
+}
+
+static bool check_rlimits(void) {
+    struct rlimit limit;
+    bool ok = true;
+
+    if (geteuid() == 0) {
+        return true;
+    }
+
+    if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY && (int)limit.rlim_cur < rt_config.fifo_priority) {
+        log_error("RLIMIT_RTPRIO (%ld) is below requested priority %d",
+                  (long)limit.rlim_cur, rt_config.fifo_priority);
+        ok = false;
+    }
+
+    if (rt_config.lock_memory && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 &&
+        limit.rlim_cur != RLIM_INFINITY) {
+        log_info("RLIMIT_MEMLOCK is %ld bytes; mlockall may fail for large address spaces",
+                 (long)limit.rlim_cur);
+    }
+
+    return ok;
+}
+
+static bool lock_memory(void) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        log_error("mlockall failed: %s", strerror(errno));
+        return false;
+    }
+
+    long locked_kb = read_locked_memory_kb();
+    if (locked_kb <= 0) {
+        log_error("mlockall returned success but VmLck is %ld kB", locked_kb);
+        return false;
+    }
+
+    log_info("Memory locked: VmLck=%ld kB", locked_kb);
+    return true;
+}
+
+bool realtime_init(const RealtimeConfig* config) {
+    memcpy(&rt_config, config, sizeof(RealtimeConfig));
+
+    if (!rt_config.enabled) {
+        snprintf(description, sizeof(description), "realtime disabled");
+        return true;
+    }
+
+    bool ok = check_rlimits();
+
+    if (rt_config.lock_memory) {
+        memory_locked = lock_memory();
+        ok = ok && memory_locked;
+    }
+
+    realtime_prefault_stack((size_t)rt_config.prefault_stack_kb * 1024);
+
+    snprintf(description, sizeof(description),
+             "SCHED_FIFO prio=%d, acquisition_cpu=%d, uplink_cpu=%d, mlockall=%s",
+             rt_config.fifo_priority, rt_config.acquisition_cpu, rt_config.uplink_cpu,
+             memory_locked ? "on" : "off");
+    log_info("Realtime settings: %s", description);
+
+    return ok;
+}
+
+static bool apply_affinity(const char* name, int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        log_error("Thread %s: failed to pin to CPU %d: %s", name, cpu, strerror(err));
+        return false;
+    }
+
+    // 실제로 적용된 affinity 확인
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0 ||
+        CPU_COUNT(&set) != 1 || !CPU_ISSET(cpu, &set)) {
+        log_error("Thread %s: CPU affinity verification failed", name);
+        return false;
+    }
+    return true;
+}
+
+static bool apply_fifo(const char* name, int rt_priority) {
+    struct sched_param param = { .sched_priority = rt_priority };
+
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+        log_error("Thread %s: failed to set SCHED_FIFO %d: %s", name, rt_priority, strerror(err));
+        return false;
+    }
+
+    // 실제로 적용된 정책과 우선순위 확인
+    int policy;
+    if (pthread_getschedparam(pthread_self(), &policy, &param) != 0 ||
+        policy != SCHED_FIFO || param.sched_priority != rt_priority) {
+        log_error("Thread %s: scheduler verification failed", name);
+        return false;
+    }
+    return true;
+}
+
+bool realtime_setup_thread(const char* name, int rt_priority, int cpu) {
+    bool ok = true;
+
+    if (cpu >= 0) {
+        ok = apply_affinity(name, cpu) && ok;
+    }
+    if (rt_priority > 0) {
+        ok = apply_fifo(name, rt_priority) && ok;
+    }
+
+    if (rt_config.enabled) {
+        realtime_prefault_stack((size_t)rt_config.prefault_stack_kb * 1024);
+    }
+
+    if (!ok) {
+        atomic_fetch_add(&thread_setup_failures, 1);
+    } else if (cpu >= 0 || rt_priority > 0) {
+        log_info("Thread %s: priority=%d cpu=%d applied", name, rt_priority, cpu);
+    }
+    return ok;
+}
+
+__attribute__((noinline))
+void realtime_prefault_stack(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+
+    unsigned char stack[bytes];
+    memset(stack, 0, bytes);
+    // 컴파일러가 memset을 제거하지 못하도록 함
+    __asm__ volatile("" : : "r"(stack) : "memory");
+}
+
+size_t realtime_thread_stack_size(void) {
+    if (rt_config.thread_stack_kb <= 0) {
+        return 0;
+    }
+    size_t size = (size_t)rt_config.thread_stack_kb * 1024;
+    return size < (size_t)PTHREAD_STACK_MIN ? (size_t)PTHREAD_STACK_MIN : size;
+}
+
+const char* realtime_describe(void) {
+    if (rt_config.enabled && atomic_load(&thread_setup_failures) > 0) {
+        return "realtime requested but not fully applied";
+    }
+    return description[0] ? description : "realtime disabled";
+}
@@ -0,0 +1,24 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+// 프로세스 전체 설정 적용 (메모리 잠금, 리소스 한도 확인)
+bool realtime_init(const RealtimeConfig* config);
+
+// 현재 스레드에 SCHED_FIFO 우선순위와 CPU 고정을 적용하고 실제 적용 여부를 검증
+// rt_priority가 0이면 기본 스케줄러 유지, cpu가 음수면 CPU 고정 안 함
+bool realtime_setup_thread(const char* name, int rt_priority, int cpu);
+
+// 스택 페이지를 미리 접근해 측정 중 페이지 폴트가 나지 않도록 함
+void realtime_prefault_stack(size_t bytes);
+
+// 스레드 생성 시 사용할 스택 크기 (0이면 시스템 기본값)
+size_t realtime_thread_stack_size(void);
+
+// 지터 리포트에 표시할 현재 설정 요약
+const char* realtime_describe(void);
+
+#endif
@@ -0,0 +1,522 @@
+#define _GNU_SOURCE
+#include "relay.h"
+#include "uplink.h"
+#include "aggregate.h"
+#include "protocol.h"
+#include "readings.h"
+#include "logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// 프레임이 없어도 이 주기로 깨어나 하트비트를 남김
+#define RELAY_IDLE_WAIT_MS 100
+#define RELAY_LISTEN_BACKLOG 16
+
+// 노드별 확인 응답 high-water mark: 다시 연결한 노드에 HELLO 직후 알려 이미 맡은 프레임을 다시 받지 않음
+// 메모리에만 두므로 게이트웨이가 재시작하면 0부터 (그 사이 확인하지 못한 프레임은 한 번 더 중계될 수 있음)
+typedef struct {
+    uint32_t node_id;           // 0이면 빈 칸
+    uint64_t high_water;
+    bool connected;
+} RelayNode;
+
+// 하위 노드 연결 (기다리지 않고 와 있는 만큼 읽어 프레임 하나가 찰 때까지 buf에 모음)
+typedef struct {
+    int socket;                 // -1이면 빈 칸
+    char peer[INET_ADDRSTRLEN];
+    RelayNode* node;            // HELLO 이후
+    bool acks;
+    bool clock;
+    bool relay;                 // 하위 게이트웨이 (FRAME_RELAY를 보냄)
+    uint8_t* buf;               // 헤더 + 페이로드
+    size_t len;
+    uint64_t frames;
+} RelayClient;
+
+static RelayConfig relay_config;
+static int listen_socket = -1;
+static RelayClient* clients = NULL;
+static RelayNode* nodes = NULL;
+static struct pollfd* fds = NULL;
+static RelayClient** owners = NULL;
+
+static WireRecord records[PROTOCOL_MAX_RECORDS];
+static SummaryRecord summaries[PROTOCOL_MAX_SUMMARIES];
+
+static _Atomic int connected_count;
+static _Atomic uint64_t frame_count;
+static _Atomic uint64_t record_count;
+static _Atomic uint64_t summary_count;
+static _Atomic uint64_t duplicate_count;
+static _Atomic uint64_t rejected_count;    // 자리가 없거나 협상할 수 없어 닫은 연결
+
+bool relay_init(const RelayConfig* config) {
+    struct sockaddr_in addr = {0};
+
+    relay_config = *config;
+    if (relay_config.max_nodes < 1) {
+        relay_config.max_nodes = DEFAULT_RELAY_MAX_NODES;
+    }
+
+    clients = calloc(relay_config.max_nodes, sizeof(RelayClient));
+    nodes = calloc(relay_config.max_nodes, sizeof(RelayNode));
+    fds = calloc(relay_config.max_nodes + 1, sizeof(struct pollfd));
+    owners = calloc(relay_config.max_nodes + 1, sizeof(RelayClient*));
+    if (!clients || !nodes || !fds || !owners) {
+        log_error("Failed to allocate relay state (%d nodes)", relay_config.max_nodes);
+        relay_cleanup();
+        return false;
+    }
+    for (int i = 0; i < relay_config.max_nodes; i++) {
+        clients[i].socket = -1;
+    }
+
+    listen_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_socket < 0) {
+        log_error("Relay socket creation failed: %s", strerror(errno));
+        relay_cleanup();
+        return false;
+    }
+
+    // 재시작 직후 TIME_WAIT 연결이 남아 있어도 바로 다시 받음
+    int reuse = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(relay_config.port);
+    if (bind(listen_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listen_socket, RELAY_LISTEN_BACKLOG) < 0) {
+        log_error("Relay cannot listen on port %d: %s", relay_config.port, strerror(errno));
+        relay_cleanup();
+        return false;
+    }
+
+    log_info("Relay: accepting up to %d nodes on port %d", relay_config.max_nodes, relay_config.port);
+    return true;
+}
+
+// 작은 응답 프레임 전송 (하위 노드가 읽지 않아 송신 버퍼가 찼으면 연결을 닫음)
+static bool send_reply(RelayClient* c, const uint8_t* frame, size_t len) {
+    return send(c->socket, frame, len, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)len;
+}
+
+static bool send_ack(RelayClient* c, uint64_t seq) {
+    uint8_t frame[PROTOCOL_HEADER_SIZE + PROTOCOL_SEQ_SIZE];
+    protocol_write_header(frame, FRAME_ACK, PROTOCOL_SEQ_SIZE);
+    protocol_encode_seq(frame + PROTOCOL_HEADER_SIZE, seq);
+    return send_reply(c, frame, sizeof(frame));
+}
+
+static void drop_client(RelayClient* c) {
+    if (c->node) {
+        log_info("Relay: node %u at %s disconnected (%llu frames)", c->node->node_id, c->peer,
+                 (unsigned long long)c->frames);
+        c->node->connected = false;
+        atomic_fetch_sub_explicit(&connected_count, 1, memory_order_relaxed);
+    }
+    close(c->socket);
+    c->socket = -1;
+    c->node = NULL;
+    c->len = 0;
+}
+
+// 노드의 칸: 처음 보는 노드면 빈 칸이나 연결이 끊긴 노드의 칸을 씀 (그 노드의 high-water mark는 잊음)
+static RelayNode* find_node(uint32_t node_id) {
+    RelayNode* spare = NULL;
+
+    for (int i = 0; i < relay_config.max_nodes; i++) {
+        if (nodes[i].node_id == node_id) {
+            return &nodes[i];
+        }
+        if (!spare && (nodes[i].node_id == 0 || !nodes[i].connected)) {
+            spare = &nodes[i];
+        }
+    }
+    if (spare) {
+        spare->node_id = node_id;
+        spare->high_water = 0;
+        spare->connected = false;
+    }
+    return spare;
+}
+
+// HELLO에 서버처럼 응답: 압축 > 바이너리 순으로 고르고 요약·확인 응답·시계 오프셋·중계는 요청한 대로
+// JSON만 보내는 노드와 node_id가 없는 노드(어느 노드의 레코드인지 남길 수 없음)는 받지 않음
+static bool answer_hello(RelayClient* c, const uint8_t* payload, size_t len) {
+    HelloInfo hello, ack;
+
+    if (c->node || !protocol_decode_hello(payload, len, &hello)) {
+        return false;
+    }
+    if (hello.node_id == 0 || hello.schema_id != PROTOCOL_SCHEMA_ID ||
+        !(hello.encodings & (PROTOCOL_ENCODING_BINARY | PROTOCOL_ENCODING_COMPRESSED))) {
+        log_error("Relay: cannot relay node %u at %s (schema %d, encodings 0x%02x)", hello.node_id, c->peer,
+                  hello.schema_id, hello.encodings);
+        atomic_fetch_add_explicit(&rejected_count, 1, memory_order_relaxed);
+        return false;
+    }
+
+    RelayNode* node = find_node(hello.node_id);
+    if (!node) {
+        log_error("Relay: no room for node %u at %s", hello.node_id, c->peer);
+        atomic_fetch_add_explicit(&rejected_count, 1, memory_order_relaxed);
+        return false;
+    }
+    // 끊긴 줄 모르는 이전 연결이 남아 있으면 새 연결이 이어받음
+    if (node->connected) {
+        for (int i = 0; i < relay_config.max_nodes; i++) {
+            if (clients[i].socket >= 0 && clients[i].node == node) {
+                drop_client(&clients[i]);
+            }
+        }
+    }
+
+    ack.version = hello.version < PROTOCOL_VERSION ? hello.version : PROTOCOL_VERSION;
+    ack.schema_id = PROTOCOL_SCHEMA_ID;
+    ack.node_id = hello.node_id;
+    ack.encodings = (hello.encodings & PROTOCOL_ENCODING_COMPRESSED) ? PROTOCOL_ENCODING_COMPRESSED
+                                                                      : PROTOCOL_ENCODING_BINARY;
+    ack.encodings |= hello.encodings & (PROTOCOL_FEATURE_SUMMARY | PROTOCOL_FEATURE_ACK | PROTOCOL_FEATURE_CLOCK |
+                                        PROTOCOL_FEATURE_RELAY);
+
+    c->node = node;
+    c->acks = (ack.encodings & PROTOCOL_FEATURE_ACK) != 0;
+    c->clock = (ack.encodings & PROTOCOL_FEATURE_CLOCK) != 0;
+    c->relay = (ack.encodings & PROTOCOL_FEATURE_RELAY) != 0;
+    node->connected = true;
+    atomic_fetch_add_explicit(&connected_count, 1, memory_order_relaxed);
+
+    uint8_t reply[PROTOCOL_HEADER_SIZE + PROTOCOL_HELLO_SIZE];
+    protocol_write_header(reply, FRAME_HELLO_ACK, PROTOCOL_HELLO_SIZE);
+    protocol_encode_hello(reply + PROTOCOL_HEADER_SIZE, &ack);
+
+    log_info("Relay: node %u connected from %s (%s records%s%s)", hello.node_id, c->peer,
+             (ack.encodings & PROTOCOL_ENCODING_COMPRESSED) ? "compressed" : "binary",
+             c->acks ? ", acknowledged" : "", c->relay ? ", gateway" : "");
+    if (!send_reply(c, reply, sizeof(reply))) {
+        return false;
+    }
+    return !c->acks || send_ack(c, node->high_water);
+}
+
+// 시각 요청에는 이 노드의 시계로 답함 (하위 노드의 오프셋은 게이트웨이 시계 기준이 됨)
+static bool answer_time_request(RelayClient* c, const uint8_t* payload, size_t len, int64_t received_us) {
+    uint8_t reply[PROTOCOL_HEADER_SIZE + PROTOCOL_TIME_REPLY_SIZE];
+    int64_t stamps[3];
+
+    if (len != PROTOCOL_TIME_REQUEST_SIZE) {
+        return false;
+    }
+    protocol_decode_time(payload, stamps, 1);
+    stamps[1] = received_us;
+    stamps[2] = reading_timestamp_now();
+    protocol_write_header(reply, FRAME_TIME_REPLY, PROTOCOL_TIME_REPLY_SIZE);
+    protocol_encode_time(reply + PROTOCOL_HEADER_SIZE, stamps, 3);
+    return send_reply(c, reply, sizeof(reply));
+}
+
+// 배치 페이로드 하나를 풀어 out에 (레코드 수, 형식이 잘못됐거나 max를 넘으면 -1)
+static int decode_section(uint8_t type, const uint8_t* payload, size_t len, WireRecord* out, int max) {
+    if (type == FRAME_BATCH) {
+        return protocol_decode_batch(payload, len, out, max);
+    }
+    if (type != FRAME_BATCH_COMPRESSED) {
+        return -1;
+    }
+
+    CompressDecoder decoder;
+    int n = 0;
+    if (!protocol_decompress_begin(&decoder, payload, len)) {
+        return -1;
+    }
+    for (;;) {
+        if (n == max) {
+            return decoder.remaining == 0 ? n : -1;
+        }
+        int status = protocol_decompress_next(&decoder, &out[n]);
+        if (status <= 0) {
+            return status == 0 ? n : -1;
+        }
+        n++;
+    }
+}
+
+// 데이터 프레임의 레코드는 records에, 구간 요약은 summaries에 풀고 원래 노드와 이 노드 시계 기준 시각을 붙임
+// 하위 게이트웨이의 중계 프레임이면 구간마다 (node_id 0 구간은 그 게이트웨이 자신)
+// 반환: 레코드 수 (형식이 잘못됐으면 -1), 요약 수는 *summary_out
+static int decode_frame(RelayClient* c, uint8_t type, const uint8_t* payload, size_t len, int64_t offset_us,
+                        int* summary_out) {
+    RelaySection section = { .node_id = 0, .type = type, .length = len, .payload = payload };
+    size_t offset = 0;
+    int count = 0;
+    int summary_n = 0;
+
+    *summary_out = 0;
+    for (;;) {
+        if (type == FRAME_RELAY) {
+            int status = protocol_next_relay_section(payload, len, &offset, &section);
+            if (status <= 0) {
+                *summary_out = summary_n;
+                return status == 0 ? count : -1;
+            }
+        }
+
+        uint32_t node_id = section.node_id != 0 ? section.node_id : c->node->node_id;
+        if (section.type == FRAME_SUMMARY) {
+            int n = protocol_decode_summary(section.payload, section.length, summaries + summary_n,
+                                            PROTOCOL_MAX_SUMMARIES - summary_n);
+            if (n < 0) {
+                return -1;
+            }
+            for (int i = summary_n; i < summary_n + n; i++) {
+                summaries[i].node_id = node_id;
+                summaries[i].window_start_us += offset_us;
+            }
+            summary_n += n;
+        } else {
+            int n = decode_section(section.type, section.payload, section.length, records + count,
+                                   PROTOCOL_MAX_RECORDS - count);
+            if (n < 0) {
+                return -1;
+            }
+            for (int i = count; i < count + n; i++) {
+                records[i].node_id = node_id;
+                records[i].timestamp_us += offset_us;
+            }
+            count += n;
+        }
+
+        if (type != FRAME_RELAY) {
+            *summary_out = summary_n;
+            return count;
+        }
+    }
+}
+
+// 데이터 프레임: seq가 high-water mark 이하면 이미 맡은 재전송이므로 확인만 다시 보냄
+// 업링크가 레코드를 맡지 못하면 확인하지 않고 연결을 닫아 하위 노드가 나중에 다시 보내게 함
+// 요약은 업링크 요약 대기열에 넣음 (자기 요약과 같이 넘치면 오래된 것부터 버림)
+static bool relay_data(RelayClient* c, uint8_t type, const uint8_t* payload, size_t len) {
+    uint64_t seq = 0;
+    int64_t offset_us = 0;
+
+    if (c->acks) {
+        if (len < PROTOCOL_SEQ_SIZE) {
+            return false;
+        }
+        seq = protocol_decode_seq(payload);
+        payload += PROTOCOL_SEQ_SIZE;
+        len -= PROTOCOL_SEQ_SIZE;
+        if (seq <= c->node->high_water) {
+            atomic_fetch_add_explicit(&duplicate_count, 1, memory_order_relaxed);
+            return send_ack(c, c->node->high_water);
+        }
+    }
+    if (c->clock) {
+        if (len < PROTOCOL_OFFSET_SIZE) {
+            return false;
+        }
+        protocol_decode_time(payload, &offset_us, 1);
+        payload += PROTOCOL_OFFSET_SIZE;
+        len -= PROTOCOL_OFFSET_SIZE;
+    }
+
+    // 손상된 프레임은 버리고 확인 (서버와 같이, 다시 보내도 같은 내용이므로)
+    int summary_n = 0;
+    int count = decode_frame(c, type, payload, len, offset_us, &summary_n);
+    if (count < 0) {
+        log_error("Relay: malformed frame from node %u (%zu bytes), discarded", c->node->node_id, len);
+    } else if (count > 0 && !uplink_relay(records, count)) {
+        log_error("Relay: uplink cannot take %d records from node %u, closing connection", count,
+                  c->node->node_id);
+        return false;
+    } else {
+        aggregate_relay(summaries, summary_n);
+        atomic_fetch_add_explicit(&record_count, count, memory_order_relaxed);
+        atomic_fetch_add_explicit(&summary_count, summary_n, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&frame_count, 1, memory_order_relaxed);
+    c->frames++;
+    if (seq != 0) {
+        c->node->high_water = seq;
+        return send_ack(c, seq);
+    }
+    return true;
+}
+
+static bool handle_frame(RelayClient* c, const FrameHeader* header, const uint8_t* payload) {
+    int64_t received_us = reading_timestamp_now();
+
+    if (header->type == FRAME_HELLO) {
+        return answer_hello(c, payload, header->length);
+    }
+    if (!c->node) {
+        log_error("Relay: frame type %d from %s before HELLO, closing connection", header->type, c->peer);
+        return false;
+    }
+
+    switch (header->type) {
+    case FRAME_TIME_REQUEST:
+        return answer_time_request(c, payload, header->length, received_us);
+    case FRAME_BATCH:
+    case FRAME_BATCH_COMPRESSED:
+    case FRAME_SUMMARY:
+        return relay_data(c, header->type, payload, header->length);
+    case FRAME_RELAY:
+        if (c->relay) {
+            return relay_data(c, header->type, payload, header->length);
+        }
+        break;
+    default:
+        break;
+    }
+    log_error("Relay: unexpected frame type %d from node %u, closing connection", header->type, c->node->node_id);
+    return false;
+}
+
+// 와 있는 바이트를 읽어 완성된 프레임을 차례로 처리 (false면 연결을 닫음)
+static bool service_client(RelayClient* c) {
+    FrameHeader header;
+
+    for (;;) {
+        size_t want = PROTOCOL_HEADER_SIZE;
+        if (c->len >= PROTOCOL_HEADER_SIZE) {
+            if (!protocol_parse_header(c->buf, &header)) {
+                log_error("Relay: invalid frame header from %s, closing connection", c->peer);
+                return false;
+            }
+            want += header.length;
+        }
+        if (c->len < want) {
+            ssize_t n = recv(c->socket, c->buf + c->len, want - c->len, 0);
+            if (n == 0) {
+                return false;
+            }
+            if (n < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            }
+            c->len += n;
+            continue;
+        }
+
+        c->len = 0;
+        if (!handle_frame(c, &header, c->buf + PROTOCOL_HEADER_SIZE)) {
+            return false;
+        }
+    }
+}
+
+static void accept_clients(void) {
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int sock = accept4(listen_socket, (struct sockaddr*)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                log_error("Relay accept failed: %s", strerror(errno));
+            }
+            return;
+        }
+
+        RelayClient* c = NULL;
+        for (int i = 0; i < relay_config.max_nodes && !c; i++) {
+            if (clients[i].socket < 0) {
+                c = &clients[i];
+            }
+        }
+        // 버퍼는 처음 쓰는 칸에만 잡고 이후 연결에 재사용
+        if (c && !c->buf) {
+            c->buf = malloc(PROTOCOL_HEADER_SIZE + PROTOCOL_MAX_PAYLOAD);
+        }
+        if (!c || !c->buf) {
+            log_error("Relay: too many nodes, refusing connection");
+            atomic_fetch_add_explicit(&rejected_count, 1, memory_order_relaxed);
+            close(sock);
+            continue;
+        }
+
+        c->socket = sock;
+        c->node = NULL;
+        c->len = 0;
+        c->frames = 0;
+        inet_ntop(AF_INET, &addr.sin_addr, c->peer, sizeof(c->peer));
+    }
+}
+
+void* relay_thread(void* arg) {
+    (void)arg;
+    int count = 0;
+
+    if (listen_socket < 0) {
+        return NULL;
+    }
+
+    fds[count] = (struct pollfd){ .fd = listen_socket, .events = POLLIN };
+    owners[count++] = NULL;
+    for (int i = 0; i < relay_config.max_nodes; i++) {
+        if (clients[i].socket >= 0) {
+            fds[count] = (struct pollfd){ .fd = clients[i].socket, .events = POLLIN };
+            owners[count++] = &clients[i];
+        }
+    }
+
+    if (poll(fds, count, RELAY_IDLE_WAIT_MS) <= 0) {
+        return NULL;
+    }
+    for (int i = 1; i < count; i++) {
+        // 앞 연결의 HELLO가 같은 노드의 이전 연결을 이미 닫았을 수 있음
+        if (fds[i].revents != 0 && owners[i]->socket == fds[i].fd && !service_client(owners[i])) {
+            drop_client(owners[i]);
+        }
+    }
+    if (fds[0].revents & POLLIN) {
+        accept_clients();
+    }
+    return NULL;
+}
+
+void relay_report_stats(void) {
+    if (listen_socket < 0) {
+        return;
+    }
+    log_info("Relay: %d nodes connected, %llu frames, %llu records and %llu summaries relayed, "
+             "%llu duplicate frames, %llu connections refused",
+             atomic_load_explicit(&connected_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&frame_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&record_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&summary_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&duplicate_count, memory_order_relaxed),
+             (unsigned long long)atomic_load_explicit(&rejected_count, memory_order_relaxed));
+}
+
+void relay_cleanup(void) {
+    if (clients) {
+        for (int i = 0; i < relay_config.max_nodes; i++) {
+            if (clients[i].socket >= 0) {
+                close(clients[i].socket);
+            }
+            free(clients[i].buf);
+        }
+    }
+    if (listen_socket >= 0) {
+        close(listen_socket);
+        listen_socket = -1;
+    }
+    free(clients);
+    free(nodes);
+    free(fds);
+    free(owners);
+    clients = NULL;
+    nodes = NULL;
+    fds = NULL;
+    owners = NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef RELAY_H
+#define RELAY_H
+
+#include <stdbool.h>
+#include "config.h"
+
+// 게이트웨이 중계: 주변 노드의 업링크 연결을 서버와 같은 프로토콜로 받음
+// HELLO에 서버처럼 응답하고(바이너리/압축 레코드, 확인 응답, 시계 오프셋, 하위 게이트웨이의 중계 프레임),
+// 받은 레코드는 원래 node_id와 이 노드 시계 기준 시각으로 바꿔 이 노드의 업링크 배치에 합침 (구간 요약은 요약 대기열에).
+// 확인 응답은 업링크(중계 큐나 스풀)가 레코드를 맡은 뒤 보냄: 하위 노드는 게이트웨이까지만 확인하고,
+// 서버까지는 게이트웨이의 저장 후 전달(재전송, 스풀)이 책임짐
+
+// 수신 소켓 준비 (업링크 중계 큐는 uplink_relay_init으로 먼저), 실패하면 false
+bool relay_init(const RelayConfig* config);
+
+// 중계 스레드 함수 (한 주기): 새 연결을 받고 와 있는 프레임을 처리 (프레임이 없으면 잠시 대기)
+void* relay_thread(void* arg);
+
+// 연결된 노드 수와 중계한 프레임/레코드 수 로그
+void relay_report_stats(void);
+
+void relay_cleanup(void);
+
+#endif
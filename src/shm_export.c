@@ -0,0 +1,139 @@
+#include "shm_export.h"
+#include "wm_shm.h"
+#include "readings.h"
+#include "logger.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static WmShmSegment* segment = NULL;
+static char segment_name[64];
+
+bool shm_export_init(const char* name) {
+    strncpy(segment_name, name, sizeof(segment_name) - 1);
+
+    // 이전 실행이 남긴 세그먼트는 버리고 새로 생성 (기존 리더는 CLOSED 상태를 보고 다시 열어야 함)
+    shm_unlink(segment_name);
+
+    int fd = shm_open(segment_name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        log_error("shm_open(%s) failed: %s", segment_name, strerror(errno));
+        return false;
+    }
+
+    if (ftruncate(fd, sizeof(WmShmSegment)) != 0) {
+        log_error("ftruncate(%s) failed: %s", segment_name, strerror(errno));
+        close(fd);
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    segment = mmap(NULL, sizeof(WmShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (segment == MAP_FAILED) {
+        log_error("mmap(%s) failed: %s", segment_name, strerror(errno));
+        segment = NULL;
+        shm_unlink(segment_name);
+        return false;
+    }
+
+    memset(segment, 0, sizeof(WmShmSegment));
+    segment->version = WM_SHM_VERSION;
+    segment->segment_size = sizeof(WmShmSegment);
+    segment->num_channels = NUM_CHANNELS;
+    segment->history_size = WM_SHM_HISTORY_SIZE;
+    segment->writer_pid = getpid();
+    for (int i = 0; i < NUM_CHANNELS && i < WM_SHM_MAX_CHANNELS; i++) {
+        SensorKind kind;
+        int sensor_id;
+        segment->channels[i].sample.channel = i;
+        if (readings_channel_info(i, &kind, &sensor_id)) {
+            strncpy(segment->channels[i].name, readings_channel_name(i), WM_SHM_CHANNEL_NAME_LEN - 1);
+        }
+    }
+    atomic_store_explicit(&segment->state, WM_SHM_STATE_ACTIVE, memory_order_relaxed);
+
+    // 리더는 magic이 보여야 나머지 헤더를 신뢰함
+    atomic_store_explicit(&segment->magic, WM_SHM_MAGIC, memory_order_release);
+
+    log_info("Shared memory export ready: /dev/shm%s (%zu bytes)", segment_name, sizeof(WmShmSegment));
+    return true;
+}
+
+static void to_sample(const Reading* reading, WmSample* sample) {
+    sample->channel = reading->channel;
+    sample->value = reading->value;
+    sample->voltage = reading->voltage;
+    sample->quality = reading->quality;
+    sample->timestamp_us = reading->timestamp_us;
+}
+
+// 리더는 세그먼트를 읽기 전용으로 매핑하므로 대기자 수를 알 수 없음: 매번 FUTEX_WAKE
+// (측정 주기당 몇 번뿐이라 비용은 무시할 수준)
+static void wake_readers(void) {
+    atomic_fetch_add_explicit(&segment->update_seq, 1, memory_order_release);
+    syscall(SYS_futex, &segment->update_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void shm_export_publish(const Reading* reading) {
+    if (!segment || reading->channel < 0 || reading->channel >= WM_SHM_MAX_CHANNELS) {
+        return;
+    }
+
+    // 최신값 슬롯 (채널별 작성자는 하나)
+    WmChannelSlot* slot = &segment->channels[reading->channel];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    to_sample(reading, &slot->sample);
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+
+    // 이력 링 (여러 측정 스레드가 기록하므로 위치를 원자적으로 확보)
+    uint64_t pos = atomic_fetch_add_explicit(&segment->history_head, 1, memory_order_relaxed);
+    WmHistoryEntry* entry = &segment->history[pos & (WM_SHM_HISTORY_SIZE - 1)];
+    atomic_store_explicit(&entry->seq, pos * 2 + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    to_sample(reading, &entry->sample);
+    atomic_store_explicit(&entry->seq, pos * 2 + 2, memory_order_release);
+
+    wake_readers();
+}
+
+void shm_export_set_channel_name(int channel, const char* name) {
+    if (!segment || channel < 0 || channel >= WM_SHM_MAX_CHANNELS) {
+        return;
+    }
+    strncpy(segment->channels[channel].name, name, WM_SHM_CHANNEL_NAME_LEN - 1);
+}
+
+// 업링크 상태는 리더를 깨우지 않음 (리더가 필요할 때 읽음)
+void shm_export_set_uplink_stats(const WmUplinkStats* stats) {
+    if (!segment) {
+        return;
+    }
+
+    uint32_t seq = atomic_load_explicit(&segment->uplink_seq, memory_order_relaxed);
+    atomic_store_explicit(&segment->uplink_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    segment->uplink = *stats;
+    atomic_store_explicit(&segment->uplink_seq, seq + 2, memory_order_release);
+}
+
+void shm_export_cleanup(void) {
+    if (!segment) {
+        return;
+    }
+
+    atomic_store_explicit(&segment->state, WM_SHM_STATE_CLOSED, memory_order_release);
+    wake_readers();
+
+    munmap(segment, sizeof(WmShmSegment));
+    segment = NULL;
+    shm_unlink(segment_name);
+}
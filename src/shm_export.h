@@ -0,0 +1,23 @@
+#ifndef SHM_EXPORT_H
+#define SHM_EXPORT_H
+
+#include <stdbool.h>
+#include "types.h"
+#include "wm_shm.h"
+
+// 같은 보드의 다른 프로세스용 공유 메모리 세그먼트 생성 (/dev/shm 아래)
+bool shm_export_init(const char* name);
+
+// 최신값 슬롯과 이력 링에 기록하고 대기 중인 리더를 깨움
+void shm_export_publish(const Reading* reading);
+
+// 보조 채널이 새로 할당됐을 때 리더가 이름으로 찾을 수 있도록 기록
+void shm_export_set_channel_name(int channel, const char* name);
+
+// 업링크 큐 깊이와 버림/스풀/덮어쓰기 카운터 게시 (업링크 스레드만 호출)
+void shm_export_set_uplink_stats(const WmUplinkStats* stats);
+
+// 세그먼트를 종료 상태로 표시하고 해제
+void shm_export_cleanup(void);
+
+#endif
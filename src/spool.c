@@ -0,0 +1,361 @@
+#include "spool.h"
+#include "logger.h"
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SPOOL_MAGIC 0x57535031      // "WSP1"
+#define SPOOL_VERSION 2             // 2: 중계 레코드의 node_id 추가 (이전 형식 파일은 새로 만듦)
+#define SPOOL_HEADER_SIZE 4096      // 헤더는 한 페이지 (커서만 따로 동기화)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t write_seq;             // 다음에 기록할 순번
+    uint64_t read_seq;              // 서버로 보내지 않은 첫 순번 (내구 커서)
+} SpoolHeader;
+
+typedef struct {
+    uint64_t seq;                   // 칸이 담고 있는 순번 (이전 바퀴의 잔여 레코드 구분)
+    int64_t timestamp_us;
+    float value;
+    float voltage;
+    uint8_t channel;
+    uint8_t kind;
+    uint8_t sensor_id;
+    uint8_t quality;
+    uint32_t node_id;               // 중계한 레코드의 원래 노드 (0이면 이 노드)
+    uint32_t crc;                   // seq부터 node_id까지의 CRC-32
+} SpoolRecord;
+
+static uint8_t* map = NULL;
+static size_t map_size = 0;
+static SpoolHeader* header = NULL;
+static SpoolRecord* records = NULL;
+static pthread_mutex_t spool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t synced_seq = 0;     // 여기까지 디스크에 동기화됨
+static uint64_t peek_end = 0;       // 마지막 spool_peek이 읽은 다음 순번
+static uint64_t peek_corrupt = 0;
+static uint64_t overwritten = 0;
+static uint64_t corrupt = 0;
+
+static uint32_t crc_table[256];
+
+static void crc32_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t record_crc(const SpoolRecord* record) {
+    const uint8_t* p = (const uint8_t*)record;
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < offsetof(SpoolRecord, crc); i++) {
+        c = crc_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+static bool record_valid(const SpoolRecord* record, uint64_t seq) {
+    return record->seq == seq && record->crc == record_crc(record);
+}
+
+// 페이지 경계에 맞춰 구간을 디스크에 기록
+static void sync_range(size_t offset, size_t length) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset & ~(page - 1);
+    if (msync(map + start, offset + length - start, MS_SYNC) != 0) {
+        log_error("Spool msync failed: %s", strerror(errno));
+    }
+}
+
+static void sync_header(void) {
+    sync_range(0, sizeof(SpoolHeader));
+}
+
+// 순번 [first, end)의 레코드 칸을 동기화 (순환 시 두 구간)
+static void sync_records(uint64_t first, uint64_t end) {
+    uint64_t capacity = header->capacity;
+    if (end - first >= capacity) {
+        sync_range(SPOOL_HEADER_SIZE, capacity * sizeof(SpoolRecord));
+        return;
+    }
+
+    uint64_t a = first % capacity, b = end % capacity;
+    if (a < b) {
+        sync_range(SPOOL_HEADER_SIZE + a * sizeof(SpoolRecord), (b - a) * sizeof(SpoolRecord));
+    } else {
+        sync_range(SPOOL_HEADER_SIZE + a * sizeof(SpoolRecord), (capacity - a) * sizeof(SpoolRecord));
+        sync_range(SPOOL_HEADER_SIZE, b * sizeof(SpoolRecord));
+    }
+}
+
+// 헤더가 동기화되기 전에 꺼졌을 수 있으므로 유효한 레코드가 이어지는 만큼 write_seq를 당김
+static void recover(void) {
+    uint64_t capacity = header->capacity;
+
+    if (header->read_seq > header->write_seq || header->write_seq - header->read_seq > capacity) {
+        log_error("Spool cursor inconsistent (read %llu, write %llu), discarding backlog",
+                  (unsigned long long)header->read_seq, (unsigned long long)header->write_seq);
+        header->read_seq = header->write_seq;
+    }
+
+    while (record_valid(&records[header->write_seq % capacity], header->write_seq)) {
+        header->write_seq++;
+        if (header->write_seq - header->read_seq > capacity) {
+            header->read_seq = header->write_seq - capacity;
+        }
+    }
+    sync_header();
+}
+
+bool spool_init(const SpoolConfig* config) {
+    crc32_init();
+
+    // 상위 디렉터리가 없으면 한 단계만 생성
+    char dir[sizeof(config->path)];
+    strncpy(dir, config->path, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+    if (mkdir(dirname(dir), 0755) != 0 && errno != EEXIST) {
+        log_error("Cannot create spool directory for %s: %s", config->path, strerror(errno));
+        return false;
+    }
+
+    if ((uint64_t)config->size_kb * 1024 < SPOOL_HEADER_SIZE + sizeof(SpoolRecord)) {
+        log_error("Spool size too small: %d KB", config->size_kb);
+        return false;
+    }
+    uint64_t capacity = ((uint64_t)config->size_kb * 1024 - SPOOL_HEADER_SIZE) / sizeof(SpoolRecord);
+    map_size = SPOOL_HEADER_SIZE + capacity * sizeof(SpoolRecord);
+
+    int fd = open(config->path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        log_error("Cannot open spool %s: %s", config->path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != map_size;
+    if (fresh && ftruncate(fd, map_size) != 0) {
+        log_error("ftruncate(%s) failed: %s", config->path, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_error("mmap(%s) failed: %s", config->path, strerror(errno));
+        map = NULL;
+        return false;
+    }
+    header = (SpoolHeader*)map;
+    records = (SpoolRecord*)(map + SPOOL_HEADER_SIZE);
+
+    if (fresh || header->magic != SPOOL_MAGIC || header->version != SPOOL_VERSION ||
+        header->capacity != capacity) {
+        memset(header, 0, sizeof(SpoolHeader));
+        header->magic = SPOOL_MAGIC;
+        header->version = SPOOL_VERSION;
+        header->capacity = capacity;
+        sync_header();
+        log_info("Spool created: %s (%llu records)", config->path, (unsigned long long)capacity);
+    } else {
+        recover();
+        log_info("Spool opened: %s (%llu of %llu records pending)", config->path,
+                 (unsigned long long)(header->write_seq - header->read_seq), (unsigned long long)capacity);
+    }
+
+    peek_end = header->read_seq;
+    synced_seq = header->write_seq;
+    return true;
+}
+
+static void fill_record(uint64_t seq, const WireRecord* in) {
+    SpoolRecord* record = &records[seq % header->capacity];
+    record->seq = seq;
+    record->timestamp_us = in->timestamp_us;
+    record->value = in->value;
+    record->voltage = in->voltage;
+    record->channel = in->channel;
+    record->kind = in->kind;
+    record->sensor_id = in->sensor_id;
+    record->quality = in->quality;
+    record->node_id = in->node_id;
+    record->crc = record_crc(record);
+}
+
+// 레코드를 덧붙이고 write_seq 갱신 (spool_mutex 보유 상태, 디스크 동기화는 하지 않음)
+static void write_records(const WireRecord* in, int count) {
+    uint64_t seq = header->write_seq;
+    for (int i = 0; i < count; i++, seq++) {
+        // 가득 차면 가장 오래된 레코드를 버림
+        if (seq - header->read_seq >= header->capacity) {
+            header->read_seq++;
+            overwritten++;
+        }
+        fill_record(seq, &in[i]);
+    }
+    header->write_seq = seq;
+}
+
+// 아직 동기화하지 않은 레코드와 헤더를 디스크에 기록 (spool_mutex 보유 상태)
+static void flush_locked(void) {
+    if (synced_seq == header->write_seq) {
+        return;
+    }
+    // 레코드를 먼저 기록한 뒤 헤더 (헤더가 늦어도 recover가 복원)
+    sync_records(synced_seq, header->write_seq);
+    sync_header();
+    synced_seq = header->write_seq;
+}
+
+void spool_append(const WireRecord* in, int count) {
+    if (!header) {
+        log_error("Spool unavailable, dropping %d readings", count);
+        return;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    write_records(in, count);
+    flush_locked();
+    pthread_mutex_unlock(&spool_mutex);
+}
+
+bool spool_try_append(const WireRecord* in, int count) {
+    if (!header || pthread_mutex_trylock(&spool_mutex) != 0) {
+        return false;
+    }
+    write_records(in, count);
+    pthread_mutex_unlock(&spool_mutex);
+    return true;
+}
+
+void spool_sync(void) {
+    if (!header) {
+        return;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    flush_locked();
+    pthread_mutex_unlock(&spool_mutex);
+}
+
+int spool_peek(WireRecord* out, int max) {
+    if (!header) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+
+    uint64_t seq = header->read_seq;
+    int n = 0;
+    peek_corrupt = 0;
+    while (n < max && seq < header->write_seq) {
+        const SpoolRecord* record = &records[seq % header->capacity];
+        seq++;
+        if (!record_valid(record, seq - 1)) {
+            peek_corrupt++;
+            continue;
+        }
+
+        out[n].channel = record->channel;
+        out[n].kind = record->kind;
+        out[n].sensor_id = record->sensor_id;
+        out[n].quality = record->quality;
+        out[n].timestamp_us = record->timestamp_us;
+        out[n].value = record->value;
+        out[n].voltage = record->voltage;
+        out[n].node_id = record->node_id;
+        n++;
+    }
+    peek_end = seq;
+
+    pthread_mutex_unlock(&spool_mutex);
+    return n;
+}
+
+void spool_commit(void) {
+    spool_commit_unsent(NULL, 0);
+}
+
+void spool_commit_unsent(const WireRecord* unsent, int count) {
+    if (!header) {
+        return;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    // 그사이 덮어쓰기로 커서가 더 앞서갔다면 그대로 둠
+    if (peek_end > header->read_seq) {
+        // 읽은 구간의 끝쪽 칸에 다시 써서 커서 바로 뒤에 원래 순서대로 남김
+        // (커서 앞으로 밀려난 칸은 이미 새 레코드가 쓰고 있으므로 그 몫은 덮어쓰기로 버려진 것)
+        uint64_t first = peek_end - (uint64_t)count;
+        int skip = 0;
+        if (first < header->read_seq) {
+            skip = (int)(header->read_seq - first);
+            first = header->read_seq;
+        }
+        for (int i = skip; i < count; i++) {
+            fill_record(first + (uint64_t)(i - skip), &unsent[i]);
+        }
+        if (count > skip) {
+            sync_records(first, peek_end);
+        }
+        header->read_seq = first;
+        corrupt += peek_corrupt;
+        sync_header();
+    }
+    peek_corrupt = 0;
+    pthread_mutex_unlock(&spool_mutex);
+}
+
+uint64_t spool_pending(void) {
+    if (!header) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    uint64_t pending = header->write_seq - header->read_seq;
+    pthread_mutex_unlock(&spool_mutex);
+    return pending;
+}
+
+void spool_get_stats(SpoolStats* stats) {
+    memset(stats, 0, sizeof(SpoolStats));
+    if (!header) {
+        return;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    stats->pending = header->write_seq - header->read_seq;
+    stats->capacity = header->capacity;
+    stats->overwritten = overwritten;
+    stats->corrupt = corrupt;
+    pthread_mutex_unlock(&spool_mutex);
+}
+
+void spool_cleanup(void) {
+    if (!map) {
+        return;
+    }
+
+    pthread_mutex_lock(&spool_mutex);
+    flush_locked();
+    pthread_mutex_unlock(&spool_mutex);
+    munmap(map, map_size);
+    map = NULL;
+    header = NULL;
+    records = NULL;
+}
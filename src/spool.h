@@ -0,0 +1,47 @@
+#ifndef SPOOL_H
+#define SPOOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "protocol.h"
+
+// 업링크 저장 후 전달(store-and-forward) 스풀
+//
+// 파일 = 헤더 + 고정 크기 레코드 칸. 레코드는 순번(seq)으로 계속 덧붙이며 칸은
+// seq % capacity로 순환함. 헤더의 read_seq가 서버로 보낸 위치(내구 커서)이고,
+// 레코드마다 CRC가 있어 전원이 나가 반쯤 기록된 칸은 복구 시 걸러냄.
+
+typedef struct {
+    uint64_t pending;           // 아직 보내지 않은 레코드 수
+    uint64_t capacity;
+    uint64_t overwritten;       // 스풀이 가득 차 버려진 레코드 수 (실행 중 누적)
+    uint64_t corrupt;           // CRC 불일치로 건너뛴 레코드 수 (실행 중 누적)
+} SpoolStats;
+
+bool spool_init(const SpoolConfig* config);
+
+// 보내지 못한 레코드를 덧붙이고 디스크에 동기화 (가득 차면 가장 오래된 것부터 덮어씀)
+void spool_append(const WireRecord* records, int count);
+
+// 측정 스레드용: 잠금을 기다리지 않고 매핑에만 기록 (잠겨 있으면 false)
+// 디스크 동기화는 업링크 스레드가 spool_sync로
+bool spool_try_append(const WireRecord* records, int count);
+void spool_sync(void);
+
+// 커서 위치부터 최대 max개를 읽음 (커서는 spool_commit까지 그대로)
+int spool_peek(WireRecord* out, int max);
+
+// 마지막 spool_peek으로 읽은 만큼 커서를 옮기고 디스크에 반영
+void spool_commit(void);
+
+// 일부만 보냈을 때: 읽은 레코드 중 보내지 못한 count개(원래 순서)만 커서 뒤에 남기고 나머지는 커밋
+// (보낸 레코드를 다음 재전송에서 다시 보내지 않도록)
+void spool_commit_unsent(const WireRecord* unsent, int count);
+
+uint64_t spool_pending(void);
+void spool_get_stats(SpoolStats* stats);
+
+void spool_cleanup(void);
+
+#endif
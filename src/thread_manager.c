@@ -1,8 +1,10 @@
 #include "thread_manager.h"
+#include "realtime.h"
 #include "logger.h"
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 
 #define MAX_THREADS 10
 
@@ -10,73 +12,320 @@ static ThreadInfo threads[MAX_THREADS];
 static int thread_count = 0;
 static bool should_stop = false;
 
+static WatchdogConfig watchdog_config = {
+    .stall_multiplier = DEFAULT_STALL_MULTIPLIER,
+    .min_stall_ms = DEFAULT_MIN_STALL_MS,
+    .recover = true,
+    .max_restarts = DEFAULT_MAX_RESTARTS
+};
+static void (*stage_recovery[STAGE_COUNT])(void);
+
+static __thread ThreadInfo* current_thread = NULL;
+static __thread unsigned int current_generation = 0;
+
+static const char* stage_names[STAGE_COUNT] = {
+    [STAGE_IDLE] = "idle",
+    [STAGE_RUNNING] = "running",
+    [STAGE_SLEEP] = "sleep",
+    [STAGE_ADC_READ] = "adc_read",
+    [STAGE_UPLINK_CONNECT] = "uplink_connect",
+    [STAGE_UPLINK_SEND] = "uplink_send",
+};
+
+static void timespec_add_ms(struct timespec* ts, int ms) {
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static long timespec_diff_us(const struct timespec* a, const struct timespec* b) {
+    return (a->tv_sec - b->tv_sec) * 1000000L + (a->tv_nsec - b->tv_nsec) / 1000L;
+}
+
+static void record_jitter(ThreadInfo* info, long late_us, bool overrun) {
+    pthread_mutex_lock(&info->jitter_mutex);
+
+    JitterStats* stats = &info->jitter;
+    if (overrun) {
+        stats->overruns++;
+    }
+    if (stats->samples == 0 || late_us < stats->min_us) {
+        stats->min_us = late_us;
+    }
+    if (late_us > stats->max_us) {
+        stats->max_us = late_us;
+    }
+    if (late_us > 1000) {
+        stats->over_1ms++;
+    }
+    stats->sum_us += late_us;
+    stats->samples++;
+
+    pthread_mutex_unlock(&info->jitter_mutex);
+}
+
+void thread_set_stage(ThreadStage stage) {
+    if (current_thread) {
+        atomic_store_explicit(&current_thread->stage, stage, memory_order_relaxed);
+    }
+}
+
+void thread_heartbeat(void) {
+    if (current_thread &&
+        atomic_load_explicit(&current_thread->generation, memory_order_relaxed) == current_generation) {
+        atomic_fetch_add_explicit(&current_thread->heartbeat, 1, memory_order_relaxed);
+    }
+}
+
+bool thread_abandoned(void) {
+    return current_thread &&
+           atomic_load_explicit(&current_thread->generation, memory_order_relaxed) != current_generation;
+}
+
 static void* thread_wrapper(void* arg) {
     ThreadInfo* info = (ThreadInfo*)arg;
-    
+    unsigned int generation = atomic_load(&info->generation);
+    struct timespec next, now;
+
+    current_thread = info;
+    current_generation = generation;
+    realtime_setup_thread(info->name, info->rt_priority, info->cpu);
+
+    // 절대 시각 기준으로 다음 주기를 계산해 작업 시간만큼 주기가 밀리지 않도록 함
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
     while (!should_stop) {
         if (!info->is_running) {
             break;
         }
-        
+        // 감시자가 이 스레드를 버리고 새로 시작했다면 종료
+        if (atomic_load_explicit(&info->generation, memory_order_relaxed) != generation) {
+            break;
+        }
+
+        thread_set_stage(STAGE_RUNNING);
         info->thread_func(info->arg);
-        
-        if (info->interval_ms > 0) {
-            usleep(info->interval_ms * 1000);
+        atomic_fetch_add_explicit(&info->heartbeat, 1, memory_order_relaxed);
+
+        if (info->interval_ms <= 0) {
+            continue;
+        }
+
+        timespec_add_ms(&next, info->interval_ms);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        long late_us = timespec_diff_us(&now, &next);
+        if (late_us > 0) {
+            // 작업이 주기를 넘김: 밀린 주기는 건너뛰고 현재 시각부터 다시 시작
+            record_jitter(info, late_us, true);
+            next = now;
+            continue;
+        }
+
+        thread_set_stage(STAGE_SLEEP);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0) {
+            if (should_stop) {
+                return NULL;
+            }
         }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        record_jitter(info, timespec_diff_us(&now, &next), false);
     }
-    
+
+    thread_set_stage(STAGE_IDLE);
     return NULL;
 }
 
+static bool spawn_thread(ThreadInfo* info) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+
+    size_t stack_size = realtime_thread_stack_size();
+    if (stack_size > 0 && pthread_attr_setstacksize(&attr, stack_size) != 0) {
+        log_error("Failed to set thread stack size to %zu", stack_size);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &info->last_progress);
+    info->last_heartbeat = atomic_load(&info->heartbeat);
+    info->stalled = false;
+
+    int err = pthread_create(&info->thread_id, &attr, thread_wrapper, info);
+    pthread_attr_destroy(&attr);
+    return err == 0;
+}
+
 bool start_monitoring_threads(void) {
     should_stop = false;
-    
+
     for (int i = 0; i < thread_count; i++) {
         threads[i].is_running = true;
-        
-        if (pthread_create(&threads[i].thread_id, NULL, thread_wrapper, &threads[i]) != 0) {
-            log_error("Failed to create thread %d", i);
+
+        if (!spawn_thread(&threads[i])) {
+            log_error("Failed to create thread %d (%s)", i, threads[i].name);
             return false;
         }
-        
-        log_info("Started monitoring thread %d", i);
+
+        log_info("Started monitoring thread %d (%s)", i, threads[i].name);
     }
-    
+
     return true;
 }
 
 void stop_monitoring_threads(void) {
     should_stop = true;
-    
+
     for (int i = 0; i < thread_count; i++) {
         threads[i].is_running = false;
         pthread_join(threads[i].thread_id, NULL);
-        log_info("Stopped monitoring thread %d", i);
+        log_info("Stopped monitoring thread %d (%s)", i, threads[i].name);
+    }
+}
+
+void configure_watchdog(const WatchdogConfig* config) {
+    memcpy(&watchdog_config, config, sizeof(WatchdogConfig));
+}
+
+void set_stage_recovery(ThreadStage stage, void (*recover)(void)) {
+    if (stage >= 0 && stage < STAGE_COUNT) {
+        stage_recovery[stage] = recover;
+    }
+}
+
+static long stall_limit_ms(const ThreadInfo* info) {
+    long limit = (long)info->interval_ms * watchdog_config.stall_multiplier;
+    return limit > watchdog_config.min_stall_ms ? limit : watchdog_config.min_stall_ms;
+}
+
+// 정지된 스레드는 강제 종료하지 않고(뮤텍스를 쥔 채 취소될 수 있으므로) 버린 뒤 새 스레드로 교체
+// 버린 스레드가 돌아오면 그 주기를 마저 돌므로 장치 접근과 게시는 thread_abandoned로 막음
+static bool restart_thread(ThreadInfo* info) {
+    pthread_detach(info->thread_id);
+    atomic_fetch_add(&info->generation, 1);
+    info->restarts++;
+
+    if (!spawn_thread(info)) {
+        log_error("Thread %s: restart failed", info->name);
+        return false;
     }
+    log_info("Thread %s: restarted (%d/%d)", info->name, info->restarts, watchdog_config.max_restarts);
+    return true;
 }
 
 bool check_thread_health(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
     for (int i = 0; i < thread_count; i++) {
-        if (!threads[i].is_running) {
+        ThreadInfo* info = &threads[i];
+
+        if (!info->is_running) {
             log_error("Thread %d is not running", i);
             return false;
         }
+
+        unsigned long heartbeat = atomic_load_explicit(&info->heartbeat, memory_order_relaxed);
+        if (heartbeat != info->last_heartbeat) {
+            if (info->stalled) {
+                log_info("Thread %s: progress resumed", info->name);
+            }
+            info->last_heartbeat = heartbeat;
+            info->last_progress = now;
+            info->stalled = false;
+            info->restarts = 0;
+            continue;
+        }
+
+        long stalled_ms = timespec_diff_us(&now, &info->last_progress) / 1000;
+        long limit_ms = stall_limit_ms(info);
+        if (stalled_ms < limit_ms) {
+            continue;
+        }
+
+        ThreadStage stage = atomic_load_explicit(&info->stage, memory_order_relaxed);
+
+        // 1단계: 정지 기록 및 단계별 복구 동작
+        if (!info->stalled) {
+            info->stalled = true;
+            log_error("Thread %s: no heartbeat for %ld ms (limit %ld ms), blocked in stage '%s'",
+                      info->name, stalled_ms, limit_ms, stage_names[stage]);
+            if (watchdog_config.recover && stage_recovery[stage]) {
+                log_info("Thread %s: running recovery for stage '%s'", info->name, stage_names[stage]);
+                stage_recovery[stage]();
+            }
+            continue;
+        }
+
+        // 2단계: 복구 후에도 진행이 없으면 스레드 교체
+        // 이벤트 루프 스레드(주기 0)는 교체하지 않음: 버린 스레드가 대기에서 돌아오면 새 스레드와 함수의
+        // 정적 상태를 함께 쓰게 됨 (대기마다 thread_heartbeat를 부르므로 여기서는 1단계 복구만)
+        if (stalled_ms < 2 * limit_ms || info->interval_ms <= 0) {
+            continue;
+        }
+        if (info->restarts >= watchdog_config.max_restarts) {
+            log_error("Thread %s: still stalled after %d restarts", info->name, info->restarts);
+            return false;
+        }
+        if (!restart_thread(info)) {
+            return false;
+        }
     }
     return true;
 }
 
-bool add_monitoring_thread(void* (*thread_func)(void*), void* arg, int interval_ms) {
+void report_thread_jitter(void) {
+    for (int i = 0; i < thread_count; i++) {
+        JitterStats stats;
+
+        pthread_mutex_lock(&threads[i].jitter_mutex);
+        stats = threads[i].jitter;
+        pthread_mutex_unlock(&threads[i].jitter_mutex);
+
+        if (stats.samples == 0) {
+            continue;
+        }
+
+        log_info("Jitter [%s] (%s): n=%ld min=%ldus avg=%lldus max=%ldus >1ms=%ld overruns=%ld",
+                 threads[i].name, realtime_describe(), stats.samples, stats.min_us,
+                 stats.sum_us / stats.samples, stats.max_us, stats.over_1ms, stats.overruns);
+    }
+}
+
+bool add_monitoring_thread(const char* name, void* (*thread_func)(void*), void* arg, int interval_ms) {
     if (thread_count >= MAX_THREADS) {
         log_error("Maximum number of threads reached");
         return false;
     }
-    
+
     ThreadInfo* info = &threads[thread_count];
+    memset(info, 0, sizeof(ThreadInfo));
+    info->name = name;
     info->thread_func = thread_func;
     info->arg = arg;
     info->interval_ms = interval_ms;
     info->is_running = false;
-    
+    info->rt_priority = 0;
+    info->cpu = -1;
+    pthread_mutex_init(&info->jitter_mutex, NULL);
+    atomic_init(&info->heartbeat, 0);
+    atomic_init(&info->stage, STAGE_IDLE);
+    atomic_init(&info->generation, 0);
+
     thread_count++;
     return true;
-} 
\ No newline at end of file
+}
+
+bool set_thread_realtime(const char* name, int rt_priority, int cpu) {
+    for (int i = 0; i < thread_count; i++) {
+        if (strcmp(threads[i].name, name) == 0) {
+            threads[i].rt_priority = rt_priority;
+            threads[i].cpu = cpu;
+            return true;
+        }
+    }
+    log_error("Unknown thread: %s", name);
+    return false;
+}
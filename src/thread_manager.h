@@ -3,6 +3,30 @@
 
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "config.h"
+
+// 스레드가 현재 어느 단계에서 작업 중인지 나타내는 태그 (정지 시 원인 파악용)
+typedef enum {
+    STAGE_IDLE = 0,
+    STAGE_RUNNING,
+    STAGE_SLEEP,
+    STAGE_ADC_READ,
+    STAGE_UPLINK_CONNECT,
+    STAGE_UPLINK_SEND,
+    STAGE_COUNT
+} ThreadStage;
+
+// 주기 실행 지연(지터) 통계
+typedef struct {
+    long samples;
+    long min_us;
+    long max_us;
+    long long sum_us;
+    long over_1ms;      // 1ms 이상 늦게 깨어난 횟수
+    long overruns;      // 작업이 주기를 넘겨 다음 주기를 놓친 횟수
+} JitterStats;
 
 typedef struct {
     pthread_t thread_id;
@@ -10,16 +34,54 @@ typedef struct {
     void* (*thread_func)(void*);
     void* arg;
     int interval_ms;
+    const char* name;
+    int rt_priority;    // 0이면 기본 스케줄러
+    int cpu;            // -1이면 CPU 고정 안 함
+    JitterStats jitter;
+    pthread_mutex_t jitter_mutex;
+
+    // 하트비트: 작업 스레드가 relaxed atomic으로 기록, 감시자가 읽기만 함
+    atomic_ulong heartbeat;
+    atomic_int stage;
+    atomic_uint generation;     // 재시작 시 증가, 이전 스레드는 이를 보고 종료
+
+    // 감시자(check_thread_health) 전용 상태
+    unsigned long last_heartbeat;
+    struct timespec last_progress;
+    bool stalled;
+    int restarts;
 } ThreadInfo;
 
 // 스레드 생성 및 관리
 bool start_monitoring_threads(void);
 void stop_monitoring_threads(void);
 
-// 스레드 상태 모니터링
+// 스레드 상태 모니터링 (하트비트 정지 감지 및 복구, 복구 불가 시 false)
 bool check_thread_health(void);
+void configure_watchdog(const WatchdogConfig* config);
+
+// 특정 단계에서 정지가 감지됐을 때 실행할 복구 동작 등록 (예: ADC 재초기화, 소켓 리셋)
+void set_stage_recovery(ThreadStage stage, void (*recover)(void));
+
+// 작업 스레드에서 호출: 현재 단계 기록 (관리 스레드가 아니면 무시됨)
+void thread_set_stage(ThreadStage stage);
+
+// 작업 스레드에서 호출: 한 번의 호출 안에서 제한 시간이 있는 대기를 여러 번 거치는 스레드가 대기마다 진행을 알림
+// (정지 판단은 대기 하나 기준, 교체된 이전 스레드나 관리 스레드가 아니면 무시됨)
+void thread_heartbeat(void);
+
+// 작업 스레드에서 호출: 워치독이 이 스레드를 버리고 새 스레드로 교체했으면 true
+// 막혀 있던 호출에서 늦게 돌아온 이전 스레드가 새 스레드와 함께 장치를 쓰거나 게시하지 않도록 확인
+bool thread_abandoned(void);
 
 // 스레드 추가 함수 선언 추가
-bool add_monitoring_thread(void* (*thread_func)(void*), void* arg, int interval_ms);
+// thread_func는 한 주기의 작업만 수행하고 반환하며, 주기 타이밍은 스레드 관리자가 담당
+bool add_monitoring_thread(const char* name, void* (*thread_func)(void*), void* arg, int interval_ms);
+
+// 스레드 시작 전에 SCHED_FIFO 우선순위와 CPU 고정 설정
+bool set_thread_realtime(const char* name, int rt_priority, int cpu);
+
+// 스레드별 지터 통계를 로그로 출력
+void report_thread_jitter(void);
 
-#endif 
\ No newline at end of file
+#endif
@@ -2,14 +2,43 @@
 #define TYPES_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
-// 네트워크 설정 구조체
+// 업링크 서버 목록 상한
+#define NETWORK_MAX_ENDPOINTS 8
+
 typedef struct {
-    char* host;
+    char host[64];          // IPv4 주소 또는 호스트 이름
     int port;
+} NetworkEndpoint;
+
+// 서버 분산 기준
+typedef enum {
+    NETWORK_SHARD_CHANNEL = 0,  // 노드+채널마다 담당 서버 (센서 단위 분산)
+    NETWORK_SHARD_NODE          // 노드의 모든 채널을 한 서버로
+} NetworkShardKey;
+
+// 네트워크 설정 구조체
+typedef struct {
+    NetworkEndpoint endpoints[NETWORK_MAX_ENDPOINTS];
+    int endpoint_count;
+    NetworkShardKey shard_by;
     int timeout_seconds;
     int max_retries;
+    bool binary_protocol;   // 연결 시 바이너리 프로토콜 협상 (실패하면 JSON)
+    bool compress;          // 협상 시 시계열 압축 인코딩도 제안
+    uint32_t node_id;       // HELLO에 실어 보내는 노드 식별자
+    int reconnect_min_ms;   // 첫 재연결 대기 (연속 실패마다 두 배, 절반은 무작위로 흩뜨림)
+    int reconnect_max_ms;   // 재연결 대기 상한
+    int keepalive_idle_s;   // 유휴 연결에 keepalive 탐침을 보내기 시작할 때까지 (0이면 사용 안 함)
+    int keepalive_interval_s;
+    int keepalive_count;    // 응답 없는 탐침이 이만큼이면 커널이 연결을 끊음
+    int user_timeout_ms;    // 보낸 데이터가 이 시간 안에 확인되지 않으면 연결을 끊음 (TCP_USER_TIMEOUT, 0이면 커널 기본값)
+    char interface[16];     // 업링크가 나가는 인터페이스 (연결 실패가 계속될 때 재설정할 링크)
+    int route_wait_ms;      // 시작 시 서버로 가는 경로가 생길 때까지 기다리는 상한 (0이면 기다리지 않음)
+    int link_reset_failures;  // 모든 서버에 연속으로 이만큼 연결하지 못하면 인터페이스 재설정 (0이면 안 함)
+    int clock_sync_interval_s;  // 서버와의 시계 오프셋 측정 주기 (0이면 협상하지 않음, 연결 직후에는 항상 측정)
 } NetworkConfig;
 
 // 보정 포인트 구조체
@@ -46,4 +75,33 @@ typedef struct {
     float voltage;
 } PhData;
 
+// 센서 종류 (채널 메타데이터, 업링크 테이블 선택에 사용)
+typedef enum {
+    SENSOR_KIND_WATER_LEVEL = 0,
+    SENSOR_KIND_PH,
+    SENSOR_KIND_TEMPERATURE,
+    SENSOR_KIND_CONDUCTIVITY,
+    SENSOR_KIND_ILLUMINANCE,
+    SENSOR_KIND_COUNT
+} SensorKind;
+
+// 측정값 품질 플래그
+#define READING_QUALITY_VALID           (1u << 0)  // 정상 측정값
+#define READING_QUALITY_LOW_SAMPLES     (1u << 1)  // 유효 샘플 부족
+#define READING_QUALITY_OUT_OF_RANGE    (1u << 2)  // 센서 범위를 벗어남
+#define READING_QUALITY_DEADBAND        (1u << 3)  // 예외 보고 행: 다음 행까지 이 값이 유지됨
+#define READING_QUALITY_HEARTBEAT       (1u << 4)  // 값 변화 없이 하트비트 주기로 보낸 행
+#define READING_QUALITY_ALARM_LOW       (1u << 5)  // 하한 경보 상태
+#define READING_QUALITY_ALARM_HIGH      (1u << 6)  // 상한 경보 상태
+#define READING_QUALITY_ALARM_CHANGE    (1u << 7)  // 경보 상태가 바뀐 측정값 (우선 차선으로 전송)
+
+// 채널 공통 측정값 (최신값 테이블 등에서 사용)
+typedef struct {
+    int channel;
+    float value;
+    float voltage;
+    int64_t timestamp_us;   // 측정 시각 (epoch 기준 µs)
+    uint32_t quality;
+} Reading;
+
 #endif 
\ No newline at end of file
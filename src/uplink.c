@@ -0,0 +1,1612 @@
+#include "uplink.h"
+#include "readings.h"
+#include "deadband.h"
+#include "aggregate.h"
+#include "alarm.h"
+#include "network.h"
+#include "protocol.h"
+#include "batch_json.h"
+#include "spool.h"
+#include "shm_export.h"
+#include "logger.h"
+#include <stdatomic.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// 업링크 스레드가 최소 이 주기로 깨어나 하트비트를 남김
+#define UPLINK_IDLE_WAIT_MS 100
+
+// 종료 시 보낸 프레임의 확인 응답을 기다리는 최대 시간
+#define UPLINK_FLUSH_ACK_WAIT_MS 2000
+
+// 적응형 배압: 주기마다 부하를 보고 단계를 하나씩 올리거나 내림
+// 단계마다 배치와 linger는 두 배, 비핵심 채널은 단계 2부터 1/2, 1/4, ...만 업링크
+#define BACKPRESSURE_MAX_LEVEL 4
+#define BACKPRESSURE_INTERVAL_MS 1000
+
+// 차선: 경보 차선은 bulk 차선의 배치, 스풀 재전송, 요약보다 항상 먼저 보냄 (엄격한 우선순위)
+// 같은 연결로 보내며 프레임 단위로 끼어들므로 경보는 이미 보내는 중인 프레임 하나만 기다림
+typedef enum {
+    LANE_ALARM = 0,                 // 경보 상태가 바뀐 측정값
+    LANE_BULK,                      // 나머지 측정값 (배압, overflow 정책, 스풀 적용)
+    LANE_COUNT
+} UplinkLane;
+
+// 측정 스레드 → 업링크 스레드 큐 칸 (seq로 칸 상태 표시, 수집 링과 같은 방식)
+// 가득 찼을 때 drop_oldest 정책이면 생산자도 꺼내므로 양쪽 모두 CAS로 위치 확보
+typedef struct {
+    _Atomic uint64_t seq;
+    Reading reading;
+} QueueCell;
+
+// 차선마다 하나씩 있는 큐
+typedef struct {
+    QueueCell* cells;
+    uint64_t mask;
+    _Atomic uint64_t enqueue_pos __attribute__((aligned(64)));
+    _Atomic uint64_t dequeue_pos __attribute__((aligned(64)));
+} ReadingQueue;
+
+// 차선별 지표 (enqueued/dropped는 생산자, 나머지는 업링크 스레드가 갱신하고 통계 로그가 읽음)
+typedef struct {
+    _Atomic uint64_t enqueued;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t sent;
+    _Atomic int64_t max_latency_us; // 측정 시각부터 전송 완료까지, 통계 로그 사이의 최댓값
+} LaneStats;
+
+// coalesce 정책: 큐가 가득 찬 동안 채널별 최신값 하나 (seqlock, 채널당 생산자 하나)
+typedef struct {
+    _Atomic uint32_t seq;
+    _Atomic uint32_t taken;         // 업링크 스레드가 마지막으로 가져간 seq
+    Reading reading;
+} __attribute__((aligned(64))) CoalesceSlot;
+
+static UplinkConfig uplink_config = {
+    .max_batch_records = DEFAULT_UPLINK_BATCH_RECORDS,
+    .linger_ms = DEFAULT_UPLINK_LINGER_MS,
+    .queue_size = DEFAULT_UPLINK_QUEUE_SIZE,
+    .overflow_policy = UPLINK_OVERFLOW_DROP_OLDEST
+};
+
+static ReadingQueue queues[LANE_COUNT];
+static LaneStats lane_stats[LANE_COUNT];
+static _Atomic uint32_t wake_word __attribute__((aligned(64)));    // 업링크 스레드를 깨우는 futex 워드
+static CoalesceSlot coalesce_slots[NUM_CHANNELS];
+
+static _Atomic uint64_t spilled_count;
+static _Atomic uint64_t coalesced_count;
+static _Atomic uint64_t decimated_count;
+
+// 배압 단계에 따라 업링크 스레드가 바꾸는 값 (batch_target과 분주비는 생산자도 읽음)
+static _Atomic int batch_target;
+static int linger_target;
+static int pressure_level = 0;
+static long slowest_send_ms = 0;            // 지난 판단 이후 가장 오래 걸린 배치 전송
+static struct timespec last_adjust;
+static _Atomic uint32_t channel_divisor[NUM_CHANNELS];  // 1이면 모두 업링크
+static uint32_t decimate_counter[NUM_CHANNELS];         // 채널별 생산자 전용
+
+// 구간 집계만 켜고 raw를 끄면 개별 측정값은 큐에 넣지 않음
+static bool raw_uplink = true;
+
+// 스풀 재전송 속도 제한 (토큰 버킷, 최대 한 프레임 분량까지 모임)
+static bool spool_enabled = false;
+static int drain_rate = DEFAULT_SPOOL_DRAIN_RATE;
+static double drain_tokens = UPLINK_MAX_BATCH;
+static struct timespec last_drain;
+
+static int to_wire_records(const Reading* readings, int count, WireRecord* records);
+
+// 확인 대기 창: 확인 응답을 협상한 서버로 보낸 프레임은 서버가 커밋을 확인할 때까지 레코드를 보관하고,
+// 확인 전에 연결이 끊기면 다시 보냄 (서버가 노드별 seq high-water mark로 중복을 거르므로 한 번만 저장)
+// 창이 차면 새 프레임은 보내지 않고 기존 실패 경로(스풀, 경보 재시도, 요약 대기열)로 넘김
+typedef struct {
+    bool used;
+    bool summary;                   // records 대신 summaries
+    int endpoint;
+    uint32_t generation;            // 보낸 연결 (network_generation)
+    uint64_t seq;
+    uint64_t order;                 // 보낸 순서 (재전송도 이 순서로)
+    int count;
+    union {
+        WireRecord records[UPLINK_MAX_BATCH];
+        SummaryRecord summaries[UPLINK_MAX_BATCH];
+    };
+} UnackedFrame;
+
+static UnackedFrame* unacked;
+static int unacked_capacity = 0;
+static int unacked_slots = 0;       // 창 크기 + 재전송 중 결과를 기다리며 잡아 두는 자리 하나
+static int unacked_count = 0;
+static uint64_t unacked_order = 0;
+static _Atomic uint64_t retransmitted_frames;
+static _Atomic uint64_t window_stalls;  // 창이 차서 보내지 못한 횟수
+
+static void release_acked(void);
+
+// 중계: 하위 노드에서 받은 레코드 (중계 스레드가 넣고 업링크 스레드가 자기 배치의 남는 자리에 채움)
+// 레코드가 이미 와이어 형식이고 넣는 쪽이 한 스레드뿐이라 큐 대신 잠금을 쓰는 링으로 충분
+static WireRecord* relay_ring = NULL;
+static int relay_capacity = 0;
+static int relay_head = 0;
+static int relay_count = 0;
+static pthread_mutex_t relay_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic uint64_t relay_received;
+static _Atomic uint64_t relay_spilled;
+static _Atomic uint64_t relay_dropped;     // 중계를 받지 않는 서버로 가야 해서 버린 레코드와 요약
+
+// 요청 크기를 2의 거듭제곱으로 올려 큐 할당
+static bool queue_init(ReadingQueue* q, int requested) {
+    uint64_t size = 2;
+    while (size < (uint64_t)requested && size < UPLINK_MAX_QUEUE) {
+        size <<= 1;
+    }
+    q->cells = calloc(size, sizeof(QueueCell));
+    if (!q->cells) {
+        log_error("Failed to allocate uplink queue (%llu records)", (unsigned long long)size);
+        return false;
+    }
+    for (uint64_t i = 0; i < size; i++) {
+        atomic_init(&q->cells[i].seq, i);
+    }
+    q->mask = size - 1;
+    atomic_store(&q->enqueue_pos, 0);
+    atomic_store(&q->dequeue_pos, 0);
+    return true;
+}
+
+bool uplink_init(const UplinkConfig* config, const SpoolConfig* spool_config) {
+    memcpy(&uplink_config, config, sizeof(UplinkConfig));
+    if (uplink_config.max_batch_records <= 0 || uplink_config.max_batch_records > UPLINK_MAX_BATCH) {
+        uplink_config.max_batch_records = UPLINK_MAX_BATCH;
+    }
+    if (uplink_config.backpressure.max_divisor < 1) {
+        uplink_config.backpressure.max_divisor = 1;
+    }
+    atomic_store(&batch_target, uplink_config.max_batch_records);
+    linger_target = uplink_config.linger_ms;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        atomic_store(&channel_divisor[ch], 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &last_adjust);
+    deadband_init(&uplink_config.deadband);
+    aggregate_init(&uplink_config.aggregate);
+    raw_uplink = !uplink_config.aggregate.enabled || uplink_config.aggregate.raw;
+
+    if (!queue_init(&queues[LANE_BULK], uplink_config.queue_size)) {
+        return false;
+    }
+    if (uplink_config.priority.enabled) {
+        if (uplink_config.priority.max_batch_records <= 0 ||
+            uplink_config.priority.max_batch_records > UPLINK_MAX_BATCH) {
+            uplink_config.priority.max_batch_records = UPLINK_MAX_BATCH;
+        }
+        if (!queue_init(&queues[LANE_ALARM], uplink_config.priority.queue_size)) {
+            return false;
+        }
+        alarm_init(&uplink_config.priority);
+    }
+
+    if (uplink_config.ack_window > 0) {
+        unacked = calloc(uplink_config.ack_window + 1, sizeof(UnackedFrame));
+        if (!unacked) {
+            log_error("Failed to allocate uplink ack window (%d frames)", uplink_config.ack_window);
+            return false;
+        }
+        unacked_capacity = uplink_config.ack_window;
+        unacked_slots = unacked_capacity + 1;
+    }
+
+    // 스풀을 못 열어도 업링크는 동작 (장애 중 측정값만 잃음)
+    spool_enabled = spool_config->enabled && spool_init(spool_config);
+    drain_rate = spool_config->drain_rate > 0 ? spool_config->drain_rate : DEFAULT_SPOOL_DRAIN_RATE;
+    clock_gettime(CLOCK_MONOTONIC, &last_drain);
+
+    log_info("Uplink queue: %llu records, overflow policy %s", (unsigned long long)(queues[LANE_BULK].mask + 1),
+             uplink_config.overflow_policy == UPLINK_OVERFLOW_SPILL ? "spill" :
+             uplink_config.overflow_policy == UPLINK_OVERFLOW_COALESCE ? "coalesce" : "drop_oldest");
+    return true;
+}
+
+static uint64_t queue_depth(ReadingQueue* q) {
+    if (!q->cells) {
+        return 0;
+    }
+    uint64_t head = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+}
+
+// 빈 칸이 없으면 false (기다리지 않음)
+static bool queue_push(ReadingQueue* q, const Reading* reading, uint64_t* out_pos) {
+    uint64_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    QueueCell* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    cell->reading = *reading;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    *out_pos = pos;
+    return true;
+}
+
+// 기록이 끝난 칸이 없으면 false
+static bool queue_pop(ReadingQueue* q, Reading* out) {
+    uint64_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    QueueCell* cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - (pos + 1));
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    *out = cell->reading;
+    // 칸을 다음 바퀴의 생산자에게 돌려줌
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return true;
+}
+
+static void wake_uplink(void) {
+    atomic_fetch_add_explicit(&wake_word, 1, memory_order_release);
+    syscall(SYS_futex, &wake_word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static void coalesce_store(const Reading* reading) {
+    CoalesceSlot* slot = &coalesce_slots[reading->channel];
+    uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+
+    // 아직 보내지 않은 값을 덮음
+    if (seq != 0 && atomic_load_explicit(&slot->taken, memory_order_relaxed) != seq) {
+        atomic_fetch_add_explicit(&coalesced_count, 1, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->reading = *reading;
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+// 보내지 않은 덮어쓰기 값을 가져감 (업링크 스레드만 호출)
+static bool coalesce_take(int channel, Reading* out) {
+    CoalesceSlot* slot = &coalesce_slots[channel];
+    uint32_t seq_before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+    if ((seq_before & 1) || seq_before == atomic_load_explicit(&slot->taken, memory_order_relaxed)) {
+        return false;   // 작성 중이면 다음 주기에
+    }
+    *out = slot->reading;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq_before) {
+        return false;
+    }
+
+    atomic_store_explicit(&slot->taken, seq_before, memory_order_relaxed);
+    return true;
+}
+
+// 큐가 가득 찼을 때 정책에 따라 처리 (측정 스레드를 멈추지 않음)
+static bool handle_overflow(const Reading* reading) {
+    uint64_t pos;
+
+    if (uplink_config.overflow_policy == UPLINK_OVERFLOW_COALESCE &&
+        reading->channel >= 0 && reading->channel < NUM_CHANNELS) {
+        coalesce_store(reading);
+        return true;
+    }
+
+    if (uplink_config.overflow_policy == UPLINK_OVERFLOW_SPILL && spool_enabled) {
+        WireRecord record;
+        if (to_wire_records(reading, 1, &record) == 1 && spool_try_append(&record, 1)) {
+            atomic_fetch_add_explicit(&spilled_count, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // 가장 오래된 측정값을 버리고 자리를 만듦
+    Reading oldest;
+    atomic_fetch_add_explicit(&lane_stats[LANE_BULK].dropped, 1, memory_order_relaxed);
+    if (queue_pop(&queues[LANE_BULK], &oldest) && queue_push(&queues[LANE_BULK], reading, &pos)) {
+        atomic_fetch_add_explicit(&lane_stats[LANE_BULK].enqueued, 1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// 배압으로 채널 비율이 낮아졌으면 분주비만큼 건너뜀
+// 이상 품질 값과 deadband 행(이미 변화가 있을 때만 오고, 빠지면 계단형 복원이 틀어짐)은 항상 보냄
+static bool decimated(const Reading* reading) {
+    if (reading->channel < 0 || reading->channel >= NUM_CHANNELS ||
+        reading->quality != READING_QUALITY_VALID) {
+        return false;
+    }
+    uint32_t divisor = atomic_load_explicit(&channel_divisor[reading->channel], memory_order_relaxed);
+    if (divisor <= 1) {
+        return false;
+    }
+    return decimate_counter[reading->channel]++ % divisor != 0;
+}
+
+// 경보 차선에 넣고 바로 깨움 (가득 차면 가장 오래된 경보를 버림)
+static bool submit_alarm(const Reading* reading) {
+    ReadingQueue* q = &queues[LANE_ALARM];
+    LaneStats* stats = &lane_stats[LANE_ALARM];
+    uint64_t pos;
+    Reading oldest;
+
+    bool queued = queue_push(q, reading, &pos);
+    if (!queued) {
+        atomic_fetch_add_explicit(&stats->dropped, 1, memory_order_relaxed);
+        queued = queue_pop(q, &oldest) && queue_push(q, reading, &pos);
+    }
+    if (queued) {
+        atomic_fetch_add_explicit(&stats->enqueued, 1, memory_order_relaxed);
+    }
+    wake_uplink();
+    return queued;
+}
+
+bool uplink_submit(const Reading* reading) {
+    uint64_t pos;
+    Reading classified, filtered;
+
+    // 경보 상태가 바뀐 값은 집계에만 반영하고 deadband/분주와 무관하게 경보 차선으로
+    bool alarm = uplink_config.priority.enabled && alarm_classify(reading, &classified);
+    if (uplink_config.priority.enabled) {
+        reading = &classified;
+    }
+
+    // 집계는 deadband 앞에서 모든 측정값을 봄 (걸러진 값도 min/max에 반영)
+    aggregate_add(reading);
+    if (alarm) {
+        return submit_alarm(reading);
+    }
+    if (!raw_uplink) {
+        return true;
+    }
+
+    if (!deadband_filter(reading, &filtered)) {
+        return true;
+    }
+    reading = &filtered;
+
+    if (decimated(reading)) {
+        atomic_fetch_add_explicit(&decimated_count, 1, memory_order_relaxed);
+        return true;
+    }
+
+    if (!queue_push(&queues[LANE_BULK], reading, &pos)) {
+        return handle_overflow(reading);
+    }
+    atomic_fetch_add_explicit(&lane_stats[LANE_BULK].enqueued, 1, memory_order_relaxed);
+
+    // 빈 큐에 첫 값이 들어왔거나(linger 시작) 배치가 찼을 때만 깨움
+    uint64_t depth = pos + 1 - atomic_load_explicit(&queues[LANE_BULK].dequeue_pos, memory_order_relaxed);
+    if (depth == 1 || depth == (uint64_t)atomic_load_explicit(&batch_target, memory_order_relaxed)) {
+        wake_uplink();
+    }
+    return true;
+}
+
+// 측정값에 채널 메타데이터(종류, 센서 번호)를 붙여 와이어 레코드로 변환
+static int to_wire_records(const Reading* readings, int count, WireRecord* records) {
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        SensorKind kind;
+        int sensor_id;
+        if (!readings_channel_info(readings[i].channel, &kind, &sensor_id)) {
+            continue;
+        }
+
+        records[n].channel = readings[i].channel;
+        records[n].kind = kind;
+        records[n].sensor_id = sensor_id;
+        records[n].quality = readings[i].quality;
+        records[n].timestamp_us = readings[i].timestamp_us;
+        records[n].value = readings[i].value;
+        records[n].voltage = readings[i].voltage;
+        records[n].node_id = 0;
+        n++;
+    }
+    return n;
+}
+
+// 확인 대기 창에 자리가 없으면 true (와 있는 확인 응답을 먼저 반영)
+static bool window_full(int endpoint) {
+    if (unacked_capacity == 0 || !network_acks_enabled(endpoint)) {
+        return false;
+    }
+    if (unacked_count < unacked_capacity) {
+        return false;
+    }
+    network_check_peers();
+    release_acked();
+    if (unacked_count < unacked_capacity) {
+        return false;
+    }
+    atomic_fetch_add_explicit(&window_stalls, 1, memory_order_relaxed);
+    return true;
+}
+
+// 확인 응답을 쓰는 연결로 보낸 프레임의 레코드를 확인될 때까지 보관
+static void window_store(int endpoint, uint64_t seq, bool summary, const void* items, int count) {
+    if (seq == 0 || unacked_capacity == 0) {
+        return;
+    }
+    for (int i = 0; i < unacked_slots; i++) {
+        UnackedFrame* frame = &unacked[i];
+        if (frame->used) {
+            continue;
+        }
+        frame->used = true;
+        frame->summary = summary;
+        frame->endpoint = endpoint;
+        frame->generation = network_generation(endpoint);
+        frame->seq = seq;
+        frame->order = ++unacked_order;
+        frame->count = count;
+        memcpy(summary ? (void*)frame->summaries : (void*)frame->records, items,
+               (summary ? sizeof(SummaryRecord) : sizeof(WireRecord)) * count);
+        unacked_count++;
+        return;
+    }
+}
+
+// 배치를 JSON 문서 하나로 (공통 기준 시각 base_ts + 측정값별 오프셋 dt, µs)
+// 프레임 JSON이면 프레임 하나로, 구버전 서버에는 헤더 없이 끝에 개행을 붙임
+static int send_json(int endpoint, const WireRecord* records, int count, WireEncoding encoding) {
+    static char json[BATCH_JSON_MAX_OVERHEAD + UPLINK_MAX_BATCH * BATCH_JSON_MAX_RECORD + 1];
+
+    if (window_full(endpoint)) {
+        return 0;
+    }
+    size_t len = batch_json_encode(json, sizeof(json) - 1, records, count);
+    if (len == 0) {
+        return 0;
+    }
+
+    if (encoding == WIRE_JSON_FRAMED) {
+        uint64_t seq;
+        if (!network_send_data(endpoint, FRAME_BATCH_JSON, json, len, &seq)) {
+            return 0;
+        }
+        window_store(endpoint, seq, false, records, count);
+        return count;
+    }
+
+    json[len] = '\n';
+    struct iovec iov = { .iov_base = json, .iov_len = len + 1 };
+    return network_send_frame(endpoint, &iov, 1) ? count : 0;
+}
+
+// 기준 시각에서 dt 범위를 벗어나는 레코드가 있으면 프레임을 나눠 보냄
+static int send_binary(int endpoint, const WireRecord* records, int count) {
+    static uint8_t payload[PROTOCOL_BATCH_HEADER_SIZE + UPLINK_MAX_BATCH * PROTOCOL_RECORD_SIZE];
+    int sent = 0;
+
+    while (sent < count && !window_full(endpoint)) {
+        int consumed;
+        uint64_t seq;
+        size_t len = protocol_encode_batch(payload, sizeof(payload), records + sent, count - sent, &consumed);
+        if (!network_send_data(endpoint, FRAME_BATCH, payload, len, &seq)) {
+            break;
+        }
+        window_store(endpoint, seq, false, records + sent, consumed);
+        sent += consumed;
+    }
+    return sent;
+}
+
+// 채널별 이전 값과의 차이만 싣고, 버퍼가 차거나 dt 범위를 벗어나면 프레임을 나눔
+static int send_compressed(int endpoint, const WireRecord* records, int count) {
+    static uint8_t payload[PROTOCOL_BATCH_HEADER_SIZE + UPLINK_MAX_BATCH * PROTOCOL_COMPRESS_MAX_RECORD_BITS / 8];
+    CompressEncoder encoder;
+    int sent = 0;
+
+    while (sent < count && !window_full(endpoint)) {
+        protocol_compress_begin(&encoder, payload, sizeof(payload), records[sent].timestamp_us);
+        int consumed = 0;
+        while (sent + consumed < count && protocol_compress_add(&encoder, &records[sent + consumed])) {
+            consumed++;
+        }
+        if (consumed == 0) {
+            log_error("Record for channel %d cannot be compressed, dropping", records[sent].channel);
+            consumed = 1;
+        } else {
+            uint64_t seq;
+            size_t len = protocol_compress_finish(&encoder);
+            if (!network_send_data(endpoint, FRAME_BATCH_COMPRESSED, payload, len, &seq)) {
+                break;
+            }
+            window_store(endpoint, seq, false, records + sent, consumed);
+        }
+        sent += consumed;
+    }
+    return sent;
+}
+
+// 다시 연결된 서버 기준으로 끊긴 프레임 정리: HELLO 직후 받은 high-water mark 이하는 커밋된 것이므로 빼고,
+// 나머지는 seq를 지워 다시 보낼 때까지 남김 (새 연결의 누적 확인은 그 뒤에 보낸 프레임에 대한 것)
+static void settle_window(int endpoint) {
+    uint32_t generation = network_generation(endpoint);
+    uint64_t committed = network_acked_seq(endpoint);
+
+    for (int i = 0; i < unacked_slots && unacked_count > 0; i++) {
+        UnackedFrame* frame = &unacked[i];
+        if (!frame->used || frame->endpoint != endpoint || frame->generation == generation || frame->seq == 0) {
+            continue;
+        }
+        if (frame->seq <= committed) {
+            frame->used = false;
+            unacked_count--;
+        } else {
+            frame->seq = 0;
+        }
+    }
+}
+
+// 연결을 확보하고 확인 대기 창 정리 (network_send_data는 다시 연결하지 않으므로 정리 전에 새 연결로 나간 프레임은 없음)
+static bool connect_to(int endpoint) {
+    if (!network_ensure_connection(endpoint)) {
+        return false;
+    }
+    settle_window(endpoint);
+    return true;
+}
+
+// 한 노드의 레코드를 중계 구간 하나로 (압축 연결이면 압축, dt 범위를 넘으면 멈춤)
+// 구간 길이를 반환하고 *consumed에 담은 레코드 수를 기록
+static size_t encode_relay_section(uint8_t* buf, size_t capacity, uint32_t node_id, const WireRecord* records,
+                                   int count, bool compress, int* consumed) {
+    uint8_t* payload = buf + PROTOCOL_RELAY_SECTION_HEADER_SIZE;
+    size_t available = capacity - PROTOCOL_RELAY_SECTION_HEADER_SIZE;
+    uint8_t type = FRAME_BATCH;
+    size_t len = 0;
+
+    *consumed = 0;
+    if (compress) {
+        CompressEncoder encoder;
+        protocol_compress_begin(&encoder, payload, available, records[0].timestamp_us);
+        while (*consumed < count && protocol_compress_add(&encoder, &records[*consumed])) {
+            (*consumed)++;
+        }
+        if (*consumed > 0) {
+            type = FRAME_BATCH_COMPRESSED;
+            len = protocol_compress_finish(&encoder);
+        }
+    }
+    // 압축할 수 없는 레코드(채널 번호 범위 밖 등)는 고정 레이아웃으로
+    if (*consumed == 0) {
+        len = protocol_encode_batch(payload, available, records, count, consumed);
+    }
+    protocol_encode_relay_section(buf, node_id, type, len);
+    return PROTOCOL_RELAY_SECTION_HEADER_SIZE + len;
+}
+
+// 이 노드와 하위 노드들의 레코드를 FRAME_RELAY 하나로: 노드별로 모아 구간을 만들고 (노드 안의 순서는 유지)
+// 이 노드의 몫은 node_id 0 구간. 한 번에 최대 한 배치라 구간이 레코드마다 나뉘어도 프레임 하나에 들어감
+static int send_relay(int endpoint, const WireRecord* records, int count) {
+    static uint8_t payload[UPLINK_MAX_BATCH * (PROTOCOL_RELAY_SECTION_HEADER_SIZE + PROTOCOL_BATCH_HEADER_SIZE +
+                                               PROTOCOL_COMPRESS_MAX_RECORD_BITS / 8)];
+    static WireRecord section[UPLINK_MAX_BATCH];
+    bool taken[UPLINK_MAX_BATCH] = { false };
+    bool compress = network_encoding(endpoint) == WIRE_COMPRESSED;
+    size_t len = 0;
+
+    if (window_full(endpoint)) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (taken[i]) {
+            continue;
+        }
+        int n = 0;
+        for (int j = i; j < count; j++) {
+            if (!taken[j] && records[j].node_id == records[i].node_id) {
+                section[n++] = records[j];
+                taken[j] = true;
+            }
+        }
+        for (int done = 0; done < n;) {
+            int consumed;
+            len += encode_relay_section(payload + len, sizeof(payload) - len, records[i].node_id, section + done,
+                                        n - done, compress, &consumed);
+            done += consumed;
+        }
+    }
+
+    uint64_t seq;
+    if (!network_send_data(endpoint, FRAME_RELAY, payload, len, &seq)) {
+        return 0;
+    }
+    window_store(endpoint, seq, false, records, count);
+    return count;
+}
+
+// 협상한 형식으로 이 노드의 레코드를 보냄
+static int send_own(int endpoint, const WireRecord* records, int count) {
+    WireEncoding encoding = network_encoding(endpoint);
+    switch (encoding) {
+    case WIRE_COMPRESSED:
+        return send_compressed(endpoint, records, count);
+    case WIRE_BINARY:
+        return send_binary(endpoint, records, count);
+    default:
+        return send_json(endpoint, records, count, encoding);
+    }
+}
+
+// 중계를 받지 않는 서버(구버전, JSON 연결): 이 노드의 레코드만 보내고 중계 레코드는 버림
+// 반환값은 원래 배열 기준으로 앞에서부터 처리한 수 (보낸 레코드 사이의 중계 레코드도 처리한 것으로)
+static int send_own_only(int endpoint, const WireRecord* records, int count) {
+    static WireRecord own[UPLINK_MAX_BATCH];
+    static bool unsupported_logged = false;
+    int n = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (records[i].node_id == 0) {
+            own[n++] = records[i];
+        }
+    }
+    int sent = n > 0 ? send_own(endpoint, own, n) : 0;
+
+    // sent번째 이 노드 레코드 앞까지가 처리한 몫 (모두 보냈으면 전부)
+    int processed = count;
+    if (sent < n) {
+        for (int i = 0, seen = 0; i < count; i++) {
+            if (records[i].node_id == 0 && seen++ == sent) {
+                processed = i;
+                break;
+            }
+        }
+    }
+    int dropped = 0;
+    for (int i = 0; i < processed; i++) {
+        dropped += records[i].node_id != 0;
+    }
+    if (dropped > 0) {
+        atomic_fetch_add_explicit(&relay_dropped, dropped, memory_order_relaxed);
+        if (!unsupported_logged) {
+            log_error("Uplink server does not accept relayed records, dropping them");
+            unsupported_logged = true;
+        }
+    }
+    return processed;
+}
+
+// 전송 형식은 서버마다 연결 시 협상되므로 연결을 먼저 확보
+// 보낸 레코드 수를 반환 (앞에서부터, 도중에 실패하면 나머지는 보내지 않음)
+static int send_to(int endpoint, const WireRecord* records, int count) {
+    if (!connect_to(endpoint)) {
+        return 0;
+    }
+
+    bool relayed = false;
+    for (int i = 0; i < count && !relayed; i++) {
+        relayed = records[i].node_id != 0;
+    }
+    if (!relayed) {
+        return send_own(endpoint, records, count);
+    }
+    return network_accepts_relay(endpoint) ? send_relay(endpoint, records, count)
+                                           : send_own_only(endpoint, records, count);
+}
+
+// 레코드를 담당 서버별로 나눠 보냄. 서버가 실패하면 그 몫을 같은 호출 안에서 링의 다음
+// 서버로 다시 보내므로, 한 채널의 레코드는 실패가 있어도 보낸 순서대로 도착함
+// 끝내 보내지 못한 레코드를 원래 순서대로 records 앞쪽에 모으고 그 수를 반환
+static int send_records(WireRecord* records, int count) {
+    static WireRecord group[UPLINK_MAX_BATCH];
+    int failures = 0;
+
+    while (count > 0 && failures < network_endpoint_count()) {
+        int target = network_route_node(records[0].node_id, records[0].channel);
+        if (target < 0) {
+            break;
+        }
+
+        // 같은 서버로 갈 레코드는 group으로, 나머지는 순서를 유지한 채 앞으로 당김
+        int n = 0, rest = 0;
+        for (int i = 0; i < count; i++) {
+            if (network_route_node(records[i].node_id, records[i].channel) == target) {
+                group[n++] = records[i];
+            } else {
+                records[rest++] = records[i];
+            }
+        }
+
+        int sent = send_to(target, group, n);
+        count = rest + n - sent;
+        if (sent == n) {
+            continue;
+        }
+        // 실패한 서버는 라우팅에서 빠졌으므로 다음 반복에서 이 몫의 새 담당 서버를 찾음
+        // (확인 대기 창이 차서 멈췄으면 같은 서버가 다시 골라지고 바로 실패)
+        memcpy(records + rest, group + sent, sizeof(WireRecord) * (n - sent));
+        failures++;
+    }
+    return count;
+}
+
+// 보낸 몫을 차선 지표에 반영 (지연은 가장 오래된 측정값 기준)
+static void note_sent(UplinkLane lane, int sent, int64_t oldest_ts) {
+    LaneStats* stats = &lane_stats[lane];
+    if (sent <= 0) {
+        return;
+    }
+    atomic_fetch_add_explicit(&stats->sent, sent, memory_order_relaxed);
+    int64_t latency = reading_timestamp_now() - oldest_ts;
+    if (latency > atomic_load_explicit(&stats->max_latency_us, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->max_latency_us, latency, memory_order_relaxed);
+    }
+}
+
+static int64_t oldest_timestamp(const WireRecord* records, int count) {
+    int64_t oldest = records[0].timestamp_us;
+    for (int i = 1; i < count; i++) {
+        if (records[i].timestamp_us < oldest) {
+            oldest = records[i].timestamp_us;
+        }
+    }
+    return oldest;
+}
+
+// 중계 링에서 최대 max건을 꺼냄
+static int relay_take(WireRecord* out, int max) {
+    int n = 0;
+
+    pthread_mutex_lock(&relay_mutex);
+    while (n < max && relay_count > 0) {
+        out[n++] = relay_ring[relay_head];
+        relay_head = (relay_head + 1) % relay_capacity;
+        relay_count--;
+    }
+    pthread_mutex_unlock(&relay_mutex);
+    return n;
+}
+
+static int relay_depth(void) {
+    if (relay_capacity == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&relay_mutex);
+    int depth = relay_count;
+    pthread_mutex_unlock(&relay_mutex);
+    return depth;
+}
+
+// 배치를 기다리는 레코드 수 (bulk 큐 + 중계 링)
+static uint64_t pending_depth(void) {
+    return queue_depth(&queues[LANE_BULK]) + (uint64_t)relay_depth();
+}
+
+static void send_batch(const Reading* readings, int count) {
+    static WireRecord records[UPLINK_MAX_BATCH];
+
+    // 하위 노드에서 중계받은 레코드로 남는 자리를 채워 같은 프레임으로 보냄
+    count = to_wire_records(readings, count, records);
+    if (relay_capacity > 0 && count < UPLINK_MAX_BATCH) {
+        count += relay_take(records + count, UPLINK_MAX_BATCH - count);
+    }
+    if (count == 0) {
+        return;
+    }
+
+    int64_t oldest = oldest_timestamp(records, count);
+    int unsent = send_records(records, count);
+    note_sent(LANE_BULK, count - unsent, oldest);
+    count = unsent;
+    if (count == 0) {
+        return;
+    }
+
+    // 어느 서버로도 보내지 못한 몫은 스풀에 보관했다가 복구 후 재전송
+    if (spool_enabled) {
+        spool_append(records, count);
+        log_debug("Spooled batch of %d readings (%llu pending)", count, (unsigned long long)spool_pending());
+    } else {
+        log_error("Failed to send batch of %d readings", count);
+    }
+}
+
+// 스풀에 쌓인 측정값을 drain_rate 이하로 한 프레임씩 재전송
+// (복구 직후 몇 시간치가 한꺼번에 몰려 서버가 넘어지지 않도록)
+static void drain_spool(void) {
+    static WireRecord backlog[UPLINK_MAX_BATCH];
+    struct timespec now;
+
+    if (!spool_enabled) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // 서버가 밀리는 동안에는 실시간 측정값에 자리를 양보 (토큰은 계속 쌓임)
+    if (pressure_level > 0) {
+        last_drain = now;
+        return;
+    }
+    drain_tokens += ((now.tv_sec - last_drain.tv_sec) + (now.tv_nsec - last_drain.tv_nsec) / 1e9) * drain_rate;
+    if (drain_tokens > UPLINK_MAX_BATCH) {
+        drain_tokens = UPLINK_MAX_BATCH;
+    }
+    last_drain = now;
+
+    uint64_t pending = spool_pending();
+    if (pending == 0) {
+        return;
+    }
+
+    int want = pending < UPLINK_MAX_BATCH ? (int)pending : UPLINK_MAX_BATCH;
+    if (drain_tokens < want) {
+        return;
+    }
+
+    int count = spool_peek(backlog, want);
+    int unsent = count > 0 ? send_records(backlog, count) : 0;
+    if (count > 0 && unsent == count) {
+        return;     // 아직 연결 불가: 커서를 그대로 두고 다음에 다시
+    }
+    // 보낸 몫만 커밋하고 보내지 못한 레코드(send_records가 앞쪽에 모아 둠)는 다음에 다시
+    spool_commit_unsent(backlog, unsent);
+    drain_tokens -= count - unsent;
+
+    if (unsent == 0 && pending <= (uint64_t)want) {
+        log_info("Uplink spool drained");
+    }
+}
+
+// 경보 차선 처리: 배치가 찼거나 linger가 지났으면 보냄. 보내지 못한 경보는 스풀로 보내지 않고
+// 다음 호출에서 가장 먼저 다시 보냄 (복구 직후 스풀 재전송보다 앞서도록)
+static WireRecord alarm_pending[UPLINK_MAX_BATCH];
+static int alarm_pending_count = 0;
+static bool alarm_lingering = false;
+static struct timespec alarm_first_seen;
+
+static long elapsed_ms(const struct timespec* from, const struct timespec* to);
+
+// 경보 차선이 보낼 때가 될 때까지 남은 시간 (보낼 것이 없으면 -1)
+static long alarm_wait_ms(const struct timespec* now) {
+    ReadingQueue* q = &queues[LANE_ALARM];
+    if (!uplink_config.priority.enabled || queue_depth(q) == 0) {
+        return -1;
+    }
+    if (!alarm_lingering) {
+        alarm_lingering = true;
+        alarm_first_seen = *now;
+    }
+    if (queue_depth(q) >= (uint64_t)uplink_config.priority.max_batch_records) {
+        return 0;
+    }
+    long remaining = uplink_config.priority.linger_ms - elapsed_ms(&alarm_first_seen, now);
+    return remaining > 0 ? remaining : 0;
+}
+
+static void service_alarms(void) {
+    struct timespec now;
+    Reading reading;
+
+    if (!uplink_config.priority.enabled) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    bool ready = alarm_wait_ms(&now) == 0;
+    if (!ready && alarm_pending_count == 0) {
+        return;
+    }
+
+    if (ready) {
+        alarm_lingering = false;
+        while (alarm_pending_count < UPLINK_MAX_BATCH && queue_pop(&queues[LANE_ALARM], &reading)) {
+            alarm_pending_count += to_wire_records(&reading, 1, &alarm_pending[alarm_pending_count]);
+        }
+    }
+    if (alarm_pending_count == 0) {
+        return;
+    }
+
+    int64_t oldest = oldest_timestamp(alarm_pending, alarm_pending_count);
+    int unsent = send_records(alarm_pending, alarm_pending_count);
+    note_sent(LANE_ALARM, alarm_pending_count - unsent, oldest);
+    alarm_pending_count = unsent;
+}
+
+// 이 노드의 요약 레코드를 한 프레임에 담아 보냄 (dt 범위를 넘으면 나눔), 보낸 수를 반환
+static int send_own_summaries(int endpoint, const SummaryRecord* records, int count) {
+    static uint8_t payload[PROTOCOL_BATCH_HEADER_SIZE + UPLINK_MAX_BATCH * PROTOCOL_SUMMARY_RECORD_SIZE];
+    int sent = 0;
+
+    while (sent < count && !window_full(endpoint)) {
+        int consumed;
+        uint64_t seq;
+        size_t len = protocol_encode_summary(payload, sizeof(payload), records + sent, count - sent, &consumed);
+        if (!network_send_data(endpoint, FRAME_SUMMARY, payload, len, &seq)) {
+            break;
+        }
+        window_store(endpoint, seq, true, records + sent, consumed);
+        sent += consumed;
+    }
+    return sent;
+}
+
+// 이 노드와 하위 노드들의 요약을 FRAME_RELAY 하나로: send_relay와 같이 노드별 요약 구간(FRAME_SUMMARY)으로
+static int send_summary_relay(int endpoint, const SummaryRecord* records, int count) {
+    static uint8_t payload[UPLINK_MAX_BATCH * (PROTOCOL_RELAY_SECTION_HEADER_SIZE + PROTOCOL_BATCH_HEADER_SIZE +
+                                               PROTOCOL_SUMMARY_RECORD_SIZE)];
+    static SummaryRecord section[UPLINK_MAX_BATCH];
+    bool taken[UPLINK_MAX_BATCH] = { false };
+    size_t len = 0;
+
+    if (window_full(endpoint)) {
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (taken[i]) {
+            continue;
+        }
+        int n = 0;
+        for (int j = i; j < count; j++) {
+            if (!taken[j] && records[j].node_id == records[i].node_id) {
+                section[n++] = records[j];
+                taken[j] = true;
+            }
+        }
+        for (int done = 0; done < n;) {
+            int consumed;
+            size_t section_len = protocol_encode_summary(payload + len + PROTOCOL_RELAY_SECTION_HEADER_SIZE,
+                                                         sizeof(payload) - len - PROTOCOL_RELAY_SECTION_HEADER_SIZE,
+                                                         section + done, n - done, &consumed);
+            protocol_encode_relay_section(payload + len, records[i].node_id, FRAME_SUMMARY, section_len);
+            len += PROTOCOL_RELAY_SECTION_HEADER_SIZE + section_len;
+            done += consumed;
+        }
+    }
+
+    uint64_t seq;
+    if (!network_send_data(endpoint, FRAME_RELAY, payload, len, &seq)) {
+        return 0;
+    }
+    window_store(endpoint, seq, true, records, count);
+    return count;
+}
+
+// 중계를 받지 않는 서버: 이 노드의 요약만 보내고 중계 요약은 버림 (반환값은 send_own_only와 같이)
+static int send_own_summaries_only(int endpoint, const SummaryRecord* records, int count) {
+    static SummaryRecord own[UPLINK_MAX_BATCH];
+    static bool unsupported_logged = false;
+    int n = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (records[i].node_id == 0) {
+            own[n++] = records[i];
+        }
+    }
+    int sent = n > 0 ? send_own_summaries(endpoint, own, n) : 0;
+
+    int processed = count;
+    if (sent < n) {
+        for (int i = 0, seen = 0; i < count; i++) {
+            if (records[i].node_id == 0 && seen++ == sent) {
+                processed = i;
+                break;
+            }
+        }
+    }
+    int dropped = 0;
+    for (int i = 0; i < processed; i++) {
+        dropped += records[i].node_id != 0;
+    }
+    if (dropped > 0) {
+        atomic_fetch_add_explicit(&relay_dropped, dropped, memory_order_relaxed);
+        if (!unsupported_logged) {
+            log_error("Uplink server does not accept relayed summaries, dropping them");
+            unsupported_logged = true;
+        }
+    }
+    return processed;
+}
+
+// 요약을 보내고 보낸 수를 반환 (send_to와 같이 하위 노드의 요약이 섞였으면 중계 프레임으로)
+// 요약을 받지 않는 서버(구버전)면 보낼 곳이 없으므로 버리고 보낸 것으로 처리
+static int send_summary_to(int endpoint, const SummaryRecord* records, int count) {
+    static bool unsupported_logged = false;
+
+    if (!connect_to(endpoint)) {
+        return 0;
+    }
+    if (!network_accepts_summaries(endpoint)) {
+        if (!unsupported_logged) {
+            log_error("Uplink server does not accept summaries, dropping them");
+            unsupported_logged = true;
+        }
+        return count;
+    }
+
+    bool relayed = false;
+    for (int i = 0; i < count && !relayed; i++) {
+        relayed = records[i].node_id != 0;
+    }
+    if (!relayed) {
+        return send_own_summaries(endpoint, records, count);
+    }
+    return network_accepts_relay(endpoint) ? send_summary_relay(endpoint, records, count)
+                                           : send_own_summaries_only(endpoint, records, count);
+}
+
+// 요약 레코드를 send_records와 같은 방식으로 담당 서버별로 보내고 보내지 못한 수를 반환
+static int send_summary_records(SummaryRecord* summaries, int count) {
+    static SummaryRecord group[UPLINK_MAX_BATCH];
+    int failures = 0;
+
+    while (count > 0 && failures < network_endpoint_count()) {
+        int target = network_route_node(summaries[0].node_id, summaries[0].channel);
+        if (target < 0) {
+            break;
+        }
+
+        int n = 0, rest = 0;
+        for (int i = 0; i < count; i++) {
+            if (network_route_node(summaries[i].node_id, summaries[i].channel) == target) {
+                group[n++] = summaries[i];
+            } else {
+                summaries[rest++] = summaries[i];
+            }
+        }
+
+        int sent = send_summary_to(target, group, n);
+        count = rest + n - sent;
+        if (sent == n) {
+            continue;
+        }
+        memcpy(summaries + rest, group + sent, sizeof(SummaryRecord) * (n - sent));
+        failures++;
+    }
+    return count;
+}
+
+// 닫힌 구간 요약을 보내고, 끝내 보내지 못한 몫은 집계 대기열 앞에 되돌려 다음 주기에 다시
+static void send_summaries(void) {
+    static SummaryRecord summaries[UPLINK_MAX_BATCH];
+
+    int count = aggregate_take(summaries, UPLINK_MAX_BATCH);
+    if (count > 0) {
+        count = send_summary_records(summaries, count);
+    }
+    if (count > 0) {
+        aggregate_requeue(summaries, count);
+    }
+}
+
+// 서버가 커밋을 확인한 프레임을 창에서 뺌 (끊긴 연결로 보낸 프레임은 settle_window와 재전송이 처리)
+static void release_acked(void) {
+    for (int i = 0; i < unacked_slots && unacked_count > 0; i++) {
+        UnackedFrame* frame = &unacked[i];
+        if (frame->used && frame->generation == network_generation(frame->endpoint) &&
+            frame->seq <= network_acked_seq(frame->endpoint)) {
+            frame->used = false;
+            unacked_count--;
+        }
+    }
+}
+
+// 확인 전에 연결이 끊긴 프레임을 보낸 순서대로 다시 보냄
+// 같은 서버에 다시 연결되면 HELLO 직후 받은 high-water mark로 이미 커밋된 프레임을 먼저 걸러내고,
+// 서버가 아직 죽어 있으면 다른 서버로 넘김 (그 서버가 실제로는 커밋했다면 서버 사이의 중복은 남을 수 있음)
+static void retransmit_unacked(void) {
+    static UnackedFrame resend;
+
+    if (unacked_count == 0) {
+        return;
+    }
+    release_acked();
+
+    uint64_t after = 0;
+    for (;;) {
+        // 다음으로 오래된 끊긴 프레임
+        UnackedFrame* frame = NULL;
+        for (int i = 0; i < unacked_slots; i++) {
+            UnackedFrame* f = &unacked[i];
+            if (f->used && f->order > after && f->generation != network_generation(f->endpoint) &&
+                (!frame || f->order < frame->order)) {
+                frame = f;
+            }
+        }
+        if (!frame) {
+            break;
+        }
+        after = frame->order;
+
+        connect_to(frame->endpoint);
+        if (!frame->used) {
+            continue;   // 다시 연결된 서버가 이미 커밋함
+        }
+
+        // 창 수에서만 빼고 보냄 (보낸 몫은 새 seq로 다른 자리에 들어감)
+        // 원래 자리는 결과를 알 때까지 잡아 두고, seq를 지워 그사이 settle_window가 건드리지 않게 함
+        resend = *frame;
+        frame->seq = 0;
+        unacked_count--;
+        int unsent = resend.summary ? send_summary_records(resend.summaries, resend.count)
+                                    : send_records(resend.records, resend.count);
+        atomic_fetch_add_explicit(&retransmitted_frames, 1, memory_order_relaxed);
+        if (unsent == 0) {
+            frame->used = false;
+            continue;
+        }
+
+        // 보내지 못한 몫은 원래 seq와 순서 그대로 잡아 둔 자리에 남겨 다음에 다시 (같은 서버가 돌아오면 확인부터)
+        // 보낸 몫이 창을 채웠으면 창 밖의 실패 경로로 (원래 seq를 잊으므로 그 서버가 커밋했다면 중복될 수 있음)
+        resend.count = unsent;
+        if (unacked_count < unacked_capacity) {
+            *frame = resend;
+            unacked_count++;
+        } else {
+            frame->used = false;
+            if (resend.summary) {
+                aggregate_requeue(resend.summaries, unsent);
+            } else if (spool_enabled) {
+                spool_append(resend.records, unsent);
+            } else {
+                log_error("Failed to retransmit %d readings", unsent);
+            }
+        }
+        break;
+    }
+}
+
+static bool coalesce_pending(void) {
+    if (uplink_config.overflow_policy != UPLINK_OVERFLOW_COALESCE) {
+        return false;
+    }
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        if (atomic_load_explicit(&coalesce_slots[ch].seq, memory_order_relaxed) !=
+            atomic_load_explicit(&coalesce_slots[ch].taken, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 큐에서 최대 한 프레임 분량을 꺼내고, 남는 자리에 덮어쓰기 값을 채움
+static int collect_batch(Reading* out) {
+    int count = 0;
+    while (count < UPLINK_MAX_BATCH && queue_pop(&queues[LANE_BULK], &out[count])) {
+        count++;
+    }
+    if (uplink_config.overflow_policy == UPLINK_OVERFLOW_COALESCE) {
+        for (int ch = 0; ch < NUM_CHANNELS && count < UPLINK_MAX_BATCH; ch++) {
+            if (coalesce_take(ch, &out[count])) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+static long elapsed_ms(const struct timespec* from, const struct timespec* to) {
+    return (to->tv_sec - from->tv_sec) * 1000 + (to->tv_nsec - from->tv_nsec) / 1000000;
+}
+
+// 생산자가 깨우거나 timeout_ms가 지날 때까지 대기
+static void wait_for_records(uint32_t wake, long timeout_ms) {
+    struct timespec timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (timeout_ms % 1000) * 1000000L
+    };
+    syscall(SYS_futex, &wake_word, FUTEX_WAIT_PRIVATE, wake, &timeout, NULL, 0);
+}
+
+static void set_pressure_level(int level, uint64_t depth, long rtt_ms) {
+    const BackpressureConfig* bp = &uplink_config.backpressure;
+    int batch = uplink_config.max_batch_records << level;
+    int linger = uplink_config.linger_ms << level;
+    int divisor = level <= 1 ? 1 : 1 << (level - 1);
+
+    int max_linger = bp->max_linger_ms > uplink_config.linger_ms ? bp->max_linger_ms : uplink_config.linger_ms;
+    if (batch > UPLINK_MAX_BATCH) {
+        batch = UPLINK_MAX_BATCH;
+    }
+    if (linger > max_linger) {
+        linger = max_linger;
+    }
+    if (divisor > bp->max_divisor) {
+        divisor = bp->max_divisor;
+    }
+
+    pressure_level = level;
+    atomic_store_explicit(&batch_target, batch, memory_order_relaxed);
+    linger_target = linger;
+    for (int ch = 0; ch < NUM_CHANNELS; ch++) {
+        SensorKind kind;
+        int sensor_id;
+        bool critical = readings_channel_info(ch, &kind, &sensor_id) && (bp->critical_kinds & (1u << kind));
+        atomic_store_explicit(&channel_divisor[ch], critical ? 1 : divisor, memory_order_relaxed);
+    }
+
+    log_info("Uplink backpressure level %d (queue %llu/%llu, rtt %ld ms): batch %d, linger %d ms, "
+             "non-critical channels 1/%d", level, (unsigned long long)depth,
+             (unsigned long long)(queues[LANE_BULK].mask + 1), rtt_ms, batch, linger, divisor);
+}
+
+// 현재 배치 한 건을 넘어 큐의 1/4 이상 밀렸거나 RTT/전송 시간이 목표를 넘으면 한 단계 올리고,
+// 큐에 배치 한 건 이하만 남고 둘 다 목표의 절반 아래면 한 단계 내림
+// (배치/linger를 키우면 큐가 그만큼 차 있는 게 정상이므로 깊이는 배치 크기 기준으로 봄)
+static void adjust_backpressure(void) {
+    const BackpressureConfig* bp = &uplink_config.backpressure;
+    struct timespec now;
+
+    if (!bp->enabled) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (elapsed_ms(&last_adjust, &now) < BACKPRESSURE_INTERVAL_MS) {
+        return;
+    }
+    last_adjust = now;
+
+    uint64_t capacity = queues[LANE_BULK].mask + 1;
+    uint64_t depth = queue_depth(&queues[LANE_BULK]);
+    long rtt_ms = network_rtt_us() / 1000;
+    long slowest = slowest_send_ms;
+    slowest_send_ms = 0;
+
+    uint64_t batch = (uint64_t)atomic_load_explicit(&batch_target, memory_order_relaxed);
+    bool loaded = depth > batch + capacity / 4 || rtt_ms > bp->target_rtt_ms || slowest > bp->target_rtt_ms;
+    bool relaxed = depth <= batch && rtt_ms * 2 < bp->target_rtt_ms && slowest * 2 < bp->target_rtt_ms;
+
+    if (loaded && pressure_level < BACKPRESSURE_MAX_LEVEL) {
+        set_pressure_level(pressure_level + 1, depth, rtt_ms);
+    } else if (relaxed && pressure_level > 0) {
+        set_pressure_level(pressure_level - 1, depth, rtt_ms);
+    }
+}
+
+static void fill_stats(WmUplinkStats* stats) {
+    stats->queue_depth = queue_depth(&queues[LANE_BULK]);
+    stats->queue_capacity = queues[LANE_BULK].mask + 1;
+    stats->enqueued = atomic_load_explicit(&lane_stats[LANE_BULK].enqueued, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&lane_stats[LANE_BULK].dropped, memory_order_relaxed);
+    stats->spilled = atomic_load_explicit(&spilled_count, memory_order_relaxed);
+    stats->coalesced = atomic_load_explicit(&coalesced_count, memory_order_relaxed);
+    stats->spool_pending = spool_pending();
+}
+
+// 넘침 카운터가 늘었으면 기록 (측정 스레드는 로그를 쓰지 않으므로 여기서)
+static void publish_stats(void) {
+    static uint64_t logged_dropped = 0, logged_spilled = 0, logged_coalesced = 0;
+    WmUplinkStats stats;
+
+    fill_stats(&stats);
+    shm_export_set_uplink_stats(&stats);
+
+    if (stats.dropped != logged_dropped || stats.spilled != logged_spilled ||
+        stats.coalesced != logged_coalesced) {
+        log_error("Uplink queue overflow: %llu dropped, %llu spilled, %llu coalesced",
+                  (unsigned long long)(stats.dropped - logged_dropped),
+                  (unsigned long long)(stats.spilled - logged_spilled),
+                  (unsigned long long)(stats.coalesced - logged_coalesced));
+        logged_dropped = stats.dropped;
+        logged_spilled = stats.spilled;
+        logged_coalesced = stats.coalesced;
+    }
+}
+
+void* uplink_thread(void* arg) {
+    static Reading pending[UPLINK_MAX_BATCH];
+    static bool lingering = false;
+    static struct timespec first_seen;
+    struct timespec now;
+    static bool route_checked = false;
+    (void)arg;
+
+    // 첫 호출: 측정 스레드는 이미 돌고 있으므로 경로를 기다리는 동안의 측정값은 큐에 쌓임
+    if (!route_checked) {
+        network_wait_for_route();
+        route_checked = true;
+    }
+
+    uint32_t wake = atomic_load_explicit(&wake_word, memory_order_acquire);
+    bool waiting = pending_depth() > 0 || coalesce_pending();
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long timeout = UPLINK_IDLE_WAIT_MS;
+    if (!waiting) {
+        lingering = false;
+    } else {
+        if (!lingering) {
+            lingering = true;
+            first_seen = now;
+        }
+        long remaining = linger_target - elapsed_ms(&first_seen, &now);
+        if (pending_depth() >= (uint64_t)atomic_load(&batch_target) || remaining <= 0) {
+            timeout = 0;
+        } else if (remaining < timeout) {
+            timeout = remaining;
+        }
+    }
+    long alarm_wait = alarm_wait_ms(&now);
+    if (alarm_wait >= 0 && alarm_wait < timeout) {
+        timeout = alarm_wait;
+    }
+    if (timeout > 0) {
+        wait_for_records(wake, timeout);
+    }
+
+    // 유휴 중에 끊긴 연결은 다음 전송 전에 백오프를 시작해 그 채널들이 바로 다른 서버로 넘어가게 함
+    network_check_peers();
+    network_sync_clocks();
+    retransmit_unacked();
+
+    // 경보 차선을 먼저 보내고, bulk 작업(배치, 스풀 재전송, 요약) 한 프레임마다 다시 확인
+    service_alarms();
+
+    // 배치가 찼거나 첫 값이 들어온 뒤 linger가 지났으면 전송
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (lingering && (pending_depth() >= (uint64_t)atomic_load(&batch_target) ||
+                      elapsed_ms(&first_seen, &now) >= linger_target)) {
+        int count = collect_batch(pending);
+        lingering = false;
+        if (count > 0 || relay_depth() > 0) {
+            send_batch(pending, count);
+            struct timespec sent;
+            clock_gettime(CLOCK_MONOTONIC, &sent);
+            if (elapsed_ms(&now, &sent) > slowest_send_ms) {
+                slowest_send_ms = elapsed_ms(&now, &sent);
+            }
+        }
+    } else if (!lingering && (pending_depth() > 0 || coalesce_pending())) {
+        lingering = true;
+        first_seen = now;
+    }
+
+    adjust_backpressure();
+    service_alarms();
+    drain_spool();
+    service_alarms();
+    send_summaries();
+    if (spool_enabled && uplink_config.overflow_policy == UPLINK_OVERFLOW_SPILL) {
+        spool_sync();   // 측정 스레드가 매핑에만 남긴 레코드
+    }
+    publish_stats();
+    return NULL;
+}
+
+// 종료 전에 확인 응답을 기다리고, 끝내 확인되지 않은 측정값은 스풀로 (다음 실행에서 새 seq로 다시
+// 보내므로 서버가 실제로는 커밋했다면 그 몫은 중복될 수 있음)
+static void flush_unacked(void) {
+    struct timespec start, now;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    now = start;
+    while (unacked_count > 0 && elapsed_ms(&start, &now) < UPLINK_FLUSH_ACK_WAIT_MS) {
+        network_check_peers();
+        retransmit_unacked();
+        if (unacked_count > 0) {
+            usleep(10000);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+
+    int lost = 0;
+    for (int i = 0; i < unacked_slots && unacked_count > 0; i++) {
+        UnackedFrame* frame = &unacked[i];
+        if (!frame->used) {
+            continue;
+        }
+        if (!frame->summary && spool_enabled) {
+            spool_append(frame->records, frame->count);
+        } else {
+            lost += frame->count;
+        }
+        frame->used = false;
+        unacked_count--;
+    }
+    if (lost > 0) {
+        log_error("%d unacknowledged records lost at shutdown", lost);
+    }
+}
+
+// 종료 시 모은 경보를 보내고 보내지 못한 몫은 스풀로 (스풀이 없으면 로그)
+static void flush_alarms(void) {
+    int unsent = alarm_pending_count > 0 ? send_records(alarm_pending, alarm_pending_count) : 0;
+    if (unsent > 0 && spool_enabled) {
+        spool_append(alarm_pending, unsent);
+    } else if (unsent > 0) {
+        log_error("Failed to send %d alarms", unsent);
+    }
+    alarm_pending_count = 0;
+}
+
+void uplink_flush(void) {
+    static Reading pending[UPLINK_MAX_BATCH];
+    int count;
+
+    // 경보 먼저 (보내지 못한 경보는 bulk와 함께 스풀로)
+    if (uplink_config.priority.enabled) {
+        Reading reading;
+        while (queue_pop(&queues[LANE_ALARM], &reading)) {
+            if (alarm_pending_count == UPLINK_MAX_BATCH) {
+                flush_alarms();
+            }
+            alarm_pending_count += to_wire_records(&reading, 1, &alarm_pending[alarm_pending_count]);
+        }
+        flush_alarms();
+    }
+
+    while ((count = collect_batch(pending)) > 0 || relay_depth() > 0) {
+        send_batch(pending, count);
+    }
+
+    // 끝나지 않은 구간도 요약으로 남김 (count가 구간 길이보다 적음)
+    aggregate_flush();
+    while (aggregate_pending() > 0) {
+        int before = aggregate_pending();
+        send_summaries();
+        if (aggregate_pending() >= before) {
+            log_error("Failed to send %d summaries at shutdown", before);
+            break;
+        }
+    }
+
+    flush_unacked();
+}
+
+void uplink_report_stats(void) {
+    WmUplinkStats stats;
+
+    fill_stats(&stats);
+    log_info("Uplink: queue %u/%u, %llu enqueued, %llu dropped, %llu spilled, %llu coalesced, %llu spooled, "
+             "%llu decimated (backpressure level %d), %llu within deadband",
+             stats.queue_depth, stats.queue_capacity, (unsigned long long)stats.enqueued,
+             (unsigned long long)stats.dropped, (unsigned long long)stats.spilled,
+             (unsigned long long)stats.coalesced, (unsigned long long)stats.spool_pending,
+             (unsigned long long)atomic_load_explicit(&decimated_count, memory_order_relaxed), pressure_level,
+             (unsigned long long)deadband_suppressed());
+    NetworkStats network;
+    network_get_stats(&network);
+    log_info("Uplink connections: %llu reconnects, %llu failed attempts, %llu dead connections detected, "
+             "%.1f s down in total (%d/%d servers down)",
+             (unsigned long long)network.reconnects, (unsigned long long)network.connect_failures,
+             (unsigned long long)network.dead_peers, network.downtime_ms / 1000.0, network.servers_down,
+             network_endpoint_count());
+
+    for (int i = 0; i < network_endpoint_count(); i++) {
+        int64_t offset_us, rtt_us;
+        if (network_clock_offset(i, &offset_us, &rtt_us)) {
+            log_info("Uplink clock: server %d offset %+.3f ms (rtt %.3f ms)", i, offset_us / 1000.0, rtt_us / 1000.0);
+        }
+    }
+
+    if (unacked_capacity > 0) {
+        log_info("Uplink acks: %d/%d frames awaiting acknowledgement, %llu retransmitted, %llu window stalls",
+                 unacked_count, unacked_capacity,
+                 (unsigned long long)atomic_load_explicit(&retransmitted_frames, memory_order_relaxed),
+                 (unsigned long long)atomic_load_explicit(&window_stalls, memory_order_relaxed));
+    }
+
+    if (relay_capacity > 0) {
+        log_info("Uplink relay: queue %d/%d, %llu records received, %llu spooled, %llu dropped", relay_depth(),
+                 relay_capacity, (unsigned long long)atomic_load_explicit(&relay_received, memory_order_relaxed),
+                 (unsigned long long)atomic_load_explicit(&relay_spilled, memory_order_relaxed),
+                 (unsigned long long)atomic_load_explicit(&relay_dropped, memory_order_relaxed));
+    }
+
+    // 게이트웨이는 집계를 하지 않아도 하위 노드의 요약을 보냄
+    if (uplink_config.aggregate.enabled || relay_capacity > 0) {
+        log_info("Uplink summaries: %d pending, %llu dropped", aggregate_pending(),
+                 (unsigned long long)aggregate_dropped());
+    }
+
+    // 차선별 지연: 측정 시각부터 전송 완료까지의 최댓값 (로그 사이 구간)
+    static const char* lane_names[LANE_COUNT] = { "alarm", "bulk" };
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        LaneStats* lane_stat = &lane_stats[lane];
+        if (lane == LANE_ALARM && !uplink_config.priority.enabled) {
+            continue;
+        }
+        log_info("Uplink %s lane: queue %llu, %llu enqueued, %llu dropped, %llu sent, max latency %lld ms",
+                 lane_names[lane], (unsigned long long)queue_depth(&queues[lane]),
+                 (unsigned long long)atomic_load_explicit(&lane_stat->enqueued, memory_order_relaxed),
+                 (unsigned long long)atomic_load_explicit(&lane_stat->dropped, memory_order_relaxed),
+                 (unsigned long long)atomic_load_explicit(&lane_stat->sent, memory_order_relaxed),
+                 (long long)(atomic_exchange_explicit(&lane_stat->max_latency_us, 0, memory_order_relaxed) / 1000));
+    }
+}
+
+void uplink_cleanup(void) {
+    if (spool_enabled) {
+        SpoolStats stats;
+        spool_get_stats(&stats);
+        log_info("Uplink spool: %llu readings pending, %llu overwritten, %llu corrupt",
+                 (unsigned long long)stats.pending, (unsigned long long)stats.overwritten,
+                 (unsigned long long)stats.corrupt);
+        spool_cleanup();
+        spool_enabled = false;
+    }
+
+    for (int lane = 0; lane < LANE_COUNT; lane++) {
+        free(queues[lane].cells);
+        queues[lane].cells = NULL;
+    }
+    free(unacked);
+    unacked = NULL;
+    unacked_capacity = 0;
+    unacked_slots = 0;
+    unacked_count = 0;
+    free(relay_ring);
+    relay_ring = NULL;
+    relay_capacity = 0;
+    relay_count = 0;
+}
+
+bool uplink_relay_init(int queue_size) {
+    if (queue_size < 1) {
+        queue_size = DEFAULT_RELAY_QUEUE_SIZE;
+    }
+    relay_ring = calloc(queue_size, sizeof(WireRecord));
+    if (!relay_ring) {
+        log_error("Failed to allocate relay queue (%d records)", queue_size);
+        return false;
+    }
+    relay_capacity = queue_size;
+    relay_head = 0;
+    relay_count = 0;
+    return true;
+}
+
+bool uplink_relay(const WireRecord* records, int count) {
+    if (relay_capacity == 0) {
+        return false;
+    }
+
+    pthread_mutex_lock(&relay_mutex);
+    bool fits = relay_count + count <= relay_capacity;
+    if (fits) {
+        for (int i = 0; i < count; i++) {
+            relay_ring[(relay_head + relay_count) % relay_capacity] = records[i];
+            relay_count++;
+        }
+    }
+    pthread_mutex_unlock(&relay_mutex);
+
+    // 링이 차면(서버가 밀리거나 끊김) 스풀에 바로 기록: 복구되면 이 노드의 측정값과 같이 재전송
+    if (!fits) {
+        if (!spool_enabled) {
+            return false;
+        }
+        spool_append(records, count);
+        atomic_fetch_add_explicit(&relay_spilled, count, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&relay_received, count, memory_order_relaxed);
+    wake_uplink();
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <stdbool.h>
+#include "types.h"
+#include "config.h"
+#include "protocol.h"
+
+// 업링크 배처 초기화 (스풀이 켜져 있으면 스풀 파일도 열어 남은 측정값을 이어서 보냄)
+bool uplink_init(const UplinkConfig* config, const SpoolConfig* spool_config);
+
+// 측정값을 업링크 큐에 넣음 (잠금 없음, 네트워크나 디스크를 기다리지 않음)
+// 큐가 가득 차면 overflow_policy에 따라 처리하고, 끝내 버려지면 false
+bool uplink_submit(const Reading* reading);
+
+// 업링크 스레드 함수 (한 주기): 큐에 배치 분량이 쌓이거나 linger 시간이 지나면
+// 한 프레임으로 묶어 한 번의 전송으로 보냄. 보내지 못한 배치는 스풀에 보관하고,
+// 연결이 복구되면 스풀을 속도 제한을 두고 재전송. 확인 응답을 협상한 서버로 보낸 프레임은
+// 서버가 커밋을 확인할 때까지 보관했다가 그 전에 연결이 끊기면 다시 보냄
+void* uplink_thread(void* arg);
+
+// 게이트웨이 중계 큐 준비 (uplink_init 이후, 중계 스레드를 시작하기 전에)
+bool uplink_relay_init(int queue_size);
+
+// 하위 노드에서 받은 레코드(node_id, 이 노드 시계 기준 시각)를 중계 큐에 넣음 (중계 스레드 한 곳에서만 호출)
+// 업링크 스레드가 자기 배치의 남는 자리에 채워 보내고, 큐가 차면 스풀에 기록
+// true면 이 노드가 맡은 것이므로 하위 노드에 확인 응답을 보내도 됨 (큐가 차고 스풀도 없으면 false)
+bool uplink_relay(const WireRecord* records, int count);
+
+// 큐에 남은 측정값 즉시 전송 (종료 시, 측정 스레드가 멈춘 뒤), 확인되지 않은 프레임은 스풀로
+void uplink_flush(void);
+
+// 큐 깊이와 넘침 카운터 로그 (공유 메모리에는 업링크 스레드가 주기마다 게시)
+void uplink_report_stats(void);
+
+// 스풀 닫기 (uplink_flush 이후)
+void uplink_cleanup(void);
+
+#endif
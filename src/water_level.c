@@ -2,6 +2,7 @@
 #include "adc.h"
 #include "logger.h"
 #include "config.h"
+#include "thread_manager.h"
 #include <stdlib.h>
 #include <math.h>
 
@@ -33,6 +34,7 @@ SensorData read_sensor_with_filtering(int sensor_id) {
     int valid_count = 0;
 
     // 여러 샘플 수집
+    thread_set_stage(STAGE_ADC_READ);
     for (int i = 0; i < WATER_LEVEL_SAMPLES; i++) {
         uint16_t adc_value = adc_read(sensor_id);
         float voltage = adc_to_voltage(adc_value);
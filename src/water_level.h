@@ -3,13 +3,6 @@
 
 #include "types.h"
 
-typedef struct {
-    CalibrationPoint* points;
-    int num_points;
-    float min_valid_voltage;
-    float max_valid_voltage;
-} SensorCalibration;
-
 // 센서별 보정 데이터를 설정 파일에서 로드
 bool load_sensor_calibrations(void);
 
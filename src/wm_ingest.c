@@ -0,0 +1,125 @@
+#include "wm_ingest.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct WmIngest {
+    WmIngestSegment* segment;
+    pid_t pid;
+};
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+WmIngest* wm_ingest_open(const char* name) {
+    int fd = shm_open(name ? name : WM_INGEST_SHM_NAME, O_RDWR, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WmIngestSegment)) {
+        close(fd);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    void* addr = mmap(NULL, sizeof(WmIngestSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    WmIngestSegment* segment = addr;
+    if (atomic_load_explicit(&segment->magic, memory_order_acquire) != WM_INGEST_MAGIC ||
+        segment->version != WM_INGEST_VERSION ||
+        segment->segment_size != sizeof(WmIngestSegment)) {
+        munmap(addr, sizeof(WmIngestSegment));
+        errno = EPROTO;
+        return NULL;
+    }
+
+    WmIngest* ingest = malloc(sizeof(WmIngest));
+    if (!ingest) {
+        munmap(addr, sizeof(WmIngestSegment));
+        return NULL;
+    }
+    ingest->segment = segment;
+    ingest->pid = getpid();
+    return ingest;
+}
+
+void wm_ingest_close(WmIngest* ingest) {
+    if (!ingest) {
+        return;
+    }
+    munmap(ingest->segment, sizeof(WmIngestSegment));
+    free(ingest);
+}
+
+int wm_ingest_submit_record(WmIngest* ingest, const WmIngestRecord* record) {
+    WmIngestSegment* segment = ingest->segment;
+
+    if (atomic_load_explicit(&segment->state, memory_order_acquire) != WM_SHM_STATE_ACTIVE) {
+        return WM_INGEST_CLOSED;
+    }
+
+    // 빈 칸을 찾아 위치를 CAS로 확보 (여러 프로세스가 동시에 제출 가능)
+    uint64_t pos = atomic_load_explicit(&segment->enqueue_pos, memory_order_relaxed);
+    WmIngestCell* cell;
+    for (;;) {
+        cell = &segment->cells[pos & (WM_INGEST_RING_SIZE - 1)];
+        uint64_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        int64_t diff = (int64_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&segment->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&segment->rejected, 1, memory_order_relaxed);
+            return WM_INGEST_FULL;
+        } else {
+            pos = atomic_load_explicit(&segment->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    // 칸을 차지: 데몬이 멈춘 생산자의 칸으로 보고 이미 건너뛰었으면 기록하지 않음
+    // (늦게 쓰면 다음 바퀴의 기록을 덮거나 seq를 되돌려 링이 멈춤)
+    uint64_t unowned = WM_INGEST_OWNER(0, pos);
+    if (!atomic_compare_exchange_strong_explicit(&cell->owner, &unowned, WM_INGEST_OWNER(ingest->pid, pos),
+                                                 memory_order_acq_rel, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&segment->rejected, 1, memory_order_relaxed);
+        return WM_INGEST_LATE;
+    }
+
+    cell->record = *record;
+    cell->record.producer_pid = ingest->pid;
+    if (cell->record.timestamp_us == 0) {
+        cell->record.timestamp_us = now_us();
+    }
+
+    // 기록 완료 표시: 데몬은 seq == pos+1인 칸만 읽음
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return WM_INGEST_OK;
+}
+
+int wm_ingest_submit(WmIngest* ingest, uint32_t kind, int32_t sensor_id, float value, float voltage) {
+    WmIngestRecord record = {
+        .kind = kind,
+        .sensor_id = sensor_id,
+        .value = value,
+        .voltage = voltage,
+        .timestamp_us = 0,
+        .quality = WM_QUALITY_VALID
+    };
+    return wm_ingest_submit_record(ingest, &record);
+}
@@ -0,0 +1,33 @@
+#ifndef WM_INGEST_H
+#define WM_INGEST_H
+
+// 보조 센서 프로그램용 수집 라이브러리 (libwm_ingest)
+// 각 프로그램이 SPI와 TCP 소켓을 따로 여는 대신, water_monitor 데몬이 소유한
+// 공유 메모리 링에 측정값을 넣으면 데몬이 모아서 필터링 후 업링크로 전송
+//
+// 사용 예:
+//   WmIngest* ingest = wm_ingest_open(NULL);
+//   wm_ingest_submit(ingest, WM_KIND_TEMPERATURE, 0, 24.5f, 1.23f);
+//   wm_ingest_close(ingest);
+
+#include <stdint.h>
+#include "wm_shm.h"
+
+#define WM_INGEST_OK 0
+#define WM_INGEST_FULL -1       // 링이 가득 참 (데몬이 비우지 못하는 중)
+#define WM_INGEST_CLOSED -2     // 데몬이 종료됨: wm_ingest_close 후 다시 열어야 함
+#define WM_INGEST_LATE -3       // 칸을 확보한 뒤 기록이 늦어 데몬이 건너뜀 (기록되지 않음, 다시 제출 가능)
+
+typedef struct WmIngest WmIngest;
+
+// 수집 링 열기 (name이 NULL이면 WM_INGEST_SHM_NAME), 데몬이 없거나 버전이 다르면 NULL
+WmIngest* wm_ingest_open(const char* name);
+void wm_ingest_close(WmIngest* ingest);
+
+// 측정값 제출 (현재 시각으로 기록), 블로킹하지 않음
+int wm_ingest_submit(WmIngest* ingest, uint32_t kind, int32_t sensor_id, float value, float voltage);
+
+// 시각/품질을 직접 지정한 기록 제출 (timestamp_us가 0이면 현재 시각)
+int wm_ingest_submit_record(WmIngest* ingest, const WmIngestRecord* record);
+
+#endif
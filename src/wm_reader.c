@@ -0,0 +1,249 @@
+#include "wm_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// 대기 중에도 이 간격마다 데몬이 살아 있는지 확인 (죽은 데몬의 세그먼트는 ACTIVE로 남음)
+#define WM_READER_LIVENESS_MS 1000
+// 쓰는 중인 칸을 이만큼 다시 읽어도 끝나지 않으면 데몬이 살아 있는지 확인하고 1ms씩 쉼
+// 그렇게 WM_READER_RETRY_LIMIT번이 지나도 그대로면 포기 (데몬이 쓰는 도중 죽으면 seq가 홀수로 남음)
+#define WM_READER_SPIN_LIMIT 1000
+#define WM_READER_RETRY_LIMIT 100
+
+struct WmReader {
+    const WmShmSegment* segment;
+    size_t size;
+    char name[64];
+    dev_t dev;          // 연 세그먼트 파일: 데몬이 재시작해 같은 이름으로 새로 만들었는지 비교
+    ino_t ino;
+};
+
+WmReader* wm_reader_open(const char* name) {
+    if (!name) {
+        name = WM_SHM_NAME;
+    }
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WmShmSegment)) {
+        close(fd);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    void* addr = mmap(NULL, sizeof(WmShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    const WmShmSegment* segment = addr;
+    if (atomic_load_explicit(&segment->magic, memory_order_acquire) != WM_SHM_MAGIC ||
+        segment->version != WM_SHM_VERSION ||
+        segment->segment_size != sizeof(WmShmSegment)) {
+        munmap(addr, sizeof(WmShmSegment));
+        errno = EPROTO;
+        return NULL;
+    }
+
+    WmReader* reader = malloc(sizeof(WmReader));
+    if (!reader) {
+        munmap(addr, sizeof(WmShmSegment));
+        return NULL;
+    }
+    reader->segment = segment;
+    reader->size = sizeof(WmShmSegment);
+    strncpy(reader->name, name, sizeof(reader->name) - 1);
+    reader->name[sizeof(reader->name) - 1] = '\0';
+    reader->dev = st.st_dev;
+    reader->ino = st.st_ino;
+    return reader;
+}
+
+void wm_reader_close(WmReader* reader) {
+    if (!reader) {
+        return;
+    }
+    munmap((void*)reader->segment, reader->size);
+    free(reader);
+}
+
+int wm_reader_channel_count(const WmReader* reader) {
+    return (int)reader->segment->num_channels;
+}
+
+int wm_reader_find_channel(const WmReader* reader, const char* name) {
+    for (uint32_t i = 0; i < reader->segment->num_channels && i < WM_SHM_MAX_CHANNELS; i++) {
+        if (strncmp(reader->segment->channels[i].name, name, WM_SHM_CHANNEL_NAME_LEN) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+// 데몬이 CLOSED로 표시하지 못하고 죽었거나 재시작해 세그먼트를 새로 만들었으면 true
+// (이 매핑은 더 이상 갱신되지 않음)
+static bool segment_abandoned(const WmReader* reader) {
+    pid_t writer = reader->segment->writer_pid;
+    if (writer > 0 && kill(writer, 0) < 0 && errno == ESRCH) {
+        return true;
+    }
+
+    int fd = shm_open(reader->name, O_RDONLY, 0);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+    struct stat st;
+    bool replaced = fstat(fd, &st) == 0 && (st.st_dev != reader->dev || st.st_ino != reader->ino);
+    close(fd);
+    return replaced;
+}
+
+// seqlock으로 보호된 src를 out에 일관되게 복사하고 복사한 때의 seq를 반환 (0이면 아직 게시 전)
+// 쓰는 도중 데몬이 죽었거나 끝내 쓰기가 끝나지 않으면 false
+static bool read_seqlock(const WmReader* reader, const _Atomic uint32_t* seq, const void* src, void* out,
+                         size_t size, uint32_t* seq_out) {
+    uint32_t seq_before, seq_after;
+
+    for (int retry = 0; retry < WM_READER_RETRY_LIMIT; retry++) {
+        for (int spin = 0; spin < WM_READER_SPIN_LIMIT; spin++) {
+            seq_before = atomic_load_explicit(seq, memory_order_acquire);
+            if (seq_before & 1) {
+                continue;
+            }
+            memcpy(out, src, size);
+            atomic_thread_fence(memory_order_acquire);
+            seq_after = atomic_load_explicit(seq, memory_order_relaxed);
+            if (seq_before == seq_after) {
+                *seq_out = seq_before;
+                return true;
+            }
+        }
+        if (segment_abandoned(reader)) {
+            return false;
+        }
+        struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000L };
+        nanosleep(&pause, NULL);
+    }
+    return false;
+}
+
+bool wm_reader_get(const WmReader* reader, int channel, WmSample* out) {
+    if (channel < 0 || channel >= WM_SHM_MAX_CHANNELS) {
+        return false;
+    }
+
+    const WmChannelSlot* slot = &reader->segment->channels[channel];
+    uint32_t seq;
+
+    return read_seqlock(reader, &slot->seq, &slot->sample, out, sizeof(*out), &seq) && seq != 0;
+}
+
+uint32_t wm_reader_update_seq(const WmReader* reader) {
+    return atomic_load_explicit(&reader->segment->update_seq, memory_order_acquire);
+}
+
+static long remaining_ms(const struct timespec* deadline) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+}
+
+int64_t wm_reader_sample_age_ms(const WmSample* sample) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t now_us = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    return (now_us - sample->timestamp_us) / 1000;
+}
+
+int wm_reader_wait(WmReader* reader, uint32_t last_seq, int timeout_ms) {
+    const WmShmSegment* segment = reader->segment;
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    for (;;) {
+        if (atomic_load_explicit(&segment->state, memory_order_acquire) != WM_SHM_STATE_ACTIVE) {
+            return WM_WAIT_CLOSED;
+        }
+        if (atomic_load_explicit(&segment->update_seq, memory_order_acquire) != last_seq) {
+            return WM_WAIT_UPDATED;
+        }
+
+        long slice = WM_READER_LIVENESS_MS;
+        if (timeout_ms >= 0) {
+            long left = remaining_ms(&deadline);
+            if (left <= 0) {
+                return WM_WAIT_TIMEOUT;
+            }
+            if (left < slice) {
+                slice = left;
+            }
+        }
+        struct timespec timeout = { .tv_sec = slice / 1000, .tv_nsec = (slice % 1000) * 1000000L };
+
+        // update_seq가 아직 last_seq일 때만 잠듦 (그 사이 갱신되면 EAGAIN으로 즉시 반환)
+        // 갱신 없이 시간이 지나면 데몬이 세그먼트를 버렸는지 확인
+        if (syscall(SYS_futex, &segment->update_seq, FUTEX_WAIT, last_seq, &timeout, NULL, 0) < 0 &&
+            errno == ETIMEDOUT && segment_abandoned(reader)) {
+            return WM_WAIT_CLOSED;
+        }
+    }
+}
+
+size_t wm_reader_history(const WmReader* reader, int channel, WmSample* out, size_t max) {
+    const WmShmSegment* segment = reader->segment;
+    uint64_t head = atomic_load_explicit(&segment->history_head, memory_order_acquire);
+    uint64_t oldest = head > WM_SHM_HISTORY_SIZE ? head - WM_SHM_HISTORY_SIZE : 0;
+    size_t count = 0;
+
+    // 최신 항목부터 거꾸로 모은 뒤 오래된 순으로 정렬
+    for (uint64_t pos = head; pos > oldest && count < max; pos--) {
+        const WmHistoryEntry* entry = &segment->history[(pos - 1) & (WM_SHM_HISTORY_SIZE - 1)];
+        uint64_t expected = (pos - 1) * 2 + 2;
+        WmSample sample;
+
+        if (atomic_load_explicit(&entry->seq, memory_order_acquire) != expected) {
+            continue;   // 작성 중이거나 이미 덮어써짐
+        }
+        sample = entry->sample;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->seq, memory_order_relaxed) != expected) {
+            continue;
+        }
+
+        if (channel < 0 || sample.channel == channel) {
+            out[max - 1 - count] = sample;
+            count++;
+        }
+    }
+
+    if (count < max) {
+        memmove(out, out + (max - count), count * sizeof(WmSample));
+    }
+    return count;
+}
+
+bool wm_reader_uplink_stats(const WmReader* reader, WmUplinkStats* out) {
+    const WmShmSegment* segment = reader->segment;
+    uint32_t seq;
+
+    return read_seqlock(reader, &segment->uplink_seq, &segment->uplink, out, sizeof(*out), &seq) && seq != 0;
+}
@@ -0,0 +1,54 @@
+#ifndef WM_READER_H
+#define WM_READER_H
+
+// water_monitor 공유 메모리 리더 라이브러리 (libwm_reader)
+// 읽기 경로는 시스템 콜 없이 공유 메모리만 접근, 대기만 futex 사용
+//
+// 사용 예:
+//   WmReader* reader = wm_reader_open(NULL);
+//   int ph = wm_reader_find_channel(reader, "ph");
+//   uint32_t seq = wm_reader_update_seq(reader);
+//   while (wm_reader_wait(reader, seq, 5000) >= 0) {
+//       seq = wm_reader_update_seq(reader);
+//       wm_reader_get(reader, ph, &sample);
+//   }
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "wm_shm.h"
+
+#define WM_WAIT_UPDATED 1
+#define WM_WAIT_TIMEOUT 0
+#define WM_WAIT_CLOSED -1   // 데몬이 종료됐거나 죽었거나 세그먼트를 새로 만듦: wm_reader_close 후 다시 열어야 함
+
+typedef struct WmReader WmReader;
+
+// 세그먼트 열기 (name이 NULL이면 WM_SHM_NAME), 버전이 맞지 않으면 NULL
+WmReader* wm_reader_open(const char* name);
+void wm_reader_close(WmReader* reader);
+
+// 채널 이름으로 번호 찾기 (없으면 -1)
+int wm_reader_find_channel(const WmReader* reader, const char* name);
+int wm_reader_channel_count(const WmReader* reader);
+
+// 채널 최신값 (아직 측정값이 없거나, 데몬이 값을 쓰는 도중 죽어 읽을 수 없으면 false)
+bool wm_reader_get(const WmReader* reader, int channel, WmSample* out);
+
+// 샘플이 측정된 뒤 지난 시간 (제어에 쓰기 전에 확인: 센서 스레드가 멈추면 최신값이 그대로 남음)
+int64_t wm_reader_sample_age_ms(const WmSample* sample);
+
+// 현재 갱신 번호 (wm_reader_wait에 넘겨 그 이후의 갱신을 기다림)
+uint32_t wm_reader_update_seq(const WmReader* reader);
+
+// last_seq 이후 새 샘플이 올 때까지 대기 (timeout_ms < 0이면 무한 대기)
+// 대기 중 데몬이 죽거나 재시작한 것을 알아채면 WM_WAIT_CLOSED
+int wm_reader_wait(WmReader* reader, uint32_t last_seq, int timeout_ms);
+
+// 데몬 업링크 큐 상태 (아직 게시된 적이 없거나 wm_reader_get과 같이 읽을 수 없으면 false)
+bool wm_reader_uplink_stats(const WmReader* reader, WmUplinkStats* out);
+
+// 최근 이력을 오래된 순으로 최대 max개 복사 (channel < 0이면 전체 채널), 복사한 개수 반환
+size_t wm_reader_history(const WmReader* reader, int channel, WmSample* out, size_t max);
+
+#endif
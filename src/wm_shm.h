@@ -0,0 +1,138 @@
+#ifndef WM_SHM_H
+#define WM_SHM_H
+
+// water_monitor 데몬과 같은 보드의 다른 프로세스가 공유하는 메모리 레이아웃
+// 데몬 내부 헤더에 의존하지 않도록 독립적으로 유지 (리더/수집 라이브러리와 공용)
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#define WM_SHM_NAME "/water_monitor"    // /dev/shm/water_monitor
+#define WM_SHM_MAGIC 0x4E4F4D57u         // "WMON"
+#define WM_SHM_VERSION 2                 // 레이아웃이 바뀌면 증가
+
+#define WM_SHM_MAX_CHANNELS 16
+#define WM_SHM_HISTORY_SIZE 256          // 2의 거듭제곱
+#define WM_SHM_CHANNEL_NAME_LEN 16
+
+// 샘플 품질 플래그 (데몬의 READING_QUALITY_*와 같은 값)
+#define WM_QUALITY_VALID        (1u << 0)
+#define WM_QUALITY_LOW_SAMPLES  (1u << 1)
+#define WM_QUALITY_OUT_OF_RANGE (1u << 2)
+
+// 센서 종류 (데몬의 SensorKind와 같은 값)
+#define WM_KIND_WATER_LEVEL  0
+#define WM_KIND_PH           1
+#define WM_KIND_TEMPERATURE  2
+#define WM_KIND_CONDUCTIVITY 3   // TDS 센서 포함
+#define WM_KIND_ILLUMINANCE  4
+#define WM_KIND_COUNT        5
+
+#define WM_SHM_STATE_ACTIVE 1
+#define WM_SHM_STATE_CLOSED 2            // 데몬 종료: 리더는 다시 열어야 함
+
+// 측정값 한 건 (Reading과 같은 내용을 고정 레이아웃으로)
+typedef struct {
+    int32_t channel;
+    float value;
+    float voltage;
+    uint32_t quality;
+    int64_t timestamp_us;
+} WmSample;
+
+// 채널별 최신값 슬롯 (seqlock: seq가 홀수면 작성 중)
+typedef struct {
+    _Atomic uint32_t seq;
+    uint32_t reserved;
+    WmSample sample;
+    char name[WM_SHM_CHANNEL_NAME_LEN];
+} __attribute__((aligned(64))) WmChannelSlot;
+
+// 이력 링 항목: pos번째 샘플이면 작성 중 seq = pos*2+1, 완료 후 pos*2+2
+typedef struct {
+    _Atomic uint64_t seq;
+    WmSample sample;
+} WmHistoryEntry;
+
+// 데몬 업링크 큐 상태 (업링크 스레드가 주기마다 갱신, 카운터는 데몬 시작 후 누적)
+typedef struct {
+    uint32_t queue_depth;
+    uint32_t queue_capacity;
+    uint64_t enqueued;
+    uint64_t dropped;               // 큐가 가득 차 버려진 측정값
+    uint64_t spilled;               // 큐 대신 디스크 스풀로 간 측정값
+    uint64_t coalesced;             // 큐가 가득 찬 동안 더 새 값으로 덮인 측정값
+    uint64_t spool_pending;         // 스풀에 남아 있는 측정값
+} WmUplinkStats;
+
+typedef struct {
+    // 고정 헤더: magic은 초기화가 끝난 뒤 마지막에 기록
+    _Atomic uint32_t magic;
+    uint32_t version;
+    uint32_t segment_size;
+    uint32_t num_channels;
+    uint32_t history_size;
+    int32_t writer_pid;
+    _Atomic uint32_t state;
+
+    // 새 샘플마다 증가하는 futex 워드 (리더는 읽기 전용 매핑으로 FUTEX_WAIT)
+    _Atomic uint32_t update_seq;
+
+    // 지금까지 기록된 이력 샘플 수 (다음 쓸 위치)
+    _Atomic uint64_t history_head;
+
+    // 업링크 상태 (seqlock: seq가 홀수면 작성 중)
+    _Atomic uint32_t uplink_seq;
+    WmUplinkStats uplink;
+
+    WmChannelSlot channels[WM_SHM_MAX_CHANNELS];
+    WmHistoryEntry history[WM_SHM_HISTORY_SIZE];
+} WmShmSegment;
+
+
+// ---- 보조 센서 프로그램 -> 데몬 수집 링 (libwm_ingest) ----
+
+#define WM_INGEST_SHM_NAME "/water_monitor_ingest"
+#define WM_INGEST_MAGIC 0x474E4957u      // "WING"
+#define WM_INGEST_VERSION 2
+#define WM_INGEST_RING_SIZE 1024         // 2의 거듭제곱
+
+typedef struct {
+    uint32_t kind;                       // WM_KIND_*
+    int32_t sensor_id;
+    float value;
+    float voltage;
+    int64_t timestamp_us;
+    uint32_t quality;                    // WM_QUALITY_*
+    int32_t producer_pid;
+} WmIngestRecord;
+
+// 다중 생산자 링 칸: seq == pos면 비어 있음, pos+1이면 pos번째 기록이 준비됨
+// owner: 상위 32비트는 기록 중인 생산자 pid (0이면 아직 없음), 하위 32비트는 pos의 하위 32비트
+// (생산자는 위치를 확보한 뒤 owner를 CAS로 차지해야 기록함: 데몬이 그 칸을 건너뛰었으면 CAS가 실패)
+typedef struct {
+    _Atomic uint64_t seq;
+    _Atomic uint64_t owner;
+    WmIngestRecord record;
+} WmIngestCell;
+
+#define WM_INGEST_OWNER(pid, pos) (((uint64_t)(uint32_t)(pid) << 32) | (uint32_t)(pos))
+#define WM_INGEST_OWNER_PID(owner) ((int32_t)((owner) >> 32))
+
+typedef struct {
+    _Atomic uint32_t magic;
+    uint32_t version;
+    uint32_t segment_size;
+    uint32_t ring_size;
+    _Atomic uint32_t state;
+    uint32_t reserved;
+    _Atomic uint64_t rejected;           // 링이 가득 차 버려진 기록 수
+
+    // 생산자 간 경쟁하는 위치와 데몬만 쓰는 위치를 다른 캐시 라인에 둠
+    _Atomic uint64_t enqueue_pos __attribute__((aligned(64)));
+    _Atomic uint64_t dequeue_pos __attribute__((aligned(64)));
+
+    WmIngestCell cells[WM_INGEST_RING_SIZE] __attribute__((aligned(64)));
+} WmIngestSegment;
+
+#endif